@@ -0,0 +1,183 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+// Compares the ways of splitting CSV text into fields: the original
+// std::getline reader, per-line and per-field memchr searches, and the
+// vectorized DelimiterScanner used by CmdInterpreter::load().
+//
+// Usage: scan_benchmark [rows] [columns]
+//
+
+#include "DelimiterScanner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    /**
+     * @brief Fields found by a scanner, compared across scanners.
+     */
+    struct Totals {
+        size_t fields = 0; ///< Number of non-empty fields
+        size_t bytes = 0;  ///< Total length of the fields
+        int64_t rows = 0;  ///< Number of lines
+
+        bool operator==(const Totals& other) const {
+            return fields == other.fields && bytes == other.bytes && rows == other.rows;
+        }
+    };
+
+    /**
+     * @brief Builds a wide sheet of numbers, formulas and empty fields.
+     */
+    std::string generate(int64_t rows, int64_t cols) {
+        std::string text;
+        for (int64_t r = 0; r < rows; ++r) {
+            for (int64_t c = 0; c < cols; ++c) {
+                if (c > 0) {
+                    text += ';';
+                }
+                if (c == 0) {
+                    text += std::to_string(r);
+                } else if (c % 10 != 7) {
+                    text += "R[0]C[-1] * 3 + 1";
+                }
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+    /// The loader before memory mapping: one stream read per line and per field
+    Totals scanGetline(const std::string& text) {
+        Totals totals;
+        std::istringstream in(text);
+        std::string line;
+
+        while (std::getline(in, line)) {
+            std::stringstream ss(line);
+            std::string field;
+            while (std::getline(ss, field, ';')) {
+                if (!field.empty()) {
+                    ++totals.fields;
+                    totals.bytes += field.size();
+                }
+            }
+            ++totals.rows;
+        }
+        return totals;
+    }
+
+    /// Searches the end of every line, then every field in it, with memchr
+    Totals scanMemchr(std::string_view text) {
+        Totals totals;
+        const char* position = text.data();
+        const char* const end = position + text.size();
+
+        while (position < end) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(position, '\n', end - position));
+            if (lineEnd == nullptr) {
+                lineEnd = end;
+            }
+
+            while (position < lineEnd) {
+                const char* fieldEnd = static_cast<const char*>(std::memchr(position, ';', lineEnd - position));
+                if (fieldEnd == nullptr) {
+                    fieldEnd = lineEnd;
+                }
+                if (fieldEnd != position) {
+                    ++totals.fields;
+                    totals.bytes += static_cast<size_t>(fieldEnd - position);
+                }
+                position = fieldEnd + 1;
+            }
+
+            position = lineEnd + 1;
+            ++totals.rows;
+        }
+        return totals;
+    }
+
+    /// Lists all separators of a window at once, as CmdInterpreter::forEachField() does
+    Totals scanVector(std::string_view text) {
+        constexpr size_t WINDOW = 1 << 16;
+        Totals totals;
+        std::vector<uint32_t> separators(std::min(text.size(), WINDOW));
+        size_t fieldStart = 0;
+
+        for (size_t window = 0; window < text.size(); window += WINDOW) {
+            const size_t length = std::min(WINDOW, text.size() - window);
+            const size_t count = DelimiterScanner::find(text.data() + window, length, separators.data());
+
+            for (size_t k = 0; k < count; ++k) {
+                const size_t at = window + separators[k];
+                if (at != fieldStart) {
+                    ++totals.fields;
+                    totals.bytes += at - fieldStart;
+                }
+                if (text[at] == '\n') {
+                    ++totals.rows;
+                }
+                fieldStart = at + 1;
+            }
+        }
+
+        if (fieldStart < text.size()) {
+            ++totals.fields;
+            totals.bytes += text.size() - fieldStart;
+        }
+        if (!text.empty() && text.back() != '\n') {
+            ++totals.rows;
+        }
+        return totals;
+    }
+
+    /**
+     * @brief Runs a scanner a few times and reports its best throughput.
+     */
+    template <typename Scanner>
+    Totals measure(const char* name, const std::string& text, Scanner&& scan) {
+        constexpr int RUNS = 3;
+        double best = 1e30;
+        Totals totals;
+
+        for (int run = 0; run < RUNS; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            totals = scan(text);
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+
+        std::printf("%-10s %8.1f MB/s  %8.3f s  (%zu fields)\n",
+                    name, static_cast<double>(text.size()) / 1e6 / best, best, totals.fields);
+        return totals;
+    }
+}
+
+int main(int argc, char** argv) {
+    const int64_t rows = argc > 1 ? std::atoll(argv[1]) : 100000;
+    const int64_t cols = argc > 2 ? std::atoll(argv[2]) : 50;
+
+    const std::string text = generate(rows, cols);
+    std::printf("%lld x %lld sheet, %.1f MB, scanner width %zu bytes\n",
+                static_cast<long long>(rows), static_cast<long long>(cols),
+                static_cast<double>(text.size()) / 1e6, DelimiterScanner::width());
+
+    const Totals getline = measure("getline", text, scanGetline);
+    const Totals memchr = measure("memchr", text, [](const std::string& t) { return scanMemchr(t); });
+    const Totals vector = measure("vector", text, [](const std::string& t) { return scanVector(t); });
+
+    if (!(getline == memchr) || !(getline == vector)) {
+        std::printf("Scanners disagree\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,210 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+// Catch2 benchmarks of the main spreadsheet workloads on synthetic
+// sheets of 10^3 to 10^7 cells. Sheets above BENCHMARK_MAX_CELLS (an
+// environment variable, 10^7 by default) are skipped.
+//
+// Usage: benchmarks [--benchmark-samples N] [--reporter xml|JSON] [tags]
+//
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "../src/CmdInterpreter.h"
+#include "../src/Evaluator.h"
+#include "../src/ExpressionParser.h"
+#include "../src/Table.h"
+#include "../src/Tokenizer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace {
+    const int64_t SHEET_COLS = 10; ///< Width of the grid sheets
+
+    /**
+     * @brief Sheet sizes in cells, from 10^3 up to BENCHMARK_MAX_CELLS.
+     */
+    std::vector<int64_t> sizes() {
+        int64_t limit = 10000000;
+        if (const char* max = std::getenv("BENCHMARK_MAX_CELLS")) {
+            limit = std::atoll(max);
+        }
+
+        std::vector<int64_t> result;
+        for (int64_t cells = 1000; cells <= limit && cells <= 10000000; cells *= 10) {
+            result.push_back(cells);
+        }
+        return result;
+    }
+
+    std::string name(const char* workload, int64_t cells) {
+        return std::string(workload) + " " + std::to_string(cells) + " cells";
+    }
+
+    /**
+     * @brief Fills a table with SHEET_COLS wide rows: a constant followed by
+     * formulas on the cell to their left.
+     */
+    void buildGrid(Table& table, int64_t cells) {
+        const int64_t rows = cells / SHEET_COLS;
+        table.reserve(static_cast<size_t>(cells));
+        for (int64_t row = 0; row < rows; ++row) {
+            table.insert({row, 0}, std::to_string(row % 100));
+            for (int64_t col = 1; col < SHEET_COLS; ++col) {
+                table.insert({row, col}, "R[0]C[-1] * 3 + 1");
+            }
+        }
+    }
+
+    /// Discards everything written to it
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override {
+            return c;
+        }
+
+        std::streamsize xsputn(const char*, std::streamsize count) override {
+            return count;
+        }
+    };
+}
+
+TEST_CASE("Tokenization", "[benchmark][tokenizer]") {
+    for (int64_t cells : sizes()) {
+        Table table;
+        buildGrid(table, cells);
+        const CellStore& store = table.getCells();
+
+        BENCHMARK(name("tokenize", cells)) {
+            size_t tokens = 0;
+            for (CellStore::CellId id = 0; id < store.size(); ++id) {
+                Tokenizer tokenizer(store.expression(id));
+                while (tokenizer.next().type != TokenType::End) {
+                    ++tokens;
+                }
+            }
+            return tokens;
+        };
+    }
+}
+
+TEST_CASE("Single expression evaluation", "[benchmark][evaluation]") {
+    for (int64_t cells : sizes()) {
+        Table table;
+        buildGrid(table, cells);
+        Evaluator::recalculate(table);
+
+        // One formula over the whole sheet, compiled and run per iteration
+        const std::string bottom = "R" + std::to_string(cells / SHEET_COLS - 1) + "C" + std::to_string(SHEET_COLS - 1);
+        const std::string expression = "sum(R0C0:" + bottom + ") / count(R0C0:" + bottom + ") + max(R0C0:" + bottom + ")";
+        const Coordinates outside(cells, 0);
+
+        BENCHMARK(name("evaluate", cells)) {
+            return ExpressionParser::evaluate(expression, table, outside);
+        };
+    }
+}
+
+TEST_CASE("Long reference chain", "[benchmark][evaluation]") {
+    for (int64_t cells : sizes()) {
+        Table table;
+        table.reserve(static_cast<size_t>(cells));
+        table.insert({0, 0}, "1");
+        for (int64_t row = 1; row < cells; ++row) {
+            table.insert({row, 0}, "R[-1]C[0] + 1");
+        }
+        Evaluator::recalculate(table);
+
+        // Changing the head invalidates and recomputes the whole chain
+        int64_t head = 1;
+        BENCHMARK(name("chain", cells)) {
+            table.set({0, 0}, std::to_string(++head % 7));
+            Evaluator::recalculate(table);
+            return table.getCachedValue({cells - 1, 0});
+        };
+    }
+}
+
+TEST_CASE("Wide fan-in", "[benchmark][evaluation]") {
+    for (int64_t cells : sizes()) {
+        Table table;
+        table.reserve(static_cast<size_t>(cells));
+        for (int64_t row = 0; row < cells - 1; ++row) {
+            table.insert({row, 0}, std::to_string(row % 100));
+        }
+        table.insert({0, 1}, "sum(R0C0:R" + std::to_string(cells - 2) + "C0)");
+        Evaluator::recalculate(table);
+
+        // One changed input makes the sum read all of them again
+        int64_t input = 0;
+        BENCHMARK(name("fan-in", cells)) {
+            table.set({cells / 2, 0}, std::to_string(++input % 100));
+            Evaluator::recalculate(table);
+            return table.getCachedValue({0, 1});
+        };
+    }
+}
+
+TEST_CASE("Full-sheet recalculation", "[benchmark][evaluation]") {
+    for (int64_t cells : sizes()) {
+        Table table;
+        buildGrid(table, cells);
+
+        BENCHMARK(name("recalculate", cells)) {
+            table.invalidateEvalState();
+            Evaluator::recalculate(table);
+            return table.getCachedValue({0, SHEET_COLS - 1});
+        };
+    }
+}
+
+TEST_CASE("CSV load and save", "[benchmark][csv]") {
+    const std::string fileName = "benchmark_sheet.csv";
+
+    for (int64_t cells : sizes()) {
+        {
+            Table table;
+            buildGrid(table, cells);
+
+            BENCHMARK(name("save", cells)) {
+                CmdInterpreter::save(fileName, table);
+            };
+        }
+
+        BENCHMARK(name("load", cells)) {
+            Table table;
+            CmdInterpreter::load(fileName, table);
+            return table.getCells().size();
+        };
+    }
+
+    std::remove(fileName.c_str());
+}
+
+TEST_CASE("Area printing", "[benchmark][print]") {
+    for (int64_t cells : sizes()) {
+        Table table;
+        buildGrid(table, cells);
+        Evaluator::recalculate(table);
+
+        // Only the printing goes to the sink; Catch2 reports to std::cout as well
+        NullBuffer sink;
+        auto print = [&](void (*printer)(const Table&)) {
+            std::streambuf* original = std::cout.rdbuf(&sink);
+            printer(table);
+            std::cout.rdbuf(original);
+        };
+
+        BENCHMARK(name("print values", cells)) {
+            print(CmdInterpreter::printAllValues);
+        };
+        BENCHMARK(name("print expressions", cells)) {
+            print(CmdInterpreter::printAllExpressions);
+        };
+    }
+}
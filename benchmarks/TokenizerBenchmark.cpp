@@ -0,0 +1,107 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+// Counts the heap allocations made while tokenizing and compiling
+// typical formulas. Every operator new in the process goes through the
+// counting replacement below, so the numbers include the allocations of
+// the tokens themselves and of the programs the parser emits.
+//
+// Usage: tokenizer_benchmark [repetitions]
+//
+
+#include "ExpressionParser.h"
+#include "Tokenizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+    size_t allocations = 0; ///< Calls of operator new since the start of the process
+
+    /**
+     * @brief Allocation count and time of one measured loop.
+     */
+    struct Sample {
+        size_t allocations = 0; ///< Allocations made by the loop
+        size_t tokens = 0;      ///< Tokens produced (or formulas compiled)
+        double seconds = 0;     ///< Wall time of the loop
+    };
+
+    /// Formulas as they appear in generated and hand-written sheets
+    const std::vector<std::string> FORMULAS = {
+        "42",
+        "R[0]C[-1] * 3 + 1",
+        "R0C0 + R1C0 + R2C0 + R3C0",
+        "sum(R0C0:R[-1]C[0]) / count(R0C0:R[-1]C[0])",
+        "if(R[-1]C[0] > 100 and not R[-1]C[-1] == 0, R[-1]C[0] % 7, -1)",
+        "max(R0C0:R99C9) - min(R0C0:R99C9) != avg(R0C0:R99C9) or R5C5 < 2"
+    };
+
+    template<typename Body>
+    Sample measure(size_t repetitions, Body body) {
+        Sample sample;
+        const size_t before = allocations;
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < repetitions; ++i) {
+            for (const std::string& formula : FORMULAS) {
+                sample.tokens += body(formula);
+            }
+        }
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        sample.seconds = elapsed.count();
+        sample.allocations = allocations - before;
+        return sample;
+    }
+
+    void report(const char* name, const char* unit, const Sample& sample) {
+        std::printf("%-10s %10zu %-8s %10zu allocations  %6.2f per %s  %8.1f ns per %s\n",
+                    name, sample.tokens, unit, sample.allocations,
+                    static_cast<double>(sample.allocations) / static_cast<double>(sample.tokens), unit,
+                    sample.seconds * 1e9 / static_cast<double>(sample.tokens), unit);
+    }
+}
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* memory = std::malloc(std::max<size_t>(size, 1))) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+int main(int argc, char** argv) {
+    const size_t repetitions = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 100000;
+
+    const Sample tokenize = measure(repetitions, [](const std::string& formula) {
+        Tokenizer tokenizer(formula);
+        size_t count = 1;
+        while (tokenizer.next().type != TokenType::End) {
+            ++count;
+        }
+        return count;
+    });
+
+    const Sample compile = measure(repetitions, [](const std::string& formula) {
+        const Program program = ExpressionParser::compile(formula);
+        return program.code.empty() ? 0 : 1;
+    });
+
+    report("tokenize", "token", tokenize);
+    report("compile", "formula", compile);
+    return 0;
+}
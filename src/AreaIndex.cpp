@@ -0,0 +1,104 @@
+//
+// Created by Petya Licheva on 10/18/2026.
+//
+
+#include "AreaIndex.h"
+#include <algorithm>
+
+int AreaIndex::levelOf(const Area& area) {
+    // Differences of the corners as unsigned values, so the widest areas do not overflow
+    const uint64_t rows = static_cast<uint64_t>(area.maxRow()) - static_cast<uint64_t>(area.minRow());
+    const uint64_t cols = static_cast<uint64_t>(area.maxCol()) - static_cast<uint64_t>(area.minCol());
+
+    int level = 0;
+    while (level < LEVELS - 1 && ((rows >> (ROW_BITS + level)) != 0 || (cols >> (COL_BITS + level)) != 0)) {
+        ++level;
+    }
+    return level;
+}
+
+void AreaIndex::add(const Area& area, const Coordinates& dependent) {
+    uint32_t e = freeEntries;
+    if (e != NONE) {
+        freeEntries = entries[e].next;
+    } else {
+        e = static_cast<uint32_t>(entries.size());
+        entries.emplace_back();
+    }
+
+    // New entries go to the front of the dependent's list
+    uint32_t* head = byDependent.tryEmplace(dependent, NONE).first;
+    Entry& entry = entries[e];
+    entry.area = area;
+    entry.dependent = dependent;
+    entry.next = *head;
+    entry.level = levelOf(area);
+    *head = e;
+
+    forEachBlock(entry, [&](const Coordinates& block) {
+        auto [bucket, added] = blocks[entry.level].tryEmplace(block, 0);
+        if (added) {
+            if (!freeBuckets.empty()) {
+                *bucket = freeBuckets.back();
+                freeBuckets.pop_back();
+            } else {
+                *bucket = static_cast<uint32_t>(buckets.size());
+                buckets.emplace_back();
+            }
+        }
+        buckets[*bucket].push_back(e);
+    });
+
+    ++levelSizes[entry.level];
+    usedLevels |= uint64_t{1} << entry.level;
+    ++count;
+}
+
+void AreaIndex::remove(const Coordinates& dependent) {
+    const uint32_t* head = byDependent.find(dependent);
+    if (head == nullptr) {
+        return;
+    }
+
+    uint32_t e = *head;
+    byDependent.erase(dependent);
+
+    while (e != NONE) {
+        Entry& entry = entries[e];
+        forEachBlock(entry, [&](const Coordinates& block) {
+            uint32_t* bucket = blocks[entry.level].find(block);
+            std::vector<uint32_t>& listed = buckets[*bucket];
+            *std::find(listed.begin(), listed.end(), e) = listed.back();
+            listed.pop_back();
+
+            if (listed.empty()) {
+                freeBuckets.push_back(*bucket);
+                blocks[entry.level].erase(block);
+            }
+        });
+
+        if (--levelSizes[entry.level] == 0) {
+            usedLevels &= ~(uint64_t{1} << entry.level);
+        }
+        --count;
+
+        const uint32_t next = entry.next;
+        entry.next = freeEntries;
+        freeEntries = e;
+        e = next;
+    }
+}
+
+void AreaIndex::clear() {
+    std::vector<Entry>().swap(entries);
+    freeEntries = NONE;
+    count = 0;
+    byDependent = CoordinateMap<uint32_t>();
+    for (CoordinateMap<uint32_t>& level : blocks) {
+        level = CoordinateMap<uint32_t>();
+    }
+    std::vector<std::vector<uint32_t>>().swap(buckets);
+    std::vector<uint32_t>().swap(freeBuckets);
+    levelSizes.fill(0);
+    usedLevels = 0;
+}
@@ -0,0 +1,150 @@
+//
+// Created by Petya Licheva on 10/18/2026.
+//
+
+#ifndef AREA_INDEX_H
+#define AREA_INDEX_H
+
+#include "CoordinateMap.h"
+#include "Types.h"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Spatial index of aggregated areas and the cells that aggregate them.
+ *
+ * The index answers "which cells aggregate an area that contains this
+ * position" without testing every area. Areas are kept in a hierarchy of
+ * grids: level L divides the sheet into blocks of (16 << L) x (64 << L)
+ * positions, the tile blocks of CellStore at level 0. An area is stored
+ * at the lowest level whose blocks are at least as large as the area, so
+ * it overlaps at most 2 x 2 blocks and is listed in each of them. A point
+ * query looks up the one block that holds the position on every level
+ * that has areas, and tests only the areas listed there.
+ *
+ * Every dependent cell also has a list of its own entries, so removing
+ * the areas of a cell touches only those entries.
+ */
+class AreaIndex {
+    static constexpr int ROW_BITS = 4;  ///< log2 of the block height at level 0
+    static constexpr int COL_BITS = 6;  ///< log2 of the block width at level 0
+    static constexpr int LEVELS = 58;   ///< Levels; the blocks of the last one cover any area in a few blocks
+    static constexpr uint32_t NONE = UINT32_MAX; ///< End of a list
+
+    /**
+     * @brief A registered area.
+     */
+    struct Entry {
+        Area area{Coordinates()}; ///< Aggregated area
+        Coordinates dependent;    ///< Cell that aggregates it
+        uint32_t next = NONE;     ///< Next entry of the same dependent (or of the free list)
+        int level = 0;            ///< Grid level the area is stored at
+    };
+
+    std::vector<Entry> entries;                           ///< Entries by index
+    uint32_t freeEntries = NONE;                          ///< First entry of the free list
+    size_t count = 0;                                     ///< Number of registered areas
+    CoordinateMap<uint32_t> byDependent;                  ///< Dependent -> first entry of its list
+    std::array<CoordinateMap<uint32_t>, LEVELS> blocks;   ///< Per level: block coordinates -> bucket
+    std::vector<std::vector<uint32_t>> buckets;           ///< Entries listed in a block
+    std::vector<uint32_t> freeBuckets;                    ///< Buckets of blocks that became empty
+    std::array<size_t, LEVELS> levelSizes{};              ///< Number of areas stored per level
+    uint64_t usedLevels = 0;                              ///< Bit L is set if level L holds areas
+
+    /**
+     * @brief Chooses the level of an area.
+     *
+     * @param area Area to store
+     * @return Lowest level whose blocks are at least as high and as wide as the area
+     */
+    static int levelOf(const Area& area);
+
+    /**
+     * @brief Computes the block that holds a position on a level.
+     */
+    static Coordinates blockOf(const Coordinates& c, int level) {
+        return {c.row >> (ROW_BITS + level), c.col >> (COL_BITS + level)};
+    }
+
+    /**
+     * @brief Calls a function for every block an entry is listed in.
+     */
+    template <typename Visitor>
+    static void forEachBlock(const Entry& entry, Visitor&& visit) {
+        const Coordinates first = blockOf({entry.area.minRow(), entry.area.minCol()}, entry.level);
+        const Coordinates last = blockOf({entry.area.maxRow(), entry.area.maxCol()}, entry.level);
+        for (int64_t row = first.row; row <= last.row; ++row) {
+            for (int64_t col = first.col; col <= last.col; ++col) {
+                visit(Coordinates(row, col));
+            }
+        }
+    }
+
+public:
+    /**
+     * @brief Registers an area aggregated by a cell.
+     *
+     * A cell may register several areas, and the same area more than once.
+     *
+     * @param area Aggregated area (corners may be given in any order)
+     * @param dependent Cell that aggregates the area
+     */
+    void add(const Area& area, const Coordinates& dependent);
+
+    /**
+     * @brief Removes all areas registered by a cell.
+     *
+     * Does nothing if the cell has no areas.
+     *
+     * @param dependent Cell whose areas are removed
+     */
+    void remove(const Coordinates& dependent);
+
+    /**
+     * @brief Visits the cells that aggregate an area containing a position.
+     *
+     * A cell is visited once for every one of its areas that contains
+     * the position.
+     *
+     * @param position Position to look up
+     * @param visit Function called with the Coordinates of each dependent
+     */
+    template <typename Visitor>
+    void forEachContaining(const Coordinates& position, Visitor&& visit) const {
+        for (uint64_t levels = usedLevels; levels != 0; levels &= levels - 1) {
+            const int level = std::countr_zero(levels);
+            const uint32_t* bucket = blocks[level].find(blockOf(position, level));
+            if (bucket == nullptr) {
+                continue;
+            }
+            for (uint32_t e : buckets[*bucket]) {
+                if (entries[e].area.contains(position)) {
+                    visit(entries[e].dependent);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the number of registered areas.
+     */
+    size_t size() const {
+        return count;
+    }
+
+    /**
+     * @brief Checks whether no area is registered.
+     */
+    bool empty() const {
+        return count == 0;
+    }
+
+    /**
+     * @brief Removes all areas and releases their memory.
+     */
+    void clear();
+};
+
+#endif // AREA_INDEX_H
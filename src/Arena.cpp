@@ -0,0 +1,82 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "Arena.h"
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+Arena::Arena() : cursor(nullptr), available(0), used(0) {
+}
+
+Arena::~Arena() {
+    this->release();
+}
+
+Arena::Arena(Arena &&other) noexcept
+    : chunks(std::move(other.chunks)), cursor(other.cursor), available(other.available), used(other.used) {
+    other.chunks.clear();
+    other.cursor = nullptr;
+    other.available = 0;
+    other.used = 0;
+}
+
+Arena &Arena::operator=(Arena &&other) noexcept {
+    if (this != &other) {
+        this->release();
+        std::swap(this->chunks, other.chunks);
+        std::swap(this->cursor, other.cursor);
+        std::swap(this->available, other.available);
+        std::swap(this->used, other.used);
+    }
+    return *this;
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    const size_t padding = (alignment - reinterpret_cast<uintptr_t>(this->cursor) % alignment) % alignment;
+
+    if (this->cursor == nullptr || padding + bytes > this->available) {
+        // Oversized requests get a chunk of their own; the current chunk stays in use
+        if (bytes + alignment > CHUNK_SIZE) {
+            char* chunk = new char[bytes + alignment];
+            this->chunks.push_back(chunk);
+            this->used += bytes;
+
+            const size_t offset = (alignment - reinterpret_cast<uintptr_t>(chunk) % alignment) % alignment;
+            return chunk + offset;
+        }
+
+        this->chunks.push_back(new char[CHUNK_SIZE]);
+        this->cursor = this->chunks.back();
+        this->available = CHUNK_SIZE;
+        return this->allocate(bytes, alignment);
+    }
+
+    char* result = this->cursor + padding;
+    this->cursor = result + bytes;
+    this->available -= padding + bytes;
+    this->used += bytes;
+    return result;
+}
+
+std::string_view Arena::store(std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+
+    char* copy = static_cast<char*>(this->allocate(text.size(), 1));
+    std::memcpy(copy, text.data(), text.size());
+    return {copy, text.size()};
+}
+
+void Arena::release() {
+    for (char* chunk : this->chunks) {
+        delete[] chunk;
+    }
+    this->chunks.clear();
+    this->cursor = nullptr;
+    this->available = 0;
+    this->used = 0;
+}
@@ -0,0 +1,85 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Monotonic arena for bytes that live as long as their owner.
+ *
+ * Memory is handed out from chunks of CHUNK_SIZE bytes by moving a
+ * cursor, so storing a text costs no allocation of its own, and
+ * release() returns everything with one deallocation per chunk instead
+ * of one per stored object. Nothing is freed individually; owners that
+ * drop many objects rebuild their arena (see FormulaPool).
+ *
+ * Stored bytes never move, so views into the arena stay valid until
+ * release(), also when the arena itself is moved.
+ */
+class Arena {
+public:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024; ///< Size of a regular chunk
+
+private:
+    std::vector<char*> chunks; ///< Allocated chunks
+    char* cursor;              ///< Next free byte of the current chunk
+    size_t available;          ///< Free bytes left in the current chunk
+    size_t used;               ///< Bytes handed out since the last release()
+
+public:
+    Arena();
+    ~Arena();
+
+    Arena(Arena&& other) noexcept;
+    Arena& operator=(Arena&& other) noexcept;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * @brief Reserves bytes in the arena.
+     *
+     * Requests larger than a chunk get a chunk of their own.
+     *
+     * @param bytes Number of bytes
+     * @param alignment Required alignment (a power of two)
+     * @return Start of the reserved bytes
+     */
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * @brief Copies a text into the arena.
+     *
+     * @param text Text to copy
+     * @return View of the copy
+     */
+    std::string_view store(std::string_view text);
+
+    /**
+     * @brief Frees all chunks at once.
+     *
+     * Every view and pointer into the arena becomes invalid.
+     */
+    void release();
+
+    /**
+     * @brief Returns the number of bytes handed out since the last release().
+     */
+    size_t size() const {
+        return used;
+    }
+
+    /**
+     * @brief Returns the number of allocated chunks.
+     */
+    size_t chunkCount() const {
+        return chunks.size();
+    }
+};
+
+#endif // ARENA_H
@@ -0,0 +1,295 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "CellStore.h"
+#include "ThreadPool.h"
+#include <stdexcept>
+
+namespace {
+    /// Ranges of cells per thread when restoreCells() is given a pool
+    constexpr size_t RANGES_PER_THREAD = 4;
+
+    /**
+     * @brief What restoreCells() learns about one range of cells before placing them.
+     */
+    struct RestoredRange {
+        std::vector<Coordinates> blocks; ///< Blocks of the range's cells, without consecutive repeats
+        Coordinates lowest;              ///< Smallest row and column in the range
+        Coordinates highest;             ///< Largest row and column in the range
+        bool unknownFormula = false;     ///< True if a cell of the range has an unknown formula id
+        bool unsorted = false;           ///< True if rows must be sorted and a cell's row is below the previous one
+        bool duplicate = false;          ///< True if two cells of the range share a position
+    };
+}
+
+size_t CellStore::size() const {
+    return positions.size();
+}
+
+bool CellStore::empty() const {
+    return positions.empty();
+}
+
+void CellStore::reserve(size_t cellCount) {
+    values.reserve(cellCount);
+    states.reserve(cellCount);
+    positions.reserve(cellCount);
+    formulaIds.reserve(cellCount);
+}
+
+void CellStore::clear() {
+    values.clear();
+    states.clear();
+    positions.clear();
+    formulaIds.clear();
+    formulas.clear();
+    tiles.clear();
+    directory.clear();
+    lastTile = NO_TILE;
+    lowest = Coordinates();
+    highest = Coordinates();
+}
+
+Area CellStore::bounds() const {
+    return Area(lowest, highest);
+}
+
+void CellStore::occupy(Tile &tile, const Coordinates &c) {
+    tile.occupied[c.row & (TILE_ROWS - 1)] |= uint64_t{1} << (c.col & (TILE_COLS - 1));
+    lowest = Coordinates(std::min(lowest.row, c.row), std::min(lowest.col, c.col));
+    highest = Coordinates(std::max(highest.row, c.row), std::max(highest.col, c.col));
+}
+
+uint32_t CellStore::tileFor(const Coordinates &block) {
+    if (lastTile != NO_TILE && block == lastBlock) {
+        return lastTile;
+    }
+
+    const auto [tileIndex, inserted] = directory.tryEmplace(block, static_cast<uint32_t>(tiles.size()));
+    if (inserted) {
+        tiles.emplace_back();
+    }
+
+    lastBlock = block;
+    lastTile = *tileIndex;
+    return lastTile;
+}
+
+CellStore::CellId CellStore::find(const Coordinates &c) const {
+    const Tile* tile = findTile(blockOf(c));
+    if (tile == nullptr) {
+        return NO_CELL;
+    }
+
+    // An EMPTY slot wraps around to NO_CELL
+    return tile->slots[slotOf(c)] - 1;
+}
+
+void CellStore::findColumn(int64_t col, int64_t firstRow, size_t count, CellId *ids) const {
+    size_t i = 0;
+    while (i < count) {
+        const Coordinates c(firstRow + static_cast<int64_t>(i), col);
+        const size_t rowsLeftInTile = static_cast<size_t>(TILE_ROWS - (c.row & (TILE_ROWS - 1)));
+        const size_t n = std::min(count - i, rowsLeftInTile);
+        const Tile* tile = findTile(blockOf(c));
+
+        if (tile == nullptr) {
+            std::fill(ids + i, ids + i + n, NO_CELL);
+        } else {
+            size_t slot = slotOf(c);
+            for (size_t k = 0; k < n; ++k, slot += TILE_COLS) {
+                ids[i + k] = tile->slots[slot] - 1;
+            }
+        }
+        i += n;
+    }
+}
+
+bool CellStore::contains(const Coordinates &c) const {
+    return find(c) != NO_CELL;
+}
+
+CellStore::CellId CellStore::at(const Coordinates &c) const {
+    const CellId id = find(c);
+    if (id == NO_CELL) {
+        throw std::out_of_range("Cell does not exist");
+    }
+    return id;
+}
+
+CellStore::CellId CellStore::put(const Coordinates &c, std::string_view expression) {
+    // Acquired before the old formula is released, so re-setting the same
+    // text does not drop and recompile it
+    const FormulaPool::FormulaId formula = formulas.acquire(expression);
+
+    Tile& tile = tiles[tileFor(blockOf(c))];
+    uint32_t& slot = tile.slots[slotOf(c)];
+    if (slot != EMPTY) {
+        const CellId id = slot - 1;
+        values[id] = 0.0;
+        states[id] = EvalState::Dirty;
+        formulas.release(formulaIds[id]);
+        formulaIds[id] = formula;
+        return id;
+    }
+
+    if (positions.empty()) {
+        lowest = c;
+        highest = c;
+    }
+    occupy(tile, c);
+    values.push_back(0.0);
+    states.push_back(EvalState::Dirty);
+    positions.push_back(c);
+    formulaIds.push_back(formula);
+
+    slot = static_cast<uint32_t>(positions.size());
+    return slot - 1;
+}
+
+FormulaPool::FormulaId CellStore::restoreFormula(std::string_view expression, Program program, size_t uses) {
+    return formulas.restore(expression, std::move(program), uses);
+}
+
+void CellStore::restoreCells(std::vector<Coordinates> restoredPositions,
+                             std::vector<FormulaPool::FormulaId> restoredFormulaIds,
+                             std::vector<double> restoredValues,
+                             std::vector<EvalState> restoredStates,
+                             ThreadPool* pool) {
+    const size_t count = restoredPositions.size();
+    if (restoredFormulaIds.size() != count || restoredValues.size() != count || restoredStates.size() != count) {
+        throw std::runtime_error("Cell arrays differ in size");
+    }
+
+    // Range boundaries never split a row
+    std::vector<size_t> bounds{0};
+    const size_t rangeCount = pool == nullptr ? 1 : pool->size() * RANGES_PER_THREAD;
+    for (size_t k = 1; k < rangeCount; ++k) {
+        size_t bound = std::max(bounds.back(), count / rangeCount * k);
+        while (bound > 0 && bound < count && restoredPositions[bound].row == restoredPositions[bound - 1].row) {
+            ++bound;
+        }
+        if (bound > bounds.back() && bound < count) {
+            bounds.push_back(bound);
+        }
+    }
+    bounds.push_back(count);
+
+    const bool sortedRows = bounds.size() > 2;
+    std::vector<RestoredRange> ranges(bounds.size() - 1);
+    auto forEachRange = [&](auto&& work) {
+        if (pool == nullptr || ranges.size() == 1) {
+            for (size_t r = 0; r < ranges.size(); ++r) {
+                work(r);
+            }
+            return;
+        }
+        pool->parallelFor(ranges.size(), 1, [&](size_t from, size_t to) {
+            for (size_t r = from; r < to; ++r) {
+                work(r);
+            }
+        });
+    };
+
+    forEachRange([&](size_t r) {
+        RestoredRange& range = ranges[r];
+        for (size_t id = bounds[r]; id < bounds[r + 1]; ++id) {
+            const Coordinates& c = restoredPositions[id];
+            if (restoredFormulaIds[id] >= formulas.size()) {
+                range.unknownFormula = true;
+                return;
+            }
+            if (sortedRows && id > 0 && c.row < restoredPositions[id - 1].row) {
+                range.unsorted = true;
+                return;
+            }
+
+            const Coordinates block = blockOf(c);
+            if (range.blocks.empty()) {
+                range.lowest = c;
+                range.highest = c;
+            } else {
+                range.lowest = Coordinates(std::min(range.lowest.row, c.row), std::min(range.lowest.col, c.col));
+                range.highest = Coordinates(std::max(range.highest.row, c.row), std::max(range.highest.col, c.col));
+            }
+            if (range.blocks.empty() || !(range.blocks.back() == block)) {
+                range.blocks.push_back(block);
+            }
+        }
+    });
+    for (const RestoredRange& range : ranges) {
+        if (range.unknownFormula) {
+            throw std::runtime_error("Unknown formula");
+        }
+        if (range.unsorted) {
+            throw std::runtime_error("Cells are not sorted by row");
+        }
+    }
+
+    tiles.clear();
+    directory.clear();
+    lastTile = NO_TILE;
+    lowest = count > 0 ? restoredPositions[0] : Coordinates();
+    highest = lowest;
+
+    // Tiles are allocated here, all at once, so the ranges only read the directory
+    uint32_t tileCount = 0;
+    for (const RestoredRange& range : ranges) {
+        for (const Coordinates& block : range.blocks) {
+            tileCount += directory.tryEmplace(block, tileCount).second;
+        }
+        if (!range.blocks.empty()) {
+            lowest = Coordinates(std::min(lowest.row, range.lowest.row), std::min(lowest.col, range.lowest.col));
+            highest = Coordinates(std::max(highest.row, range.highest.row), std::max(highest.col, range.highest.col));
+        }
+    }
+    tiles.resize(tileCount);
+
+    forEachRange([&](size_t r) {
+        RestoredRange& range = ranges[r];
+        Coordinates block;
+        Tile* tile = nullptr;
+        for (size_t id = bounds[r]; id < bounds[r + 1]; ++id) {
+            const Coordinates& c = restoredPositions[id];
+            if (tile == nullptr || !(blockOf(c) == block)) {
+                block = blockOf(c);
+                tile = &tiles[*directory.find(block)];
+            }
+
+            uint32_t& slot = tile->slots[slotOf(c)];
+            if (slot != EMPTY) {
+                range.duplicate = true;
+                return;
+            }
+            slot = static_cast<uint32_t>(id + 1);
+            tile->occupied[c.row & (TILE_ROWS - 1)] |= uint64_t{1} << (c.col & (TILE_COLS - 1));
+        }
+    });
+    for (const RestoredRange& range : ranges) {
+        if (range.duplicate) {
+            tiles.clear();
+            directory.clear();
+            lowest = Coordinates();
+            highest = Coordinates();
+            throw std::runtime_error("Duplicate cell position");
+        }
+    }
+
+    positions = std::move(restoredPositions);
+    formulaIds = std::move(restoredFormulaIds);
+    values = std::move(restoredValues);
+    states = std::move(restoredStates);
+}
+
+void CellStore::resetStates() {
+    std::fill(states.begin(), states.end(), EvalState::Dirty);
+}
+
+std::vector<Coordinates>::const_iterator CellStore::begin() const {
+    return positions.begin();
+}
+
+std::vector<Coordinates>::const_iterator CellStore::end() const {
+    return positions.end();
+}
@@ -0,0 +1,488 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef CELL_STORE_H
+#define CELL_STORE_H
+
+#include "CoordinateMap.h"
+#include "FormulaPool.h"
+#include "Types.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * @brief Sparse storage of table cells organized in fixed-size tiles.
+ *
+ * The sheet is divided into tiles of TILE_ROWS x TILE_COLS positions.
+ * A tile is allocated only when one of its positions is occupied and is
+ * found through a directory keyed by the tile's block coordinates. Each
+ * tile stores a dense array of slots holding cell ids, so neighbouring
+ * positions are neighbouring slots in memory and row-major scans read
+ * whole tile rows instead of probing a hash table per position.
+ *
+ * Cell data is kept as a structure of arrays indexed by cell id. Cached
+ * values and evaluation states, which recalculation and printing read
+ * for every cell, live in their own dense arrays. Expression text and
+ * compiled programs are interned in a FormulaPool, so cells with the
+ * same relative formula share them and store only a formula id.
+ */
+class CellStore {
+public:
+    using CellId = uint32_t; ///< Index of a cell in the store's arrays
+
+    static constexpr CellId NO_CELL = std::numeric_limits<CellId>::max(); ///< Id of an empty position
+
+    static constexpr int ROW_BITS = 4;                  ///< log2 of the tile height
+    static constexpr int COL_BITS = 6;                  ///< log2 of the tile width
+    static constexpr int64_t TILE_ROWS = 1 << ROW_BITS; ///< Rows per tile
+    static constexpr int64_t TILE_COLS = 1 << COL_BITS; ///< Columns per tile
+
+private:
+    /// Slot value of an empty position
+    static constexpr uint32_t EMPTY = 0;
+
+    /**
+     * @brief A block of TILE_ROWS x TILE_COLS positions.
+     *
+     * Slots hold the id of the cell plus one, or EMPTY. Each row of the
+     * block also has an occupancy mask with one bit per column, so row
+     * walks jump from one occupied slot to the next.
+     */
+    struct Tile {
+        std::array<uint32_t, TILE_ROWS * TILE_COLS> slots{}; ///< Row-major slots of the block
+        std::array<uint64_t, TILE_ROWS> occupied{};          ///< Bit c of row r is set if slot (r, c) holds a cell
+    };
+
+    static_assert(TILE_COLS == 64, "A tile row's occupancy must fit in one uint64_t mask");
+
+    /**
+     * @brief Builds the occupancy mask of a range of tile columns.
+     *
+     * @param first First column inside the tile
+     * @param last Last column inside the tile (inclusive)
+     * @return Mask with bits first..last set
+     */
+    static uint64_t columnMask(int64_t first, int64_t last) {
+        return (~uint64_t{0} << first) & (~uint64_t{0} >> (TILE_COLS - 1 - last));
+    }
+
+    // Hot data, read for every cell during recalculation and printing
+    std::vector<double> values;            ///< Cached value of each cell
+    std::vector<EvalState> states;         ///< Evaluation state of each cell
+
+    // Cold data, read when a cell is set, executed or listed
+    std::vector<Coordinates> positions;               ///< Position of each cell
+    std::vector<FormulaPool::FormulaId> formulaIds;   ///< Formula of each cell
+    FormulaPool formulas;                             ///< Shared expression texts and programs
+
+    Coordinates lowest;   ///< Smallest row and smallest column of any cell
+    Coordinates highest;  ///< Largest row and largest column of any cell
+
+    std::vector<Tile> tiles;                                ///< Allocated tiles
+    CoordinateMap<uint32_t> directory; ///< Block coordinates -> index into `tiles`
+
+    // Tile of the previous insertion; loads insert in row-major order, so
+    // most insertions land in the same tile and skip the directory
+    static constexpr uint32_t NO_TILE = std::numeric_limits<uint32_t>::max();
+    Coordinates lastBlock;           ///< Block coordinates of `lastTile`
+    uint32_t lastTile = NO_TILE;     ///< Index into `tiles`, or NO_TILE
+
+    /**
+     * @brief Computes the block coordinates of the tile that holds a position.
+     *
+     * @param c Position in the sheet
+     * @return Block coordinates (row and column of the tile)
+     */
+    static Coordinates blockOf(const Coordinates& c) {
+        return {c.row >> ROW_BITS, c.col >> COL_BITS};
+    }
+
+    /**
+     * @brief Computes the index of a position inside its tile.
+     *
+     * @param c Position in the sheet
+     * @return Slot index in row-major order
+     */
+    static size_t slotOf(const Coordinates& c) {
+        return static_cast<size_t>(((c.row & (TILE_ROWS - 1)) << COL_BITS) | (c.col & (TILE_COLS - 1)));
+    }
+
+    /**
+     * @brief Finds the tile of a block, allocating it if the block is empty.
+     *
+     * @param block Block coordinates
+     * @return Index of the tile in `tiles`
+     */
+    uint32_t tileFor(const Coordinates& block);
+
+    /**
+     * @brief Records a new cell in the occupancy masks and the bounds.
+     *
+     * @param tile Tile that holds the cell
+     * @param c Position of the cell
+     */
+    void occupy(Tile& tile, const Coordinates& c);
+
+    /**
+     * @brief Finds the tile of a block.
+     *
+     * @param block Block coordinates
+     * @return Pointer to the tile, or nullptr if the block is empty
+     */
+    const Tile* findTile(const Coordinates& block) const {
+        const uint32_t* tileIndex = directory.find(block);
+        return tileIndex == nullptr ? nullptr : &tiles[*tileIndex];
+    }
+
+public:
+    /**
+     * @brief Returns the number of stored cells.
+     *
+     * @return Cell count
+     */
+    size_t size() const;
+
+    /**
+     * @brief Checks whether no cell is stored.
+     *
+     * @return true if the store is empty
+     */
+    bool empty() const;
+
+    /**
+     * @brief Reserves room for a number of cells.
+     *
+     * @param cellCount Expected number of cells
+     */
+    void reserve(size_t cellCount);
+
+    /**
+     * @brief Removes all cells and releases all tiles.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the smallest rectangle that contains every cell.
+     *
+     * Kept up to date as cells are added, so the call is O(1).
+     *
+     * @return Bounding area (from the smallest to the largest row and
+     *         column), or the single position (0, 0) if the store is empty
+     */
+    Area bounds() const;
+
+    /**
+     * @brief Finds the id of the cell stored at a position.
+     *
+     * @param c Position in the sheet
+     * @return Id of the cell, or NO_CELL if the position is empty
+     */
+    CellId find(const Coordinates& c) const;
+
+    /**
+     * @brief Finds the ids of the cells in a vertical run of positions.
+     *
+     * Reads one tile per TILE_ROWS positions instead of looking up every
+     * position, which makes gathering the inputs of a column run cheap.
+     *
+     * @param col Column of the run
+     * @param firstRow Row of the first position
+     * @param count Number of positions
+     * @param ids Receives `count` ids (NO_CELL for empty positions)
+     */
+    void findColumn(int64_t col, int64_t firstRow, size_t count, CellId* ids) const;
+
+    /**
+     * @brief Checks whether a position is occupied.
+     *
+     * @param c Position in the sheet
+     * @return true if a cell is stored at `c`
+     */
+    bool contains(const Coordinates& c) const;
+
+    /**
+     * @brief Finds the id of the cell stored at a position.
+     *
+     * @param c Position in the sheet
+     * @return Id of the cell
+     *
+     * @throws std::out_of_range if the position is empty
+     */
+    CellId at(const Coordinates& c) const;
+
+    /**
+     * @brief Stores a cell, replacing any previous cell at the same position.
+     *
+     * The expression is interned: it is compiled only if no other cell
+     * uses the same text. The cell starts with a cached value of 0.0 and
+     * the Dirty state. A replaced cell keeps its id.
+     *
+     * @param c Position of the cell
+     * @param expression Expression text of the cell
+     * @return Id of the stored cell
+     */
+    CellId put(const Coordinates& c, std::string_view expression);
+
+    /**
+     * @brief Adds a formula whose program was compiled earlier.
+     *
+     * See FormulaPool::restore().
+     *
+     * @param expression Expression text
+     * @param program Program compiled from the expression
+     * @param uses Number of cells that will use the formula
+     * @return Id of the formula
+     */
+    FormulaPool::FormulaId restoreFormula(std::string_view expression, Program program, size_t uses);
+
+    /**
+     * @brief Fills an empty store with previously saved cells.
+     *
+     * The arrays become the cell data as they are (cell i has position
+     * `positions[i]` and so on) and the tiles are rebuilt from the
+     * positions. Formulas must have been added with restoreFormula().
+     *
+     * With a pool, the cells must be sorted by row. They are split into
+     * ranges of whole rows and placed in their tiles on the pool's
+     * threads; ranges may share a tile but not a tile row, so they write
+     * disjoint slots and occupancy masks. Only the tiles themselves are
+     * allocated on the calling thread.
+     *
+     * @param positions Position of each cell
+     * @param formulaIds Formula of each cell
+     * @param values Cached value of each cell
+     * @param states Evaluation state of each cell
+     * @param pool Threads to place the cells with, or nullptr to place them on the calling thread
+     *
+     * @throws std::runtime_error if the arrays differ in size, a formula id
+     *         is unknown, two cells share a position or, with a pool, the
+     *         cells are not sorted by row
+     */
+    void restoreCells(std::vector<Coordinates> positions, std::vector<FormulaPool::FormulaId> formulaIds,
+                      std::vector<double> values, std::vector<EvalState> states, ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Returns the position of a cell.
+     *
+     * @param id Cell id
+     * @return Coordinates of the cell
+     */
+    const Coordinates& position(CellId id) const {
+        return positions[id];
+    }
+
+    /**
+     * @brief Returns the expression text of a cell.
+     *
+     * @param id Cell id
+     * @return Expression stored in the cell
+     */
+    std::string_view expression(CellId id) const {
+        return formulas.expression(formulaIds[id]);
+    }
+
+    /**
+     * @brief Returns the compiled expression of a cell.
+     *
+     * @param id Cell id
+     * @return Program of the cell
+     */
+    const Program& program(CellId id) const {
+        return formulas.program(formulaIds[id]);
+    }
+
+    /**
+     * @brief Returns the id of the formula used by a cell.
+     *
+     * Cells with equal expression text have equal formula ids.
+     *
+     * @param id Cell id
+     * @return Formula id in the store's FormulaPool
+     */
+    FormulaPool::FormulaId formula(CellId id) const {
+        return formulaIds[id];
+    }
+
+    /**
+     * @brief Provides read-only access to the interned formulas.
+     *
+     * @return Reference to the formula pool
+     */
+    const FormulaPool& getFormulas() const {
+        return formulas;
+    }
+
+    /**
+     * @brief Measures the probe lengths of the tile directory.
+     *
+     * @return Probe-length statistics of the map from block coordinates to tiles
+     */
+    ProbeStatistics getDirectoryStatistics() const {
+        return directory.probeStatistics();
+    }
+
+    /**
+     * @brief Returns the cached value of a cell.
+     *
+     * @param id Cell id
+     * @return Cached value
+     */
+    double value(CellId id) const {
+        return values[id];
+    }
+
+    /**
+     * @brief Updates the cached value of a cell.
+     *
+     * Values are separate array elements, so different cells may be
+     * updated concurrently.
+     *
+     * @param id Cell id
+     * @param value New cached value
+     */
+    void setValue(CellId id, double value) {
+        values[id] = value;
+    }
+
+    /**
+     * @brief Returns the evaluation state of a cell.
+     *
+     * @param id Cell id
+     * @return Evaluation state
+     */
+    EvalState state(CellId id) const {
+        return states[id];
+    }
+
+    /**
+     * @brief Updates the evaluation state of a cell.
+     *
+     * States are separate array elements, so different cells may be
+     * updated concurrently.
+     *
+     * @param id Cell id
+     * @param state New evaluation state
+     */
+    void setState(CellId id, EvalState state) {
+        states[id] = state;
+    }
+
+    /**
+     * @brief Sets the evaluation state of every cell to Dirty.
+     */
+    void resetStates();
+
+    /**
+     * @brief Returns an iterator to the position of the first stored cell.
+     *
+     * Cells are iterated in id (insertion) order.
+     *
+     * @return Iterator over cell positions
+     */
+    std::vector<Coordinates>::const_iterator begin() const;
+
+    /**
+     * @brief Returns an iterator past the position of the last stored cell.
+     *
+     * @return Iterator over cell positions
+     */
+    std::vector<Coordinates>::const_iterator end() const;
+
+    /**
+     * @brief Visits the existing cells inside an area in row-major order.
+     *
+     * If the area overlaps fewer tiles than are allocated, the overlapping
+     * tiles are scanned row by row; otherwise the allocated tiles are
+     * filtered. Either way the cost follows the occupied part of the sheet,
+     * not the size of the rectangle.
+     *
+     * @param area Rectangle to visit (corners may be given in any order)
+     * @param visit Function called with the id of every existing cell
+     */
+    template <typename Visitor>
+    void forEachInArea(const Area& area, Visitor&& visit) const {
+        const int64_t minRow = area.minRow();
+        const int64_t maxRow = area.maxRow();
+        const int64_t minCol = area.minCol();
+        const int64_t maxCol = area.maxCol();
+
+        const Coordinates firstBlock = blockOf({minRow, minCol});
+        const Coordinates lastBlock = blockOf({maxRow, maxCol});
+        const uint64_t blockRows = static_cast<uint64_t>(lastBlock.row - firstBlock.row) + 1;
+        const uint64_t blockCols = static_cast<uint64_t>(lastBlock.col - firstBlock.col) + 1;
+
+        if (blockRows <= tiles.size() / blockCols) {
+            std::vector<const Tile*> band(blockCols);
+
+            for (int64_t blockRow = firstBlock.row; blockRow <= lastBlock.row; ++blockRow) {
+                bool anyTile = false;
+                for (uint64_t k = 0; k < blockCols; ++k) {
+                    band[k] = findTile({blockRow, firstBlock.col + static_cast<int64_t>(k)});
+                    anyTile = anyTile || band[k] != nullptr;
+                }
+                if (!anyTile) {
+                    continue;
+                }
+
+                const int64_t rowFrom = std::max(minRow, blockRow << ROW_BITS);
+                const int64_t rowTo = std::min(maxRow, (blockRow << ROW_BITS) + TILE_ROWS - 1);
+
+                for (int64_t r = rowFrom; r <= rowTo; ++r) {
+                    for (uint64_t k = 0; k < blockCols; ++k) {
+                        if (band[k] == nullptr) {
+                            continue;
+                        }
+
+                        const int64_t blockCol = firstBlock.col + static_cast<int64_t>(k);
+                        const int64_t colFrom = std::max(minCol, blockCol << COL_BITS);
+                        const int64_t colTo = std::min(maxCol, (blockCol << COL_BITS) + TILE_COLS - 1);
+                        const size_t rowStart = slotOf({r, 0});
+                        uint64_t occupied = band[k]->occupied[r & (TILE_ROWS - 1)] &
+                                            columnMask(colFrom & (TILE_COLS - 1), colTo & (TILE_COLS - 1));
+
+                        for (; occupied != 0; occupied &= occupied - 1) {
+                            visit(static_cast<CellId>(band[k]->slots[rowStart + std::countr_zero(occupied)] - 1));
+                        }
+                    }
+                }
+            }
+            return;
+        }
+
+        std::vector<CellId> inside;
+        directory.forEach([&](const Coordinates& block, uint32_t tileIndex) {
+            const Coordinates corner(block.row << ROW_BITS, block.col << COL_BITS);
+            if (corner.row > maxRow || corner.row + TILE_ROWS - 1 < minRow ||
+                corner.col > maxCol || corner.col + TILE_COLS - 1 < minCol) {
+                return;
+            }
+
+            const Tile& tile = tiles[tileIndex];
+            for (int64_t r = 0; r < TILE_ROWS; ++r) {
+                for (uint64_t occupied = tile.occupied[r]; occupied != 0; occupied &= occupied - 1) {
+                    const uint32_t slot = tile.slots[(r << COL_BITS) | std::countr_zero(occupied)];
+                    if (area.contains(positions[slot - 1])) {
+                        inside.push_back(slot - 1);
+                    }
+                }
+            }
+        });
+
+        std::sort(inside.begin(), inside.end(), [this](CellId a, CellId b) {
+            return positions[a] < positions[b];
+        });
+        for (CellId id : inside) {
+            visit(id);
+        }
+    }
+};
+
+#endif // CELL_STORE_H
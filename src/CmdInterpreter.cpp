@@ -3,170 +3,420 @@
 //
 
 #include "CmdInterpreter.h"
-
+#include "Evaluator.h"
+#include "MappedFile.h"
+#include "OutputBuffer.h"
+#include "Profiler.h"
+#include "Snapshot.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <exception>
 #include <fstream>
 #include <algorithm>
-#include <sstream>
 #include <iostream>
+#include <unordered_map>
+
 
 void CmdInterpreter::save(const std::string &fileName, const Table& table) {
-    std::ofstream out(fileName);
+    TRACE_SPAN("save", "csv");
+
+    std::ofstream out(fileName, std::ios::binary);
     if (!out.is_open()) {
         throw std::runtime_error("Cannot open file for writing");
     }
 
-    const auto& cells = table.getCells();
+    const CellStore& cells = table.getCells();
+    OutputBuffer buffer(out);
+
+    // Only occupied cells are visited; the gaps before them become
+    // separators and empty lines, and rows end at their last cell
+    const auto [maxRow, maxCol] = table.findTableBounds();
+    int64_t row = 0;
+    int64_t col = 0;
+    bool any = false;
+
+    cells.forEachInArea(Area({0, 0}, {maxRow, maxCol}), [&](CellStore::CellId id) {
+        const Coordinates& c = cells.position(id);
+        if (c.row > row) {
+            buffer.append('\n', static_cast<size_t>(c.row - row));
+            row = c.row;
+            col = 0;
+        }
+        buffer.append(';', static_cast<size_t>(c.col - col));
+        col = c.col;
 
-    int64_t maxRow = 0;
-    int64_t maxCol = 0;
+        buffer.append(cells.expression(id));
+        any = true;
+    });
 
-    for (const auto& pair : cells) {
-        const Cell& cell = pair.second;
-        maxRow = std::max(maxRow, cell.coords.row);
-        maxCol = std::max(maxCol, cell.coords.col);
+    if (any) {
+        buffer.append('\n');
     }
+    buffer.flush();
+}
 
-    for (int64_t r = 0; r <= maxRow; ++r) {
-        for (int64_t c = 0; c <= maxCol; ++c) {
-            Coordinates key = {r, c};
-            auto it = cells.find(key);
-            if (it != cells.end()) {
-                out << it->second.expression;
-            }
+void CmdInterpreter::saveSparse(const std::string &fileName, const Table &table) {
+    TRACE_SPAN("save sparse", "csv");
 
-            if (c < maxCol) {
-                out << ';';
-            }
-        }
-        out << '\n';
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open file for writing");
     }
+
+    const CellStore& cells = table.getCells();
+    OutputBuffer buffer(out);
+
+    const auto [maxRow, maxCol] = table.findTableBounds();
+
+    cells.forEachInArea(Area({0, 0}, {maxRow, maxCol}), [&](CellStore::CellId id) {
+        const Coordinates& c = cells.position(id);
+        buffer.appendInteger(c.row);
+        buffer.append(';');
+        buffer.appendInteger(c.col);
+        buffer.append(';');
+        buffer.append(cells.expression(id));
+        buffer.append('\n');
+    });
+    buffer.flush();
 }
 
-void CmdInterpreter::load(const std::string& fileName, Table& table) {
-    std::ifstream in(fileName);
-    if (!in.is_open()) {
-        throw std::runtime_error("Cannot open file for reading");
-    }
+void CmdInterpreter::loadSparse(const std::string &fileName, Table &table) {
+    TRACE_SPAN("load sparse", "csv");
 
-    std::string line;
-    int64_t row = 0;
+    const MappedFile file(fileName);
+    const char* position = file.data();
+    const char* const end = position + file.size();
+
+    const bool bulk = table.getCells().empty();
+
+    while (position < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(position, '\n', end - position));
+        if (lineEnd == nullptr) {
+            lineEnd = end;
+        }
 
-    while (std::getline(in, line)) {
-        std::stringstream ss(line);
-        std::string cellExpr;
-        int64_t col = 0;
+        if (lineEnd != position) {
+            int64_t row = -1;
+            int64_t col = -1;
 
-        while (std::getline(ss, cellExpr, ';')) {
-            if (!cellExpr.empty()) {
-                table.set(Coordinates(row, col), cellExpr);
+            auto rowEnd = std::from_chars(position, lineEnd, row);
+            if (rowEnd.ec != std::errc() || rowEnd.ptr == lineEnd || *rowEnd.ptr != ';') {
+                throw std::runtime_error("Invalid sparse cell record");
+            }
+            auto colEnd = std::from_chars(rowEnd.ptr + 1, lineEnd, col);
+            if (colEnd.ec != std::errc() || colEnd.ptr == lineEnd || *colEnd.ptr != ';' ||
+                row < 0 || col < 0) {
+                throw std::runtime_error("Invalid sparse cell record");
+            }
+
+            const std::string_view expression(colEnd.ptr + 1, lineEnd - colEnd.ptr - 1);
+            if (bulk) {
+                table.insert(Coordinates(row, col), expression);
+            } else {
+                table.set(Coordinates(row, col), expression);
             }
-            ++col;
         }
 
-        ++row;
+        position = lineEnd + 1;
     }
 }
 
-void CmdInterpreter::set(const Coordinates& address, const std::string& expression, Table& table) {
-    table.set(address, expression);
-}
+void CmdInterpreter::load(const std::string& fileName, Table& table, size_t threadCount) {
+    TRACE_SPAN("load", "csv");
 
-void CmdInterpreter::printValue(const Area& area, const Table& table) {
-    int64_t maxRow = area.maxRow();
-    int64_t maxCol = area.maxCol();
+    const MappedFile file(fileName);
+    const std::string_view text = file.view();
 
-    for (int64_t r = 0; r <= maxRow; ++r) {
-        for (int64_t c = 0; c <= maxCol; ++c) {
-            Coordinates key = {r, c};
-            auto it = table.getCells().find(key);
+    // Loading into an empty table needs no invalidation
+    const bool bulk = table.getCells().empty();
+    if (bulk && !table.inBatch() && threadCount > 1 && text.size() >= MIN_PARALLEL_BYTES) {
+        loadParallel(text, table, threadCount);
+        return;
+    }
 
-            if (it != table.getCells().end()) {
-                std::cout << it->second.cachedValue;
-            }
+    // The number of non-empty fields is known after one pass over the bytes
+    if (bulk) {
+        TRACE_SPAN("count fields", "csv");
+        size_t fields = 0;
+        forEachField(text, [&](int64_t, int64_t, std::string_view) {
+            ++fields;
+        });
+        table.reserve(fields);
+    }
+
+    TRACE_SPAN("parse and insert", "csv");
+    forEachField(text, [&](int64_t row, int64_t col, std::string_view expression) {
+        if (bulk) {
+            table.insert(Coordinates(row, col), expression);
+        } else {
+            table.set(Coordinates(row, col), expression);
+        }
+    });
+}
+
+void CmdInterpreter::loadParallel(std::string_view text, Table& table, size_t threadCount) {
+    // Chunks start right after a line break, so no line is split
+    const size_t chunkCount = threadCount * CHUNKS_PER_THREAD;
+    std::vector<std::string_view> chunks;
+    size_t begin = 0;
+    for (size_t i = 1; i <= chunkCount && begin < text.size(); ++i) {
+        size_t end = text.size();
+        if (i < chunkCount) {
+            end = std::max(begin, text.size() / chunkCount * i);
+            end = text.find('\n', end);
+            end = end == std::string_view::npos ? text.size() : end + 1;
+        }
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
 
-            if (c != maxCol) {
-                std::cout << ", ";
+    ThreadPool& pool = ThreadPool::forCurrentThread(threadCount);
+    auto forEachChunk = [&](const char* name, auto&& work) {
+        std::vector<std::exception_ptr> errors(chunks.size());
+        pool.parallelFor(chunks.size(), 1, [&](size_t from, size_t to) {
+            for (size_t i = from; i < to; ++i) {
+                TRACE_SPAN(name, "csv");
+                try {
+                    work(i);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        });
+        for (const std::exception_ptr& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
             }
         }
-        std::cout << '\n';
+    };
+
+    // Pass 1: the cells and lines of each chunk give its slice of the
+    // cell arrays and its first row
+    std::vector<size_t> firstCell(chunks.size() + 1, 0);
+    std::vector<int64_t> firstRow(chunks.size() + 1, 0);
+    forEachChunk("count chunk", [&](size_t i) {
+        size_t cells = 0;
+        firstRow[i + 1] = forEachField(chunks[i], [&](int64_t, int64_t, std::string_view) {
+            ++cells;
+        });
+        firstCell[i + 1] = cells;
+    });
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        firstCell[i + 1] += firstCell[i];
+        firstRow[i + 1] += firstRow[i];
     }
-}
 
-void CmdInterpreter::printExpression(const Area& area, const Table& table) {
-    int64_t maxRow = area.maxRow();
-    int64_t maxCol = area.maxCol();
+    const size_t total = firstCell.back();
+    std::vector<Coordinates> positions(total);
+    std::vector<FormulaPool::FormulaId> formulaIds(total);
+
+    // Pass 2: every chunk writes its cells in place and interns its
+    // expressions; formulaIds holds indexes into the chunk's lists
+    std::vector<ChunkFormulas> formulas(chunks.size());
+    forEachChunk("parse chunk", [&](size_t i) {
+        ChunkFormulas& local = formulas[i];
+        std::unordered_map<std::string_view, FormulaPool::FormulaId> index;
+        size_t cell = firstCell[i];
+
+        forEachField(chunks[i], [&](int64_t row, int64_t col, std::string_view expression) {
+            auto [it, added] = index.try_emplace(expression, static_cast<FormulaPool::FormulaId>(local.expressions.size()));
+            if (added) {
+                local.expressions.push_back(expression);
+                local.uses.push_back(0);
+            }
+            ++local.uses[it->second];
 
-    for (int64_t r = 0; r <= maxRow; ++r) {
-        for (int64_t c = 0; c <= maxCol; ++c) {
-            Coordinates key = {r, c};
-            auto it = table.getCells().find(key);
+            positions[cell] = Coordinates(firstRow[i] + row, col);
+            formulaIds[cell] = it->second;
+            ++cell;
+        });
 
-            if (it != table.getCells().end()) {
-                std::cout << it->second.expression;
+        local.programs.reserve(local.expressions.size());
+        for (std::string_view expression : local.expressions) {
+            local.programs.push_back(FormulaPool::compile(expression));
+        }
+    });
+
+    // Expressions shared by several chunks get one pool id; adding them in
+    // chunk order numbers the formulas in order of first use, as set() would
+    CellStore cells;
+    {
+        TRACE_SPAN("merge formulas", "csv");
+        std::unordered_map<std::string_view, FormulaPool::FormulaId> index;
+        std::vector<size_t> uses;
+        for (ChunkFormulas& local : formulas) {
+            local.ids.resize(local.expressions.size());
+            for (size_t k = 0; k < local.expressions.size(); ++k) {
+                auto [it, added] = index.try_emplace(local.expressions[k], static_cast<FormulaPool::FormulaId>(uses.size()));
+                if (added) {
+                    uses.push_back(0);
+                }
+                local.ids[k] = it->second;
+                uses[it->second] += local.uses[k];
             }
+        }
 
-            if (c != maxCol) {
-                std::cout << ", ";
+        FormulaPool::FormulaId restored = 0;
+        for (ChunkFormulas& local : formulas) {
+            for (size_t k = 0; k < local.expressions.size(); ++k) {
+                if (local.ids[k] == restored) {
+                    cells.restoreFormula(local.expressions[k], std::move(local.programs[k]), uses[restored]);
+                    ++restored;
+                }
             }
+            std::vector<Program>().swap(local.programs);
         }
-        std::cout << '\n';
     }
+
+    // Pass 3: chunk-local indexes become pool ids
+    forEachChunk("remap chunk", [&](size_t i) {
+        const std::vector<FormulaPool::FormulaId>& ids = formulas[i].ids;
+        for (size_t cell = firstCell[i]; cell < firstCell[i + 1]; ++cell) {
+            formulaIds[cell] = ids[formulaIds[cell]];
+        }
+    });
+
+    TRACE_SPAN("restore cells", "csv");
+    const Coordinates focus = total > 0 ? positions.back() : table.getFocusedCoords();
+    cells.restoreCells(std::move(positions), std::move(formulaIds),
+                       std::vector<double>(total, 0.0), std::vector<EvalState>(total, EvalState::Dirty), &pool);
+    table.restore(std::move(cells), focus, &pool);
 }
 
-void CmdInterpreter::printAllValues(const Table& table) {
-    if (table.getCells().empty()) {
-        return;
-    }
+void CmdInterpreter::saveSnapshot(const std::string &fileName, const Table &table) {
+    TRACE_SPAN("save snapshot", "snapshot");
+    Snapshot::save(fileName, table);
+}
+
+void CmdInterpreter::loadSnapshot(const std::string &fileName, Table &table) {
+    TRACE_SPAN("load snapshot", "snapshot");
+    Snapshot::load(fileName, table);
+}
 
-    // Find table bounds
-    std::pair<int64_t, int64_t> bounds = table.findTableBounds();
-    int64_t maxRow = bounds.first;
-    int64_t maxCol = bounds.second;
+void CmdInterpreter::set(const Coordinates& address, const std::string& expression, Table& table) {
+    table.set(address, expression);
+}
 
-    // Print row by row
-    for (int64_t r = 0; r <= maxRow; ++r) {
-        for (int64_t c = 0; c <= maxCol; ++c) {
-            Coordinates key = {r, c};
-            auto it = table.getCells().find(key);
+void CmdInterpreter::begin(Table &table) {
+    table.beginBatch();
+}
 
-            if (it != table.getCells().end()) {
-                std::cout << it->second.cachedValue;
-            }
+void CmdInterpreter::commit(Table &table, size_t threadCount) {
+    TRACE_SPAN("commit", "command");
+    table.commitBatch();
+    Evaluator::recalculate(table, EvaluationMode::Iterative, threadCount);
+}
 
-            if (c != maxCol) {
-                std::cout << ", ";
-            }
+void CmdInterpreter::abort(Table &table) {
+    table.abortBatch();
+}
+
+void CmdInterpreter::printArea(const Area &area, const Table &table, bool values) {
+    TRACE_SPAN(values ? "print values" : "print expressions", "print");
+
+    const CellStore& cells = table.getCells();
+    const int64_t minCol = area.minCol();
+    const int64_t maxCol = area.maxCol();
+    OutputBuffer buffer(std::cout);
+
+    // Entries of a row are separated by ", "; `next` is the column of the
+    // next entry, so the separators before an entry and after the last
+    // one can be counted instead of looked up
+    int64_t row = area.minRow();
+    int64_t next = minCol;
+
+    auto separators = [&](int64_t toCol) {
+        for (int64_t c = std::max(next, minCol + 1); c <= toCol; ++c) {
+            buffer.append(", ");
+        }
+    };
+    auto finishRow = [&]() {
+        separators(maxCol);
+        buffer.append('\n');
+        ++row;
+        next = minCol;
+    };
+
+    cells.forEachInArea(area, [&](CellStore::CellId id) {
+        const Coordinates& c = cells.position(id);
+        while (row < c.row) {
+            finishRow();
+        }
+
+        separators(c.col);
+        if (values) {
+            buffer.appendNumber(cells.value(id));
+        } else {
+            buffer.append(cells.expression(id));
         }
-        std::cout << '\n';
+        next = c.col + 1;
+    });
+
+    while (row <= area.maxRow()) {
+        finishRow();
     }
+    buffer.flush();
 }
 
-void CmdInterpreter::printAllExpressions(const Table& table) {
-    auto cells = table.getCells();
+void CmdInterpreter::printValue(const Area& area, const Table& table) {
+    printArea(area, table, true);
+}
+
+void CmdInterpreter::printExpression(const Area& area, const Table& table) {
+    printArea(area, table, false);
+}
 
-    if (cells.empty()) {
+void CmdInterpreter::printAllValues(const Table& table) {
+    if (table.getCells().empty()) {
         return;
     }
 
-    // Find table bounds
-    std::pair<int64_t, int64_t> bounds = table.findTableBounds();
-    int64_t maxRow = bounds.first;
-    int64_t maxCol = bounds.second;
+    const auto [maxRow, maxCol] = table.findTableBounds();
+    printArea(Area({0, 0}, {maxRow, maxCol}), table, true);
+}
 
-    // Print row by row
-    for (int64_t r = 0; r <= maxRow; ++r) {
-        for (int64_t c = 0; c <= maxCol; ++c) {
-            Coordinates key = {r, c};
-            auto it = cells.find(key);
+void CmdInterpreter::printAllExpressions(const Table& table) {
+    if (table.getCells().empty()) {
+        return;
+    }
 
-            if (it != cells.end()) {
-                std::cout <<it->second.expression;
-            }
+    const auto [maxRow, maxCol] = table.findTableBounds();
+    printArea(Area({0, 0}, {maxRow, maxCol}), table, false);
+}
 
-            if (c != maxCol) {
-                std::cout << ", ";
-            }
-        }
-        std::cout <<'\n';
+void CmdInterpreter::profile(Table &table, size_t top) {
+    if (!Profiler::ENABLED) {
+        throw std::runtime_error("Profiling is not enabled in this build (define ET_PROFILE)");
     }
-}
\ No newline at end of file
+
+    Profiler::reset();
+    table.invalidateEvalState();
+    Evaluator::recalculate(table);
+
+    Profiler::report(std::cout, top);
+}
+
+void CmdInterpreter::printMapStatistics(Table &table) {
+    auto print = [](const char* name, const ProbeStatistics& statistics) {
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-16s %10zu keys %10zu slots  load %.2f  probe avg %.2f max %u\n",
+                      name, statistics.size, statistics.capacity, statistics.loadFactor(),
+                      statistics.averageProbeLength, statistics.maxProbeLength);
+        std::cout << line;
+    };
+
+    print("tile directory", table.getCells().getDirectoryStatistics());
+    print("dependents", table.getDependentsStatistics());
+}
+
+void CmdInterpreter::startTrace(const std::string &fileName) {
+    Trace::start(fileName);
+}
+
+void CmdInterpreter::stopTrace() {
+    Trace::stop();
+}
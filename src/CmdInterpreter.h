@@ -5,7 +5,11 @@
 #ifndef CMD_INTERPRETER_H
 #define CMD_INTERPRETER_H
 
+#include "DelimiterScanner.h"
 #include "Table.h"
+#include <algorithm>
+#include <string_view>
+#include <vector>
 
 /**
  * @brief Executes high-level user commands on a table instance.
@@ -15,12 +19,115 @@
  * ExpressionParser operations.
  */
 class CmdInterpreter {
+ /// Bytes scanned for separators at once by forEachField()
+ static constexpr size_t SCAN_WINDOW = 1 << 16;
+
+ /**
+  * @brief Visits the non-empty fields of CSV text.
+  *
+  * Rows are separated by '\n' and fields by ';'. The text is processed
+  * in windows of SCAN_WINDOW bytes: DelimiterScanner lists the offsets
+  * of all separators in a window with vector compares, and the fields
+  * between consecutive separators are passed as views into the text,
+  * so no line or field is copied.
+  *
+  * @param text CSV contents
+  * @param visit Function called with (row, column, field) for every non-empty field
+  * @return Number of lines in the text (a final '\n' does not start another line)
+  */
+ template <typename Visitor>
+ static int64_t forEachField(std::string_view text, Visitor&& visit) {
+  const char* const base = text.data();
+  std::vector<uint32_t> separators(std::min(text.size(), SCAN_WINDOW));
+  size_t fieldStart = 0;
+  int64_t row = 0;
+  int64_t col = 0;
+
+  for (size_t window = 0; window < text.size(); window += SCAN_WINDOW) {
+   const size_t length = std::min(SCAN_WINDOW, text.size() - window);
+   const size_t count = DelimiterScanner::find(base + window, length, separators.data());
+
+   for (size_t k = 0; k < count; ++k) {
+    const size_t at = window + separators[k];
+    if (at != fieldStart) {
+     visit(row, col, std::string_view(base + fieldStart, at - fieldStart));
+    }
+
+    if (base[at] == '\n') {
+     ++row;
+     col = 0;
+    } else {
+     ++col;
+    }
+    fieldStart = at + 1;
+   }
+  }
+
+  if (fieldStart < text.size()) {
+   visit(row, col, text.substr(fieldStart));
+  }
+  if (!text.empty() && text.back() != '\n') {
+   ++row;
+  }
+  return row;
+ }
+
+ /**
+  * @brief Distinct expressions of one chunk of a parallel load.
+  *
+  * Each worker interns the fields of its chunk into these lists, in
+  * order of first use, and compiles every expression once; the cells of
+  * the chunk refer to them by their index until the merge replaces the
+  * indexes with pool ids.
+  */
+ struct ChunkFormulas {
+  std::vector<std::string_view> expressions; ///< Views into the mapped file
+  std::vector<Program> programs;             ///< Program compiled from each expression
+  std::vector<size_t> uses;                  ///< Number of cells of the chunk with each expression
+  std::vector<FormulaPool::FormulaId> ids;   ///< Pool id of each expression, set by the merge
+ };
+
+ /// Files smaller than this are loaded on one thread
+ static constexpr size_t MIN_PARALLEL_BYTES = 1 << 20;
+ /// Chunks per thread, so threads that finish early can take more work
+ static constexpr size_t CHUNKS_PER_THREAD = 4;
+
+ /**
+  * @brief Fills an empty table from CSV text on several threads.
+  *
+  * See load(). The cell arrays are built in place by the workers and
+  * handed to the table with Table::restore().
+  *
+  * @param text CSV contents
+  * @param table Empty table without an open batch
+  * @param threadCount Number of threads, including the caller
+  */
+ static void loadParallel(std::string_view text, Table& table, size_t threadCount);
+
+ /**
+  * @brief Prints the cells of an area as a grid.
+  *
+  * Every row of the area becomes one line of ", "-separated entries,
+  * empty for unoccupied positions. Only the area is walked: occupied
+  * cells are found through the tiles of the table's CellStore, numbers
+  * are formatted with std::to_chars, and the text goes to std::cout
+  * through one large buffer.
+  *
+  * @param area Rectangle to print (corners may be given in any order)
+  * @param table Source table containing the cells
+  * @param values true to print cached values, false to print expressions
+  */
+ static void printArea(const Area& area, const Table& table, bool values);
+
 public:
  /**
   * @brief Saves a table to a CSV file.
   *
-  * Only non-empty cells are written to the file. Each cell's
-  * coordinates and stored expression are serialized.
+  * Only occupied cells are visited, in row-major order, and the output
+  * goes through a large buffer. Empty positions before a cell become
+  * separators and empty lines; rows end at their last cell, so the cost
+  * follows the number of cells, not the bounding box. Cells at negative
+  * coordinates cannot be represented and are skipped.
   *
   * @param fileName Path to the output CSV file
   * @param table Table whose contents will be saved
@@ -32,20 +139,94 @@ public:
  /**
   * @brief Loads table contents from a CSV file.
   *
-  * Existing table contents may be overwritten or extended,
-  * depending on the implementation.
+  * The file is memory-mapped and scanned in place. When the table is
+  * empty, storage is reserved up front and cells are inserted without
+  * per-cell invalidation (see Table::insert()); otherwise every cell is
+  * stored through Table::set(), overwriting or extending the table.
+  *
+  * With more than one thread, a large file loaded into an empty table
+  * is split into chunks that end at line breaks and filled in three
+  * parallel passes over the chunks: the fields of each chunk are
+  * counted, then parsed straight into their slice of the final cell
+  * arrays while the chunk's expressions are interned and compiled, and
+  * finally the chunk-local formula indexes are replaced with pool ids.
+  * Between the passes only one entry per chunk, or per distinct
+  * expression of a chunk, is handled on the calling thread. The
+  * finished arrays are then placed in their tiles and listed as dirty
+  * by ranges of rows on the same threads (see CellStore::restoreCells()
+  * and Table::restore()). Rows of a chunk are shifted by the number of
+  * lines before it, so the cells, formula ids and focus are the same as
+  * with one thread.
   *
   * @param fileName Path to the input CSV file
   * @param table Table into which the contents will be loaded
+  * @param threadCount Number of threads to scan with, including the caller (default: 1)
   *
   * @throws std::runtime_error if the file cannot be opened or parsed
   */
- static void load(const std::string& fileName, Table& table);
+ static void load(const std::string& fileName, Table& table, size_t threadCount = 1);
+
+ /**
+  * @brief Saves a table as one `row;col;expression` record per line.
+  *
+  * The sparse format addresses every cell by its coordinates, so file
+  * size and save time depend only on the number of occupied cells.
+  * Records are written in row-major order; cells at negative
+  * coordinates are skipped.
+  *
+  * @param fileName Path to the output file
+  * @param table Table whose contents will be saved
+  *
+  * @throws std::runtime_error if the file cannot be opened or written
+  */
+ static void saveSparse(const std::string& fileName, const Table& table);
+
+ /**
+  * @brief Loads table contents from a file written by saveSparse().
+  *
+  * Everything after the second ';' of a record is the expression.
+  * Empty lines are ignored. Like load(), an empty table is filled in
+  * bulk and a non-empty table is updated cell by cell.
+  *
+  * @param fileName Path to the input file
+  * @param table Table into which the contents will be loaded
+  *
+  * @throws std::runtime_error if the file cannot be opened or a record is malformed
+  */
+ static void loadSparse(const std::string& fileName, Table& table);
+
+ /**
+  * @brief Saves a table as a binary snapshot.
+  *
+  * Unlike the CSV formats, a snapshot also keeps cached values,
+  * evaluation states and compiled programs (see Snapshot).
+  *
+  * @param fileName Path to the output file
+  * @param table Table whose contents will be saved
+  *
+  * @throws std::runtime_error if the file cannot be opened or written
+  */
+ static void saveSnapshot(const std::string& fileName, const Table& table);
+
+ /**
+  * @brief Replaces the contents of a table with a binary snapshot.
+  *
+  * The file is memory-mapped and copied into the table without parsing
+  * or recalculation; cells saved as evaluated can be printed right away.
+  *
+  * @param fileName Path to the snapshot file
+  * @param table Table into which the snapshot will be loaded
+  *
+  * @throws std::runtime_error if the file cannot be opened or is not a valid snapshot
+  */
+ static void loadSnapshot(const std::string& fileName, Table& table);
 
  /**
   * @brief Assigns an expression to a cell in the table.
   *
   * If the specified cell doesn’t exist, it will be created.
+  * While a batch is open for the table (see begin()), the write is
+  * only recorded by the table and applied by commit().
   *
   * @param address Target cell coordinates
   * @param expression Expression string to set
@@ -53,11 +234,52 @@ public:
   */
  static void set(const Coordinates& address, const std::string& expression, Table& table);
 
+ /**
+  * @brief Opens a batch of writes to a table.
+  *
+  * Following set() calls for the table are collected instead of being
+  * applied one by one; reads see the table as it was before the batch
+  * until commit(). The batch belongs to the table (see
+  * Table::beginBatch()), so batches of different tables are independent
+  * and an unfinished batch is discarded with its table.
+  *
+  * @param table Table the batch writes to
+  *
+  * @throws std::runtime_error if a batch is already open for the table
+  */
+ static void begin(Table& table);
+
+ /**
+  * @brief Applies the open batch and recalculates the table once.
+  *
+  * All collected writes are applied in order through Table::setMany(),
+  * which invalidates the union of the affected cells in one walk, and
+  * the table is then recalculated a single time. The batch is closed
+  * before the recalculation, so a failed recalculation leaves the
+  * writes applied and no batch open.
+  *
+  * @param table Table the batch was opened for
+  * @param threadCount Number of threads to recalculate with, including the caller (default: 1)
+  *
+  * @throws std::runtime_error if no batch is open for the table, or if a
+  *         cell cannot be evaluated
+  */
+ static void commit(Table& table, size_t threadCount = 1);
+
+ /**
+  * @brief Discards the open batch of a table without applying it.
+  *
+  * Does nothing if no batch is open for the table.
+  *
+  * @param table Table the batch was opened for
+  */
+ static void abort(Table& table);
+
  /**
   * @brief Prints evaluated numeric values for all cells within an area.
   *
-  * Each cell’s expression is evaluated via ExpressionParser and
-  * displayed in a grid-like output.
+  * The cached value of each cell is displayed in a grid-like output
+  * covering exactly the rows and columns of the area.
   *
   * @param area Area defining the rectangular region to print
   * @param table Source table containing the cells
@@ -94,6 +316,51 @@ public:
   * @param table Table to be displayed
   */
  static void printAllExpressions(const Table& table);
+
+ /**
+  * @brief Recalculates the whole table under the profiler and prints the hottest cells.
+  *
+  * Every cell is invalidated and evaluated again, then the total
+  * recalculation time and the `top` cells with the highest self time
+  * are printed with their evaluation counts, cache hits and misses and
+  * nesting depth (see Profiler).
+  *
+  * @param table Table to profile
+  * @param top Maximum number of cells to list (default: 10)
+  *
+  * @throws std::runtime_error if the program is built without ET_PROFILE,
+  *         or if a cell cannot be evaluated
+  */
+ static void profile(Table& table, size_t top = 10);
+
+ /**
+  * @brief Prints the probe-length statistics of the table's hash maps.
+  *
+  * One line each for the tile directory and the map of dependents:
+  * number of keys, number of slots, load factor and the average and
+  * longest probe length (see CoordinateMap). Set the environment variable
+  * ELECTRONIC_TABLE_HASH_SEED to get the same layout in every run.
+  *
+  * @param table Table to inspect
+  */
+ static void printMapStatistics(Table& table);
+
+ /**
+  * @brief Starts recording a timeline of the following commands.
+  *
+  * Loading, saving, printing, dependency building and recalculation are
+  * recorded as spans per thread until stopTrace() (see Trace).
+  *
+  * @param fileName Path of the Chrome trace-event JSON file
+  */
+ static void startTrace(const std::string& fileName);
+
+ /**
+  * @brief Stops recording and writes the file given to startTrace().
+  *
+  * @throws std::runtime_error if the file cannot be opened
+  */
+ static void stopTrace();
 };
 
 #endif // CMD_INTERPRETER_H
\ No newline at end of file
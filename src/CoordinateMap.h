@@ -0,0 +1,351 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef COORDINATE_MAP_H
+#define COORDINATE_MAP_H
+
+#include "Types.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Probe-length statistics of a CoordinateMap.
+ *
+ * The probe length of a key is the number of slots a lookup of the key
+ * inspects (1 if the key sits in its home slot).
+ */
+struct ProbeStatistics {
+    size_t size = 0;                 ///< Number of keys
+    size_t capacity = 0;             ///< Number of slots
+    double averageProbeLength = 0.0; ///< Mean probe length over all keys
+    uint32_t maxProbeLength = 0;     ///< Longest probe length
+
+    /**
+     * @brief Returns the fraction of occupied slots.
+     */
+    double loadFactor() const {
+        return capacity == 0 ? 0.0 : static_cast<double>(size) / static_cast<double>(capacity);
+    }
+};
+
+/**
+ * @brief Flat open-addressing hash map keyed by Coordinates.
+ *
+ * Keys and values are stored inline in one array of slots, so a lookup
+ * reads consecutive memory instead of following the bucket and node
+ * pointers of std::unordered_map, and inserting a key allocates nothing
+ * until the array grows. Collisions are resolved by linear probing with
+ * Robin Hood ordering: an inserted key takes the slot of a key that is
+ * closer to its home slot, which keeps probe lengths short and even, and
+ * lets a lookup stop as soon as it meets a key closer to home than the
+ * one it searches. Removal shifts the following keys back instead of
+ * leaving tombstones.
+ *
+ * The layout depends only on the keys, their insertion order and the
+ * seed of the Hash, so a fixed seed makes it reproducible.
+ *
+ * Pointers to values stay valid until the next insertion or removal.
+ *
+ * @tparam Value Mapped type (default-constructible and movable)
+ */
+template <typename Value>
+class CoordinateMap {
+private:
+    /**
+     * @brief A slot of the table.
+     */
+    struct Slot {
+        Coordinates key;       ///< Key of the entry
+        Value value{};         ///< Mapped value
+        uint32_t distance = 0; ///< Probe length of the key, 0 if the slot is empty
+    };
+
+    static constexpr size_t MIN_CAPACITY = 16; ///< Capacity of the first allocation
+
+    std::vector<Slot> slots; ///< Slots (the capacity is 0 or a power of two)
+    size_t count = 0;        ///< Number of keys
+    Hash hash;               ///< Hash function with the map's seed
+
+    /**
+     * @brief Returns the home slot of a key.
+     */
+    size_t home(const Coordinates& key) const {
+        return hash(key) & (slots.size() - 1);
+    }
+
+    /**
+     * @brief Returns the slot index of a key, or slots.size() if it is absent.
+     */
+    size_t locate(const Coordinates& key) const {
+        if (count == 0) {
+            return slots.size();
+        }
+
+        const size_t mask = slots.size() - 1;
+        size_t i = home(key);
+        for (uint32_t distance = 1; ; ++distance, i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            // A key closer to its home than we are to ours: ours would have taken its slot
+            if (slot.distance < distance) {
+                return slots.size();
+            }
+            if (slot.key == key) {
+                return i;
+            }
+        }
+    }
+
+    /**
+     * @brief Stores a key that is not in the map; the table must have room for it.
+     *
+     * @return Slot index of the stored key
+     */
+    size_t place(Coordinates key, Value value) {
+        const size_t mask = slots.size() - 1;
+        Slot entry{key, std::move(value), 1};
+        size_t placed = slots.size();
+
+        for (size_t i = home(key); ; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+            if (slot.distance == 0) {
+                slot = std::move(entry);
+                ++count;
+                return placed == slots.size() ? i : placed;
+            }
+
+            if (slot.distance < entry.distance) {
+                std::swap(slot, entry);
+                if (placed == slots.size()) {
+                    placed = i;
+                }
+            }
+            ++entry.distance;
+        }
+    }
+
+    /**
+     * @brief Moves all keys to a table of the given capacity.
+     *
+     * @param capacity New number of slots (a power of two)
+     */
+    void rehash(size_t capacity) {
+        std::vector<Slot> old(capacity);
+        old.swap(slots);
+        count = 0;
+
+        for (Slot& slot : old) {
+            if (slot.distance != 0) {
+                place(slot.key, std::move(slot.value));
+            }
+        }
+    }
+
+    /**
+     * @brief Makes room for one more key.
+     */
+    void grow() {
+        // The maximum load factor is 7/8
+        if ((count + 1) * 8 > slots.size() * 7) {
+            rehash(slots.empty() ? MIN_CAPACITY : slots.size() * 2);
+        }
+    }
+
+public:
+    /**
+     * @brief Creates an empty map.
+     *
+     * @param seed Seed of the hash function; defaults to the process-wide seed (see Hash::defaultSeed())
+     */
+    explicit CoordinateMap(uint64_t seed = Hash::defaultSeed()) : hash(seed) {}
+
+    /**
+     * @brief Returns the number of keys.
+     */
+    size_t size() const {
+        return count;
+    }
+
+    /**
+     * @brief Returns whether the map holds no keys.
+     */
+    bool empty() const {
+        return count == 0;
+    }
+
+    /**
+     * @brief Returns the number of slots.
+     */
+    size_t capacity() const {
+        return slots.size();
+    }
+
+    /**
+     * @brief Makes room for a number of keys without further growth.
+     *
+     * @param keyCount Expected number of keys
+     */
+    void reserve(size_t keyCount) {
+        size_t capacity = slots.empty() ? MIN_CAPACITY : slots.size();
+        while (keyCount * 8 > capacity * 7) {
+            capacity *= 2;
+        }
+        if (capacity > slots.size()) {
+            rehash(capacity);
+        }
+    }
+
+    /**
+     * @brief Finds the value of a key.
+     *
+     * @param key Key to look up
+     * @return Pointer to the value, or nullptr if the key is absent
+     */
+    Value* find(const Coordinates& key) {
+        const size_t i = locate(key);
+        return i == slots.size() ? nullptr : &slots[i].value;
+    }
+
+    /**
+     * @brief Finds the value of a key.
+     *
+     * @param key Key to look up
+     * @return Pointer to the value, or nullptr if the key is absent
+     */
+    const Value* find(const Coordinates& key) const {
+        const size_t i = locate(key);
+        return i == slots.size() ? nullptr : &slots[i].value;
+    }
+
+    /**
+     * @brief Checks whether a key is in the map.
+     *
+     * @param key Key to look up
+     * @return true if the key is present
+     */
+    bool contains(const Coordinates& key) const {
+        return locate(key) != slots.size();
+    }
+
+    /**
+     * @brief Inserts a key unless it is already present.
+     *
+     * @param key Key to insert
+     * @param value Value stored if the key is new
+     * @return Pointer to the value of the key, and whether it was inserted
+     */
+    std::pair<Value*, bool> tryEmplace(const Coordinates& key, Value value = Value()) {
+        const size_t i = locate(key);
+        if (i != slots.size()) {
+            return {&slots[i].value, false};
+        }
+
+        grow();
+        return {&slots[place(key, std::move(value))].value, true};
+    }
+
+    /**
+     * @brief Returns the value of a key, inserting a default value if it is absent.
+     *
+     * @param key Key to look up
+     * @return Reference to the value
+     */
+    Value& operator[](const Coordinates& key) {
+        return *tryEmplace(key).first;
+    }
+
+    /**
+     * @brief Removes a key.
+     *
+     * @param key Key to remove
+     * @return true if the key was present
+     */
+    bool erase(const Coordinates& key) {
+        size_t i = locate(key);
+        if (i == slots.size()) {
+            return false;
+        }
+
+        // Backward shift: following keys that are not in their home slot move one slot closer
+        const size_t mask = slots.size() - 1;
+        for (size_t next = (i + 1) & mask; slots[next].distance > 1; i = next, next = (next + 1) & mask) {
+            slots[i] = std::move(slots[next]);
+            --slots[i].distance;
+        }
+
+        slots[i] = Slot();
+        --count;
+        return true;
+    }
+
+    /**
+     * @brief Removes all keys; the slots are kept for reuse.
+     */
+    void clear() {
+        if (count == 0) {
+            return;
+        }
+        for (Slot& slot : slots) {
+            slot = Slot();
+        }
+        count = 0;
+    }
+
+    /**
+     * @brief Visits all entries in slot order.
+     *
+     * The map must not be modified during the visit.
+     *
+     * @param visit Function called with the key and a reference to the value of every entry
+     */
+    template <typename Visitor>
+    void forEach(Visitor&& visit) {
+        for (Slot& slot : slots) {
+            if (slot.distance != 0) {
+                visit(slot.key, slot.value);
+            }
+        }
+    }
+
+    /**
+     * @brief Visits all entries in slot order.
+     *
+     * @param visit Function called with the key and a const reference to the value of every entry
+     */
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (const Slot& slot : slots) {
+            if (slot.distance != 0) {
+                visit(slot.key, slot.value);
+            }
+        }
+    }
+
+    /**
+     * @brief Measures the probe lengths of all keys.
+     *
+     * Scans the whole table; intended for diagnostics.
+     *
+     * @return Probe-length statistics
+     */
+    ProbeStatistics probeStatistics() const {
+        ProbeStatistics statistics;
+        statistics.size = count;
+        statistics.capacity = slots.size();
+
+        uint64_t total = 0;
+        for (const Slot& slot : slots) {
+            total += slot.distance;
+            statistics.maxProbeLength = std::max(statistics.maxProbeLength, slot.distance);
+        }
+        if (count > 0) {
+            statistics.averageProbeLength = static_cast<double>(total) / static_cast<double>(count);
+        }
+        return statistics;
+    }
+};
+
+#endif // COORDINATE_MAP_H
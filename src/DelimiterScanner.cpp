@@ -0,0 +1,67 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "DelimiterScanner.h"
+#include "Simd.h"
+#include <bit>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+    /**
+     * @brief Appends the offsets of the set bits of a block mask.
+     *
+     * @param mask One bit per byte of the block, set for separators
+     * @param offset Offset of the block's first byte
+     * @param positions Output array
+     * @param count Number of offsets written so far (updated)
+     */
+    [[maybe_unused]] inline void appendMask(uint32_t mask, size_t offset, uint32_t* positions, size_t& count) {
+        while (mask != 0) {
+            positions[count++] = static_cast<uint32_t>(offset + std::countr_zero(mask));
+            mask &= mask - 1;
+        }
+    }
+}
+
+size_t DelimiterScanner::width() {
+    if (AVX2_FIND != nullptr && Simd::level() == SimdLevel::AVX2) {
+        return 32;
+    }
+#if defined(__SSE2__)
+    return 16;
+#else
+    return 1;
+#endif
+}
+
+size_t DelimiterScanner::find(const char *data, size_t size, uint32_t *positions) {
+    if (AVX2_FIND != nullptr && Simd::level() == SimdLevel::AVX2) {
+        return AVX2_FIND(data, size, positions);
+    }
+
+    size_t count = 0;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i semicolons = _mm_set1_epi8(';');
+    const __m128i newlines = _mm_set1_epi8('\n');
+
+    for (; i + 16 <= size; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(bytes, semicolons),
+                                             _mm_cmpeq_epi8(bytes, newlines));
+        appendMask(static_cast<uint32_t>(_mm_movemask_epi8(matches)), i, positions, count);
+    }
+#endif
+
+    for (; i < size; ++i) {
+        if (data[i] == ';' || data[i] == '\n') {
+            positions[count++] = static_cast<uint32_t>(i);
+        }
+    }
+    return count;
+}
@@ -0,0 +1,52 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef DELIMITER_SCANNER_H
+#define DELIMITER_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Finds the field and line separators of CSV text.
+ *
+ * Instead of searching for the next ';' and the next '\n' separately,
+ * the scanner compares a whole block of bytes against both separators
+ * at once and turns the result into a bit mask with one bit per byte.
+ * The positions of the set bits are written out in order, so the CSV
+ * reader walks a list of separator offsets instead of the bytes.
+ *
+ * Blocks are 32 bytes with AVX2, 16 bytes with SSE2 and single bytes
+ * on other architectures. The AVX2 loop lives in DelimiterScannerAvx2.cpp,
+ * which is compiled with AVX2 enabled, and runs only when Simd::level()
+ * selects it.
+ */
+class DelimiterScanner {
+public:
+    /**
+     * @brief Returns the number of bytes compared per step.
+     *
+     * @return 32 with AVX2, 16 with SSE2, 1 for the scalar fallback
+     */
+    static size_t width();
+
+    /**
+     * @brief Finds the offsets of every ';' and '\n' in a block of text.
+     *
+     * @param data First byte of the text
+     * @param size Number of bytes (at most UINT32_MAX)
+     * @param positions Receives the offsets in increasing order; must have
+     *        room for `size` entries
+     * @return Number of separators found
+     */
+    static size_t find(const char* data, size_t size, uint32_t* positions);
+
+private:
+    using FindFunction = size_t (*)(const char* data, size_t size, uint32_t* positions);
+
+    /// AVX2 variant of find(), or nullptr if the library was built without AVX2 support
+    static const FindFunction AVX2_FIND;
+};
+
+#endif // DELIMITER_SCANNER_H
@@ -0,0 +1,45 @@
+//
+// Created by Petya Licheva on 10/18/2026.
+//
+// AVX2 variant of DelimiterScanner::find(). CMake compiles this file with
+// AVX2 enabled on x86; elsewhere it only defines AVX2_FIND as nullptr.
+// Helpers have internal linkage, so no AVX2 code is shared with the
+// baseline translation units through inline functions.
+//
+
+#include "DelimiterScanner.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+    size_t findAvx2(const char* data, size_t size, uint32_t* positions) {
+        const __m256i semicolons = _mm256_set1_epi8(';');
+        const __m256i newlines = _mm256_set1_epi8('\n');
+        size_t count = 0;
+        size_t i = 0;
+
+        for (; i + 32 <= size; i += 32) {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            const __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, semicolons),
+                                                    _mm256_cmpeq_epi8(bytes, newlines));
+            auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(matches));
+            while (mask != 0) {
+                positions[count++] = static_cast<uint32_t>(i + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+
+        for (; i < size; ++i) {
+            if (data[i] == ';' || data[i] == '\n') {
+                positions[count++] = static_cast<uint32_t>(i);
+            }
+        }
+        return count;
+    }
+}
+
+const DelimiterScanner::FindFunction DelimiterScanner::AVX2_FIND = findAvx2;
+#else
+const DelimiterScanner::FindFunction DelimiterScanner::AVX2_FIND = nullptr;
+#endif
@@ -0,0 +1,860 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "Evaluator.h"
+#include "CoordinateMap.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include "VectorKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    /// Stack size that is served without a heap allocation
+    constexpr size_t INLINE_STACK_SIZE = 32;
+
+    /// Number of cells a worker evaluates before looking for more work
+    constexpr size_t PARALLEL_GRAIN = 256;
+
+    /// Shortest column run that is evaluated as a batch
+    constexpr size_t MIN_BATCH_RUN = 8;
+
+    /// Number of cells of a column run executed together (one stack slot per cell)
+    constexpr size_t BATCH_SIZE = 256;
+
+    double toBool(double value) {
+        return (value >= 1.0) ? 1.0 : 0.0;
+    }
+
+    /**
+     * @brief A list of coordinates borrowed from the calling thread's spare lists.
+     *
+     * getValue() and run() call each other recursively, so every active
+     * call needs a list of its own. Returned lists keep their capacity,
+     * which makes the work lists of an evaluation free of allocations
+     * once the thread has evaluated a few cells.
+     */
+    class ScratchList {
+        std::vector<Coordinates> list; ///< The borrowed list (empty when borrowed)
+
+        static std::vector<std::vector<Coordinates>>& spare() {
+            thread_local std::vector<std::vector<Coordinates>> lists;
+            return lists;
+        }
+
+    public:
+        ScratchList() {
+            std::vector<std::vector<Coordinates>>& lists = spare();
+            if (!lists.empty()) {
+                this->list = std::move(lists.back());
+                lists.pop_back();
+            }
+        }
+
+        ~ScratchList() {
+            this->list.clear();
+            spare().push_back(std::move(this->list));
+        }
+
+        ScratchList(const ScratchList&) = delete;
+        ScratchList& operator=(const ScratchList&) = delete;
+
+        std::vector<Coordinates>& operator*() {
+            return this->list;
+        }
+    };
+}
+
+bool Evaluator::execute(const Program &program, Table &table, Coordinates cellCoordinates,
+                        EvaluationMode mode, double &result, std::vector<Coordinates> &pending) {
+    if (!program.error.empty()) {
+        throw std::runtime_error(program.error);
+    }
+
+    double inlineStack[INLINE_STACK_SIZE];
+    std::vector<double> heapStack;
+    double* stack = inlineStack;
+    if (program.maxStack > INLINE_STACK_SIZE) {
+        heapStack.resize(program.maxStack);
+        stack = heapStack.data();
+    }
+
+    size_t top = 0;
+    const size_t size = program.code.size();
+
+    for (size_t pc = 0; pc < size; ++pc) {
+        const Instruction& instruction = program.code[pc];
+
+        switch (instruction.op) {
+            case OpCode::PushNumber:
+                stack[top++] = instruction.number;
+                break;
+
+            case OpCode::LoadRef: {
+                Coordinates target = instruction.ref.resolve(cellCoordinates);
+
+                if (mode == EvaluationMode::Iterative && !table.isEvaluated(target)) {
+                    if (!table.hasCell(target)) {
+                        throw std::runtime_error("Referenced cell does not exist");
+                    }
+                    if (table.isBeingEvaluated(target)) {
+                        throw std::runtime_error("Circular reference detected");
+                    }
+
+                    pending.push_back(target);
+                    Evaluator::collectPending(program, pc + 1, table, cellCoordinates, pending);
+                    return false;
+                }
+
+                stack[top++] = Evaluator::getValue(table, target, mode);
+                break;
+            }
+
+            case OpCode::Negate:
+                stack[top - 1] = -stack[top - 1];
+                break;
+
+            case OpCode::Not:
+                stack[top - 1] = (stack[top - 1] < 1.0) ? 1.0 : 0.0;
+                break;
+
+            case OpCode::ToBool:
+                stack[top - 1] = toBool(stack[top - 1]);
+                break;
+
+            case OpCode::Add:
+                --top;
+                stack[top - 1] += stack[top];
+                break;
+
+            case OpCode::Sub:
+                --top;
+                stack[top - 1] -= stack[top];
+                break;
+
+            case OpCode::Mul:
+                --top;
+                stack[top - 1] *= stack[top];
+                break;
+
+            case OpCode::Div:
+                --top;
+                if (stack[top] == 0.0) {
+                    throw std::runtime_error("Division by zero");
+                }
+                stack[top - 1] /= stack[top];
+                break;
+
+            case OpCode::Mod:
+                --top;
+                stack[top - 1] = std::fmod(stack[top - 1], stack[top]);
+                break;
+
+            case OpCode::Equal:
+                --top;
+                stack[top - 1] = (stack[top - 1] == stack[top]) ? 1.0 : 0.0;
+                break;
+
+            case OpCode::NotEqual:
+                --top;
+                stack[top - 1] = (stack[top - 1] != stack[top]) ? 1.0 : 0.0;
+                break;
+
+            case OpCode::Less:
+                --top;
+                stack[top - 1] = (stack[top - 1] < stack[top]) ? 1.0 : 0.0;
+                break;
+
+            case OpCode::Greater:
+                --top;
+                stack[top - 1] = (stack[top - 1] > stack[top]) ? 1.0 : 0.0;
+                break;
+
+            case OpCode::Jump:
+                pc = instruction.target - 1;
+                break;
+
+            case OpCode::JumpIfFalse:
+                --top;
+                if (stack[top] < 1.0) {
+                    pc = instruction.target - 1;
+                }
+                break;
+
+            case OpCode::AndJump:
+                if (stack[top - 1] < 1.0) {
+                    stack[top - 1] = 0.0;
+                    pc = instruction.target - 1;
+                } else {
+                    --top;
+                }
+                break;
+
+            case OpCode::OrJump:
+                if (stack[top - 1] >= 1.0) {
+                    stack[top - 1] = 1.0;
+                    pc = instruction.target - 1;
+                } else {
+                    --top;
+                }
+                break;
+
+            case OpCode::Sum:
+            case OpCode::Count:
+            case OpCode::Min:
+            case OpCode::Max:
+            case OpCode::Avg: {
+                Area area(instruction.ref.resolve(cellCoordinates),
+                          instruction.rangeEnd.resolve(cellCoordinates));
+
+                if (mode == EvaluationMode::Iterative) {
+                    const CellStore& cells = table.getCells();
+                    table.forEachCellInArea(area, [&](CellStore::CellId id) {
+                        const EvalState state = cells.state(id);
+                        if (state != EvalState::Evaluated) {
+                            if (state == EvalState::Visiting) {
+                                throw std::runtime_error("Circular reference detected");
+                            }
+                            pending.push_back(cells.position(id));
+                        }
+                    });
+
+                    if (!pending.empty()) {
+                        Evaluator::collectPending(program, pc + 1, table, cellCoordinates, pending);
+                        return false;
+                    }
+                }
+
+                stack[top++] = aggregate(instruction.op, area, table, mode);
+                break;
+            }
+        }
+    }
+
+    result = stack[0];
+    return true;
+}
+
+void Evaluator::collectPending(const Program &program, size_t pc, Table &table,
+                               Coordinates cellCoordinates, std::vector<Coordinates> &pending) {
+    // Collection stops before the first instruction that may throw, so no
+    // cell is evaluated that the program would not reach
+    for (; pc < program.code.size(); ++pc) {
+        const Instruction& instruction = program.code[pc];
+
+        switch (instruction.op) {
+            case OpCode::Jump:
+            case OpCode::JumpIfFalse:
+            case OpCode::AndJump:
+            case OpCode::OrJump:
+            case OpCode::Div:
+            case OpCode::Mod:
+                return;
+
+            case OpCode::LoadRef: {
+                const Coordinates target = instruction.ref.resolve(cellCoordinates);
+                if (!table.hasCell(target) || table.isBeingEvaluated(target)) {
+                    return;
+                }
+                if (!table.isEvaluated(target)) {
+                    pending.push_back(target);
+                }
+                break;
+            }
+
+            case OpCode::Sum:
+            case OpCode::Count:
+            case OpCode::Min:
+            case OpCode::Max:
+            case OpCode::Avg: {
+                const CellStore& cells = table.getCells();
+                bool circular = false;
+                size_t count = 0;
+                table.forEachCellInArea(Area(instruction.ref.resolve(cellCoordinates),
+                                             instruction.rangeEnd.resolve(cellCoordinates)),
+                                        [&](CellStore::CellId id) {
+                    ++count;
+                    const EvalState state = cells.state(id);
+                    if (circular || state == EvalState::Evaluated) {
+                        return;
+                    }
+                    if (state == EvalState::Visiting) {
+                        circular = true;
+                        return;
+                    }
+                    pending.push_back(cells.position(id));
+                });
+
+                const bool emptyArea = count == 0 && instruction.op != OpCode::Sum && instruction.op != OpCode::Count;
+                if (circular || emptyArea) {
+                    return;
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+}
+
+double Evaluator::run(const Program &program, Table &table, Coordinates cellCoordinates,
+                      EvaluationMode mode) {
+    double result = 0.0;
+    ScratchList pendingList;
+    std::vector<Coordinates>& pending = *pendingList;
+
+    while (!Evaluator::execute(program, table, cellCoordinates, mode, result, pending)) {
+        for (const Coordinates& c : pending) {
+            Evaluator::getValue(table, c, EvaluationMode::Iterative);
+        }
+        pending.clear();
+    }
+
+    return result;
+}
+
+double Evaluator::aggregate(OpCode op, const Area &area, Table &table, EvaluationMode mode) {
+    const CellStore& cells = table.getCells();
+    size_t count = 0;
+    double result = 0.0;
+
+    // Evaluated cells are read by id; only the others go through getValue()
+    table.forEachCellInArea(area, [&](CellStore::CellId id) {
+        double value;
+        if (cells.state(id) == EvalState::Evaluated) {
+            PROFILE_LOOKUP(cells.position(id));
+            value = cells.value(id);
+        } else {
+            value = Evaluator::getValue(table, cells.position(id), mode);
+        }
+
+        if (op == OpCode::Min) {
+            result = (count == 0 || value < result) ? value : result;
+        } else if (op == OpCode::Max) {
+            result = (count == 0 || value > result) ? value : result;
+        } else {
+            result += value;
+        }
+        ++count;
+    });
+
+    if (op == OpCode::Count) {
+        return static_cast<double>(count);
+    }
+    if (count == 0 && op != OpCode::Sum) {
+        throw std::runtime_error("Empty area");
+    }
+    if (op == OpCode::Avg) {
+        return result / static_cast<double>(count);
+    }
+    return result;
+}
+
+double Evaluator::getValue(Table &table, Coordinates c, EvaluationMode mode) {
+    // One lookup serves the common case of an already evaluated cell
+    const CellStore& cells = table.getCells();
+    const CellStore::CellId id = cells.find(c);
+
+    if (id == CellStore::NO_CELL) {
+        throw std::runtime_error("Referenced cell does not exist");
+    }
+
+    if (cells.state(id) == EvalState::Visiting) {
+        throw std::runtime_error("Circular reference detected");
+    }
+
+    PROFILE_LOOKUP(c);
+    if (cells.state(id) == EvalState::Evaluated) {
+        return cells.value(id);
+    }
+
+    table.markEvaluating(c);
+
+    if (mode == EvaluationMode::Recursive) {
+        double calculatedValue;
+        try {
+            PROFILE_EVALUATION(c);
+            calculatedValue = Evaluator::run(table.getProgram(c), table, c, mode);
+        } catch (...) {
+            table.clearEvaluationState(c);
+            throw;
+        }
+
+        table.setCachedValue(calculatedValue, c);
+        table.markEvaluated(c);
+
+        return calculatedValue;
+    }
+
+    // Explicit work stack: the top cell is (re)started until all of the
+    // cells it reads have cached values. Cells are marked as visiting only
+    // once they are started, so pending cells may depend on each other.
+    ScratchList workList;
+    ScratchList pendingList;
+    std::vector<Coordinates>& work = *workList;
+    std::vector<Coordinates>& pending = *pendingList;
+    work.push_back(c);
+
+    try {
+        while (!work.empty()) {
+            Coordinates current = work.back();
+            if (table.isEvaluated(current)) {
+                work.pop_back();
+                continue;
+            }
+
+            table.markEvaluating(current);
+
+            double calculatedValue;
+            pending.clear();
+
+            bool completed = false;
+            {
+                PROFILE_EVALUATION(current, work.size() - 1, &completed);
+                completed = Evaluator::execute(table.getProgram(current), table, current,
+                                               mode, calculatedValue, pending);
+            }
+
+            if (completed) {
+                table.setCachedValue(calculatedValue, current);
+                table.markEvaluated(current);
+                work.pop_back();
+            } else {
+                work.insert(work.end(), pending.rbegin(), pending.rend());
+            }
+        }
+    } catch (...) {
+        for (const Coordinates& visiting : work) {
+            table.clearEvaluationState(visiting);
+        }
+        throw;
+    }
+
+    return table.getCachedValue(c);
+}
+
+void Evaluator::recalculate(Table &table, EvaluationMode mode, size_t threadCount) {
+    PROFILE_RECALCULATION();
+    TRACE_SPAN("recalculate", "evaluation");
+
+    if (threadCount > 1) {
+        Evaluator::recalculateParallel(table, mode, threadCount);
+        return;
+    }
+
+    Evaluator::evaluateColumnRuns(table, mode);
+
+    TRACE_SPAN("evaluate cells", "evaluation");
+    const CellStore& store = table.getCells();
+    for (const Coordinates& c : table.getDirtyCells()) {
+        const CellStore::CellId id = store.find(c);
+        if (id == CellStore::NO_CELL || store.state(id) == EvalState::Evaluated) {
+            continue;
+        }
+
+        Evaluator::getValue(table, c, mode);
+    }
+
+    table.clearDirtyCells();
+}
+
+bool Evaluator::isBatchable(const Program &program) {
+    if (!program.error.empty() || program.code.empty()) {
+        return false;
+    }
+
+    for (const Instruction& instruction : program.code) {
+        switch (instruction.op) {
+            case OpCode::Jump:
+            case OpCode::JumpIfFalse:
+            case OpCode::AndJump:
+            case OpCode::OrJump:
+            case OpCode::Sum:
+            case OpCode::Count:
+            case OpCode::Min:
+            case OpCode::Max:
+            case OpCode::Avg:
+                return false;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+void Evaluator::evaluateColumnRuns(Table &table, EvaluationMode mode) {
+    TRACE_SPAN("column runs", "evaluation");
+    const CellStore& store = table.getCells();
+    std::vector<CellStore::CellId> ids(BATCH_SIZE);
+
+    auto isPending = [&](CellStore::CellId id, FormulaPool::FormulaId formula) {
+        return id != CellStore::NO_CELL && store.formula(id) == formula &&
+               store.state(id) == EvalState::Dirty;
+    };
+
+    for (const Coordinates& head : table.getDirtyCells()) {
+        const CellStore::CellId headId = store.find(head);
+        if (headId == CellStore::NO_CELL || store.state(headId) != EvalState::Dirty) {
+            continue;
+        }
+
+        // Only the topmost dirty cell of a run starts it
+        const FormulaPool::FormulaId formula = store.formula(headId);
+        if (isPending(store.find({head.row - 1, head.col}), formula)) {
+            continue;
+        }
+
+        const Program& program = store.getFormulas().program(formula);
+        if (!Evaluator::isBatchable(program)) {
+            continue;
+        }
+
+        // The run extends down while the cells share the formula and are dirty
+        size_t count = 1;
+        bool extends = true;
+        while (extends) {
+            const int64_t row = head.row + static_cast<int64_t>(count);
+            store.findColumn(head.col, row, BATCH_SIZE, ids.data());
+
+            size_t k = 0;
+            while (k < BATCH_SIZE && isPending(ids[k], formula)) {
+                ++k;
+            }
+            count += k;
+            extends = k == BATCH_SIZE;
+        }
+
+        if (count < MIN_BATCH_RUN) {
+            continue;
+        }
+
+        // A run that reads its own cells has to be evaluated in order
+        const int64_t lastRow = head.row + static_cast<int64_t>(count) - 1;
+        bool readsItself = false;
+
+        for (const Instruction& instruction : program.code) {
+            if (instruction.op != OpCode::LoadRef) {
+                continue;
+            }
+            const Coordinates top = instruction.ref.resolve(head);
+            const Coordinates bottom = instruction.ref.resolve({lastRow, head.col});
+            if (top.col == head.col && top.row <= lastRow && bottom.row >= head.row) {
+                readsItself = true;
+                break;
+            }
+        }
+
+        if (!readsItself) {
+            PROFILE_BATCH(head.col, head.row, count);
+            Evaluator::evaluateRun(table, program, head.col, head.row, count, mode);
+        }
+    }
+}
+
+void Evaluator::evaluateRun(Table &table, const Program &program, int64_t col,
+                            int64_t firstRow, size_t count, EvaluationMode mode) {
+    const CellStore& store = table.getCells();
+
+    // Every distinct reference is gathered once per block into its own input
+    std::vector<CellReference> references;
+    std::vector<size_t> inputOf(program.code.size(), 0);
+    for (size_t pc = 0; pc < program.code.size(); ++pc) {
+        const Instruction& instruction = program.code[pc];
+        if (instruction.op != OpCode::LoadRef) {
+            continue;
+        }
+
+        size_t k = 0;
+        while (k < references.size() &&
+               !(references[k].row == instruction.ref.row && references[k].col == instruction.ref.col &&
+                 references[k].rowRelative == instruction.ref.rowRelative &&
+                 references[k].colRelative == instruction.ref.colRelative)) {
+            ++k;
+        }
+        if (k == references.size()) {
+            references.push_back(instruction.ref);
+        }
+        inputOf[pc] = k;
+    }
+
+    // Stack slot k of the block is stack[k * BATCH_SIZE .. (k + 1) * BATCH_SIZE),
+    // input k is inputs[k * BATCH_SIZE .. (k + 1) * BATCH_SIZE)
+    std::vector<double> stack(program.maxStack * BATCH_SIZE);
+    std::vector<double> inputs(references.size() * BATCH_SIZE);
+    std::vector<CellStore::CellId> ids(BATCH_SIZE);
+    std::vector<CellStore::CellId> runIds(BATCH_SIZE);
+    auto slot = [&](size_t k) {
+        return stack.data() + k * BATCH_SIZE;
+    };
+
+    for (size_t begin = 0; begin < count; begin += BATCH_SIZE) {
+        const size_t n = std::min(BATCH_SIZE, count - begin);
+        const int64_t blockRow = firstRow + static_cast<int64_t>(begin);
+
+        try {
+            for (size_t k = 0; k < references.size(); ++k) {
+                const CellReference& ref = references[k];
+                const Coordinates top = ref.resolve({blockRow, col});
+                double* values = inputs.data() + k * BATCH_SIZE;
+
+                // A relative row reads a vertical run, an absolute row one cell
+                if (ref.rowRelative) {
+                    store.findColumn(top.col, top.row, n, ids.data());
+                } else {
+                    std::fill(ids.begin(), ids.begin() + static_cast<std::ptrdiff_t>(n), store.find(top));
+                }
+
+                for (size_t i = 0; i < n; ++i) {
+                    const CellStore::CellId id = ids[i];
+                    if (id != CellStore::NO_CELL && store.state(id) == EvalState::Evaluated) {
+                        values[i] = store.value(id);
+                    } else {
+                        const Coordinates target(ref.rowRelative ? top.row + static_cast<int64_t>(i) : top.row,
+                                                 top.col);
+                        values[i] = Evaluator::getValue(table, target, mode);
+                    }
+                }
+            }
+
+            size_t top = 0;
+
+            for (size_t pc = 0; pc < program.code.size(); ++pc) {
+                const Instruction& instruction = program.code[pc];
+
+                switch (instruction.op) {
+                    case OpCode::PushNumber:
+                        VectorKernels::fill(slot(top++), instruction.number, n);
+                        break;
+
+                    case OpCode::LoadRef: {
+                        const double* values = inputs.data() + inputOf[pc] * BATCH_SIZE;
+                        std::copy(values, values + n, slot(top++));
+                        break;
+                    }
+
+                    case OpCode::Negate:
+                        VectorKernels::negate(slot(top - 1), n);
+                        break;
+
+                    case OpCode::Not:
+                        VectorKernels::logicalNot(slot(top - 1), n);
+                        break;
+
+                    case OpCode::ToBool:
+                        VectorKernels::toBool(slot(top - 1), n);
+                        break;
+
+                    case OpCode::Add:
+                        --top;
+                        VectorKernels::add(slot(top - 1), slot(top), n);
+                        break;
+
+                    case OpCode::Sub:
+                        --top;
+                        VectorKernels::sub(slot(top - 1), slot(top), n);
+                        break;
+
+                    case OpCode::Mul:
+                        --top;
+                        VectorKernels::mul(slot(top - 1), slot(top), n);
+                        break;
+
+                    case OpCode::Div:
+                        --top;
+                        if (VectorKernels::hasZero(slot(top), n)) {
+                            throw std::runtime_error("Division by zero");
+                        }
+                        VectorKernels::div(slot(top - 1), slot(top), n);
+                        break;
+
+                    case OpCode::Mod:
+                        --top;
+                        VectorKernels::mod(slot(top - 1), slot(top), n);
+                        break;
+
+                    case OpCode::Equal:
+                        --top;
+                        VectorKernels::equal(slot(top - 1), slot(top), n);
+                        break;
+
+                    case OpCode::NotEqual:
+                        --top;
+                        VectorKernels::notEqual(slot(top - 1), slot(top), n);
+                        break;
+
+                    case OpCode::Less:
+                        --top;
+                        VectorKernels::less(slot(top - 1), slot(top), n);
+                        break;
+
+                    case OpCode::Greater:
+                        --top;
+                        VectorKernels::greater(slot(top - 1), slot(top), n);
+                        break;
+
+                    default:
+                        throw std::logic_error("Instruction cannot be executed as a batch");
+                }
+            }
+        } catch (const std::runtime_error&) {
+            // Per-cell evaluation reports the error for the failing cell
+            for (size_t i = 0; i < n; ++i) {
+                Evaluator::getValue(table, {blockRow + static_cast<int64_t>(i), col}, mode);
+            }
+            continue;
+        }
+
+        const double* results = slot(0);
+        store.findColumn(col, blockRow, n, runIds.data());
+        for (size_t i = 0; i < n; ++i) {
+            table.storeResult(runIds[i], results[i]);
+        }
+    }
+}
+
+void Evaluator::recalculateParallel(Table &table, EvaluationMode mode, size_t threadCount) {
+    Trace::Span schedule("schedule levels", "evaluation");
+
+    // Unique dirty cells that still need a value
+    std::vector<Coordinates> cells;
+    CoordinateMap<size_t> index;
+
+    for (const Coordinates& c : table.getDirtyCells()) {
+        if (!table.hasCell(c) || table.isEvaluated(c) || !index.tryEmplace(c, cells.size()).second) {
+            continue;
+        }
+        cells.push_back(c);
+    }
+
+    // Edges between dirty cells in compressed form: the dependents of
+    // cell i are dependents[offsets[i] .. offsets[i + 1])
+    std::vector<size_t> waiting(cells.size(), 0);
+    std::vector<size_t> offsets(cells.size() + 1, 0);
+    std::vector<std::pair<size_t, size_t>> edges;
+
+    for (size_t i = 0; i < cells.size(); ++i) {
+        std::vector<Coordinates> precedents = table.getPrecedents(cells[i]);
+        std::sort(precedents.begin(), precedents.end());
+        precedents.erase(std::unique(precedents.begin(), precedents.end()), precedents.end());
+
+        for (const Coordinates& precedent : precedents) {
+            if (const size_t* j = index.find(precedent)) {
+                edges.emplace_back(*j, i);
+                ++offsets[*j + 1];
+                ++waiting[i];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < cells.size(); ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    std::vector<size_t> dependents(edges.size());
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (const auto& [from, to] : edges) {
+        dependents[fill[from]++] = to;
+    }
+
+    // Dependency levels (Kahn's algorithm): order[levels[k] .. levels[k + 1])
+    // holds the cells of level k
+    std::vector<size_t> order;
+    std::vector<size_t> levels = {0};
+    order.reserve(cells.size());
+
+    for (size_t i = 0; i < cells.size(); ++i) {
+        if (waiting[i] == 0) {
+            order.push_back(i);
+        }
+    }
+
+    while (levels.back() < order.size()) {
+        size_t begin = levels.back();
+        size_t end = order.size();
+
+        for (size_t k = begin; k < end; ++k) {
+            size_t i = order[k];
+            for (size_t e = offsets[i]; e < offsets[i + 1]; ++e) {
+                if (--waiting[dependents[e]] == 0) {
+                    order.push_back(dependents[e]);
+                }
+            }
+        }
+
+        levels.push_back(end);
+    }
+
+    schedule.end();
+
+    ThreadPool& pool = ThreadPool::forCurrentThread(threadCount);
+    std::vector<std::exception_ptr> errors(cells.size());
+    std::vector<char> deferred(cells.size(), 0);
+
+    for (size_t level = 0; level + 1 < levels.size(); ++level) {
+        const size_t first = levels[level];
+        const size_t count = levels[level + 1] - first;
+        TRACE_SPAN("level", "evaluation");
+
+        pool.parallelFor(count, PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+            TRACE_SPAN("evaluate chunk", "evaluation");
+            ScratchList pendingList;
+            std::vector<Coordinates>& pending = *pendingList;
+
+            for (size_t k = begin; k < end; ++k) {
+                const size_t i = order[first + k];
+                const Coordinates& c = cells[i];
+
+                if (table.isEvaluated(c)) {
+                    continue;
+                }
+
+                try {
+                    double value;
+                    pending.clear();
+
+                    bool completed = false;
+                    {
+                        PROFILE_EVALUATION(c, 0, &completed);
+                        completed = Evaluator::execute(table.getProgram(c), table, c,
+                                                       EvaluationMode::Iterative, value, pending);
+                    }
+
+                    if (completed) {
+                        table.setCachedValue(value, c);
+                        table.markEvaluated(c);
+                    } else {
+                        deferred[i] = 1;
+                    }
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        });
+
+        // Errors are reported and deferred cells evaluated in schedule order
+        for (size_t k = first; k < first + count; ++k) {
+            const size_t i = order[k];
+            if (errors[i]) {
+                std::rethrow_exception(errors[i]);
+            }
+            if (deferred[i] && !table.isEvaluated(cells[i])) {
+                Evaluator::getValue(table, cells[i], mode);
+            }
+        }
+    }
+
+    // Cells on reference cycles never reached a level
+    for (const Coordinates& c : cells) {
+        if (!table.isEvaluated(c)) {
+            Evaluator::getValue(table, c, mode);
+        }
+    }
+
+    table.clearDirtyCells();
+}
@@ -0,0 +1,206 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include "Table.h"
+
+/**
+ * @brief Executes compiled expression programs in the context of a table.
+ *
+ * The Evaluator runs the programs produced by the ExpressionParser.
+ * Referenced cells are evaluated on demand, their results are cached
+ * in the table, and circular references are detected through the
+ * evaluation state stored in the table.
+ *
+ * In the iterative mode a program that reaches a reference to a cell
+ * without a cached value is suspended, the referenced cell is pushed on
+ * an explicit work stack, and the program is restarted once that cell is
+ * evaluated. Each pending link costs one Coordinates entry, so reference
+ * chains of any length evaluate in bounded native stack space.
+ */
+class Evaluator {
+    /**
+     * @brief Executes a program once.
+     *
+     * In the recursive mode referenced cells are evaluated through
+     * getValue(). In the iterative mode execution stops at the first
+     * referenced cell that has no cached value; the cells without a
+     * cached value read by the following straight-line instructions (up
+     * to the next jump) are collected as well, so a restart after they
+     * are evaluated does not stop again at each of them.
+     *
+     * @param program Program to execute
+     * @param table Table providing referenced cell values
+     * @param cellCoordinates Coordinates of the evaluated cell
+     * @param mode Evaluation mode
+     * @param result Receives the result when the program completes
+     * @param pending Receives the referenced cells that have to be evaluated first
+     * @return true if the program completed, false if it was suspended
+     */
+    static bool execute(const Program& program, Table& table, Coordinates cellCoordinates,
+                        EvaluationMode mode, double& result, std::vector<Coordinates>& pending);
+
+    /**
+     * @brief Collects the cells without a cached value read before the next jump.
+     *
+     * These instructions run unconditionally once the program reaches
+     * `pc`. Collection also stops at the first instruction that may
+     * throw: a division or remainder, a reference to a cell that does not
+     * exist or is being evaluated, or min, max or avg of an empty area.
+     * Cells behind it are left to the restarted program, so iterative
+     * mode evaluates the same cells as recursive mode and raises the
+     * same first error.
+     *
+     * @param program Suspended program
+     * @param pc First instruction to inspect
+     * @param table Table containing the cells
+     * @param cellCoordinates Coordinates of the evaluated cell
+     * @param pending Receives the cells to evaluate before the restart
+     */
+    static void collectPending(const Program& program, size_t pc, Table& table,
+                               Coordinates cellCoordinates, std::vector<Coordinates>& pending);
+
+    /**
+     * @brief Recalculates the dirty cells of a table on several threads.
+     *
+     * The dirty cells are ordered into dependency levels: a cell is placed
+     * one level above the highest dirty cell it references. The cells of
+     * one level do not depend on each other and are evaluated in parallel;
+     * levels are processed in order. Cells that read a cell outside the
+     * schedule, and cells on reference cycles, are evaluated serially.
+     * The workers come from ThreadPool::forCurrentThread(), so they are
+     * started once and reused by later recalculations.
+     *
+     * @param table Table to recalculate
+     * @param mode Evaluation mode used for the serial fallback
+     * @param threadCount Number of threads, including the caller
+     */
+    static void recalculateParallel(Table& table, EvaluationMode mode, size_t threadCount);
+
+    /**
+     * @brief Checks whether a program can be executed as a batch kernel.
+     *
+     * Batch execution supports straight-line programs: numbers, cell
+     * references, arithmetic, comparisons and negations. Programs with
+     * jumps (if, and, or) or aggregates are executed one cell at a time.
+     *
+     * @param program Program to check
+     * @return true if the program can run over a whole column run
+     */
+    static bool isBatchable(const Program& program);
+
+    /**
+     * @brief Evaluates the dirty column runs of repeated formulas.
+     *
+     * A column run is a sequence of vertically adjacent dirty cells that
+     * share one formula (see FormulaPool). Runs of batchable programs
+     * that do not read their own cells are evaluated by evaluateRun();
+     * all other cells are left for the per-cell path.
+     *
+     * @param table Table to recalculate
+     * @param mode Evaluation mode used for referenced cells
+     */
+    static void evaluateColumnRuns(Table& table, EvaluationMode mode);
+
+    /**
+     * @brief Evaluates a column run of one formula as a batch.
+     *
+     * The program is executed instruction by instruction over blocks of
+     * cells: every stack slot holds one value per cell, references are
+     * gathered into a slot, and operations run as vector kernels over the
+     * slots. If a block fails (for example on a division by zero), its
+     * cells are evaluated one at a time, which reports the error for the
+     * same cell and with the same message as the per-cell path.
+     *
+     * @param table Table containing the run
+     * @param program Program shared by the cells of the run
+     * @param col Column of the run
+     * @param firstRow Row of the first cell of the run
+     * @param count Number of cells in the run
+     * @param mode Evaluation mode used for referenced cells
+     */
+    static void evaluateRun(Table& table, const Program& program, int64_t col,
+                            int64_t firstRow, size_t count, EvaluationMode mode);
+
+public:
+    /**
+     * @brief Aggregates the values of the existing cells in an area.
+     *
+     * Only cells that exist are visited. Empty areas yield 0 for sum and
+     * count; min, max and avg of an empty area are errors. This is the
+     * one implementation of the aggregate functions, used both by
+     * programs and by the Table::sum() family of helpers.
+     *
+     * @param op One of Sum, Count, Min, Max, Avg
+     * @param area Aggregated area
+     * @param table Table containing the cells
+     * @param mode Evaluation mode used for cells without a cached value
+     * @return Aggregated value
+     *
+     * @throws std::runtime_error for min, max or avg of an empty area, or
+     *         if a cell in the area cannot be evaluated
+     */
+    static double aggregate(OpCode op, const Area& area, Table& table, EvaluationMode mode);
+
+    /**
+     * @brief Runs a compiled program.
+     *
+     * @param program Program to execute
+     * @param table Table providing referenced cell values
+     * @param cellCoordinates Coordinates of the evaluated cell, used to
+     *        resolve relative references
+     * @param mode How referenced cells are evaluated (default: Iterative)
+     * @return Numeric result of the program
+     *
+     * @throws std::runtime_error on compilation errors stored in the program,
+     *         division by zero, missing or circular references
+     */
+    static double run(const Program& program, Table& table, Coordinates cellCoordinates,
+                      EvaluationMode mode = EvaluationMode::Iterative);
+
+    /**
+     * @brief Retrieves the value of a cell, evaluating it if necessary.
+     *
+     * The cell's compiled program is executed only if the cell has no
+     * valid cached value. The computed value is cached in the table.
+     *
+     * @param table Table containing the cell
+     * @param c Cell coordinates
+     * @param mode How referenced cells are evaluated (default: Iterative)
+     * @return Numeric value of the cell
+     *
+     * @throws std::runtime_error if the cell does not exist, takes part
+     *         in a circular reference, or its expression cannot be evaluated
+     */
+    static double getValue(Table& table, Coordinates c,
+                           EvaluationMode mode = EvaluationMode::Iterative);
+
+    /**
+     * @brief Recalculates all dirty cells of a table.
+     *
+     * Only cells changed since the last recalculation and their transitive
+     * dependents are evaluated; all other cached values are reused. If a
+     * cell fails to evaluate, the error is propagated and the remaining
+     * cells stay dirty.
+     *
+     * In the serial path, column runs of cells that share a straight-line
+     * formula are first evaluated as batches with vector kernels (see
+     * evaluateColumnRuns()); the values are the same as per cell.
+     *
+     * With more than one thread the cells are evaluated level by level
+     * of the dependency graph on a work-stealing thread pool. Every cell
+     * is computed by the same program as in the serial path, so the
+     * results are identical.
+     *
+     * @param table Table to recalculate
+     * @param mode How referenced cells are evaluated (default: Iterative)
+     * @param threadCount Number of threads to use (default: 1)
+     */
+    static void recalculate(Table& table, EvaluationMode mode = EvaluationMode::Iterative,
+                            size_t threadCount = 1);
+};
+
+#endif // EVALUATOR_H
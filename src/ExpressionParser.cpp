@@ -3,158 +3,153 @@
 //
 
 #include "ExpressionParser.h"
-#include <cmath>
+#include "Evaluator.h"
+#include <array>
+#include <stdexcept>
+#include <string_view>
 #include <utility>
 
-void ExpressionParser::advance() {
-    this->currentToken = this->tokenizer.next();
+namespace {
+    /// Aggregation functions and the operations they compile to
+    constexpr std::array<std::pair<std::string_view, OpCode>, 5> AGGREGATES = {{
+        {"sum", OpCode::Sum},
+        {"count", OpCode::Count},
+        {"min", OpCode::Min},
+        {"max", OpCode::Max},
+        {"avg", OpCode::Avg}
+    }};
+
+    /**
+     * @brief Looks up an aggregation function by name.
+     *
+     * @param name Identifier lexeme
+     * @return The function's operation, or nullptr if the name is not an aggregate
+     */
+    const OpCode* findAggregate(std::string_view name) {
+        for (const auto& [aggregate, op] : AGGREGATES) {
+            if (aggregate == name) {
+                return &op;
+            }
+        }
+        return nullptr;
+    }
 }
 
-ExpressionParser::ExpressionParser(const Tokenizer &tokenizer, Token token,
-                                   Table &table,
-                                   const Coordinates &currentCellCoordinates) : tokenizer(tokenizer),
-    currentToken(std::move(token)), table(table), currentCellCoordinates(currentCellCoordinates) {
+void ExpressionParser::advance() {
+    this->currentToken = this->tokenizer.next();
 }
 
-double ExpressionParser::evaluate(const std::string &expression,
-                                  Table &table,
-                                  Coordinates cellCoordinates) {
-    Tokenizer tokenizer(expression);
-
-    Token first = tokenizer.next();
-
-    ExpressionParser parser(tokenizer, first, table, cellCoordinates);
+size_t ExpressionParser::emit(const Instruction &instruction, int stackEffect) {
+    this->program.code.push_back(instruction);
 
-    double result = parser.parseExpression();
+    this->depth += stackEffect;
+    this->program.maxStack = std::max(this->program.maxStack, this->depth);
 
-    if (parser.currentToken.type != TokenType::End) {
-        throw std::runtime_error("Unexpected token after end of expression");
-    }
+    return this->program.code.size() - 1;
+}
 
-    return result;
+void ExpressionParser::patchJump(size_t jumpIndex) {
+    this->program.code[jumpIndex].target = this->program.code.size();
 }
 
-bool ExpressionParser::hasCell(Coordinates c) const {
-    return this->table.getCells().find(c) != table.getCells().end();
+ExpressionParser::ExpressionParser(const Tokenizer &tokenizer, Token token,
+                                   Program &program) : tokenizer(tokenizer),
+    currentToken(std::move(token)), program(program), depth(0) {
 }
 
-double ExpressionParser::getValue(Coordinates c) const {
-    if (table.isBeingEvaluated(c)) {
-        throw std::runtime_error("Circular reference detected");
-    }
+Program ExpressionParser::compile(std::string_view expression) {
+    // Instructions are emitted into a buffer reused by every compilation on
+    // this thread, so the program's code is allocated once, at its final size
+    thread_local Program scratch;
+    scratch.code.clear();
+    scratch.maxStack = 0;
 
-    if (table.isEvaluated(c)) {
-        return table.getCachedValue(c);
-    }
+    Tokenizer tokenizer(expression);
 
-    table.markEvaluating(c);
+    Token first = tokenizer.next();
 
-    const auto& cell = table.getCells().at(c);
+    ExpressionParser parser(tokenizer, first, scratch);
 
-    double calculatedValue = ExpressionParser::evaluate(
-        cell.expression,
-        table,
-        c
-    );
+    parser.parseExpression();
 
-    if(table.getCachedValue(c) == calculatedValue) {
-        return calculatedValue;
+    if (parser.currentToken.type != TokenType::End) {
+        throw std::runtime_error("Unexpected token after end of expression");
     }
 
-    table.markEvaluated(c);
-    table.setCachedValue(calculatedValue, c);
-
-    return calculatedValue;
+    Program program;
+    program.code.assign(scratch.code.begin(), scratch.code.end());
+    program.maxStack = scratch.maxStack;
+    return program;
 }
 
-const std::string &ExpressionParser::getExpression(Coordinates c) const {
-    return this->table.getCells().at(c).expression;
+double ExpressionParser::evaluate(std::string_view expression,
+                                  Table &table,
+                                  Coordinates cellCoordinates) {
+    return Evaluator::run(ExpressionParser::compile(expression), table, cellCoordinates);
 }
 
-double ExpressionParser::parseExpression() {
-    return parseLogicalOr();
+void ExpressionParser::parseExpression() {
+    parseLogicalOr();
 }
 
-double ExpressionParser::parseLogicalOr() {
-    double left = parseLogicalAnd();
+void ExpressionParser::parseLogicalOr() {
+    parseLogicalAnd();
 
     while (currentToken.type == TokenType::Identifier &&
            currentToken.lexeme == "or") {
         advance();
 
-        if (left >= 1.0) {
-            parseLogicalAnd();
-            left = 1.0;
-        } else {
-            double right = parseEquality();
-            left = (right >= 1.0) ? 1.0 : 0.0;
-        }
+        size_t jump = emit(Instruction(OpCode::OrJump), -1);
+        parseLogicalAnd();
+        emit(Instruction(OpCode::ToBool), 0);
+        patchJump(jump);
     }
-
-    return left;
 }
 
-double ExpressionParser::parseLogicalAnd() {
-    double left = parseEquality();
+void ExpressionParser::parseLogicalAnd() {
+    parseEquality();
 
     while (currentToken.type == TokenType::Identifier &&
            currentToken.lexeme == "and") {
         advance();
 
-        if (left < 1.0) {
-            parseEquality();
-            left = 0.0;
-        } else {
-            double right = parseEquality();
-            left = (right >= 1.0) ? 1.0 : 0.0;
-        }
+        size_t jump = emit(Instruction(OpCode::AndJump), -1);
+        parseEquality();
+        emit(Instruction(OpCode::ToBool), 0);
+        patchJump(jump);
     }
-
-    return left;
 }
 
-double ExpressionParser::parseEquality() {
-    double left = parseComparison();
+void ExpressionParser::parseEquality() {
+    parseComparison();
 
     while (currentToken.type == TokenType::Equal ||
            currentToken.type == TokenType::NotEqual) {
         TokenType op = currentToken.type;
         advance();
 
-        double right = parseComparison();
+        parseComparison();
 
-        if (op == TokenType::Equal) {
-            left = (left == right) ? 1.0 : 0.0;
-        } else {
-            left = (left != right) ? 1.0 : 0.0;
-        }
+        emit(Instruction(op == TokenType::Equal ? OpCode::Equal : OpCode::NotEqual), -1);
     }
-
-    return left;
 }
 
-double ExpressionParser::parseComparison() {
-    double left = parseTerm();
+void ExpressionParser::parseComparison() {
+    parseTerm();
 
     while (currentToken.type == TokenType::Less ||
            currentToken.type == TokenType::Greater) {
         TokenType op = currentToken.type;
         advance();
 
-        double right = parseTerm();
+        parseTerm();
 
-        if (op == TokenType::Less) {
-            left = (left < right) ? 1.0 : 0.0;
-        } else {
-            left = (left > right) ? 1.0 : 0.0;
-        }
+        emit(Instruction(op == TokenType::Less ? OpCode::Less : OpCode::Greater), -1);
     }
-
-    return left;
 }
 
-double ExpressionParser::parseTerm() {
-    double left = parseFactor();
+void ExpressionParser::parseTerm() {
+    parseFactor();
 
     while (currentToken.type == TokenType::Plus ||
            currentToken.type == TokenType::Minus) {
@@ -162,20 +157,14 @@ double ExpressionParser::parseTerm() {
         TokenType op = currentToken.type;
         advance();
 
-        double right = parseFactor();
+        parseFactor();
 
-        if (op == TokenType::Plus) {
-            left += right;
-        } else {
-            left -= right;
-        }
-           }
-
-    return left;
+        emit(Instruction(op == TokenType::Plus ? OpCode::Add : OpCode::Sub), -1);
+    }
 }
 
-double ExpressionParser::parseFactor() {
-    double left = parseUnary();
+void ExpressionParser::parseFactor() {
+    parseUnary();
 
     while (currentToken.type == TokenType::Mul ||
            currentToken.type == TokenType::Div ||
@@ -184,71 +173,79 @@ double ExpressionParser::parseFactor() {
         TokenType op = currentToken.type;
         advance();
 
-        double right = parseUnary();
+        parseUnary();
 
         if (op == TokenType::Mul) {
-            left *= right;
+            emit(Instruction(OpCode::Mul), -1);
         } else if (op == TokenType::Div) {
-            if (right == 0.0) {
-                throw std::runtime_error("Division by zero");
-            }
-            left /= right;
+            emit(Instruction(OpCode::Div), -1);
         } else {
-            left = std::fmod(left, right);
+            emit(Instruction(OpCode::Mod), -1);
         }
-           }
-
-    return left;
+    }
 }
 
-double ExpressionParser::parseUnary() {
+void ExpressionParser::parseUnary() {
     if (currentToken.type == TokenType::Minus) {
         advance();
-        return -parseUnary();
+        parseUnary();
+        emit(Instruction(OpCode::Negate), 0);
+        return;
     }
 
     if (currentToken.type == TokenType::Identifier &&
         currentToken.lexeme == "not") {
         advance();
-        double value = parseUnary();
-        return (value < 1.0) ? 1.0 : 0.0;
-        }
+        parseUnary();
+        emit(Instruction(OpCode::Not), 0);
+        return;
+    }
 
-    return parsePrimary();
+    parsePrimary();
 }
 
-double ExpressionParser::parsePrimary() {
+void ExpressionParser::parsePrimary() {
     if (currentToken.type == TokenType::Number) {
-        double value = std::stod(currentToken.lexeme);
+        Instruction instruction(OpCode::PushNumber);
+        instruction.number = currentToken.number;
         advance();
-        return value;
+        emit(instruction, 1);
+        return;
     }
 
     if (currentToken.type == TokenType::CellRef) {
-        return parseCellReference();
+        parseCellReference();
+        return;
     }
 
     if (currentToken.type == TokenType::Identifier &&
         currentToken.lexeme == "if") {
-        return parseIf();
-        }
+        parseIf();
+        return;
+    }
+
+    if (currentToken.type == TokenType::Identifier &&
+        findAggregate(currentToken.lexeme) != nullptr) {
+        parseAggregate();
+        return;
+    }
 
     if (currentToken.type == TokenType::LParen) {
         advance();
-        double value = parseExpression();
+        parseExpression();
 
         if (currentToken.type != TokenType::RParen) {
             throw std::runtime_error("Expected ')'");
         }
 
         advance();
-        return value;
+        return;
     }
 
     throw std::runtime_error("Invalid primary expression");
 }
 
-double ExpressionParser::parseIf() {
+void ExpressionParser::parseIf() {
     advance();
 
     if (currentToken.type != TokenType::LParen) {
@@ -256,103 +253,75 @@ double ExpressionParser::parseIf() {
     }
     advance();
 
-    double condition = parseExpression();
+    parseExpression();
 
     if (currentToken.type != TokenType::Comma) {
         throw std::runtime_error("Expected ',' after condition");
     }
     advance();
 
-    double trueBranch;
-    double falseBranch;
+    size_t toFalseBranch = emit(Instruction(OpCode::JumpIfFalse), -1);
 
-    if (condition >= 1.0) {
-        trueBranch = parseExpression();
+    parseExpression();
 
-        if (currentToken.type != TokenType::Comma) {
-            throw std::runtime_error("Expected ',' in if");
-        }
-        advance();
-
-        parseExpression();
-    } else {
-        parseExpression();
+    if (currentToken.type != TokenType::Comma) {
+        throw std::runtime_error("Expected ',' in if");
+    }
+    advance();
 
-        if (currentToken.type != TokenType::Comma) {
-            throw std::runtime_error("Expected ',' in if");
-        }
-        advance();
+    size_t toEnd = emit(Instruction(OpCode::Jump), 0);
+    patchJump(toFalseBranch);
 
-        falseBranch = parseExpression();
-    }
+    // Only one of the branches leaves its value on the stack
+    --this->depth;
+    parseExpression();
 
     if (currentToken.type != TokenType::RParen) {
         throw std::runtime_error("Expected ')'");
     }
     advance();
 
-    return (condition >= 1.0) ? trueBranch : falseBranch;
+    patchJump(toEnd);
 }
 
-int64_t ExpressionParser::parseCoordPart(const std::string& s, size_t& pos, bool& isRelative) {
-    if (s[pos] == '[') {
-        isRelative = true;
-        ++pos;
-
-        size_t start = pos;
-        if (s[pos] == '-') ++pos;
-        while (pos < s.size() && std::isdigit(s[pos])) ++pos;
-
-        int64_t value = std::stoll(s.substr(start, pos - start));
+void ExpressionParser::parseAggregate() {
+    Instruction instruction(*findAggregate(currentToken.lexeme));
+    advance();
 
-        if (pos >= s.size() || s[pos] != ']') {
-            throw std::runtime_error("Invalid relative coordinate");
-        }
-        ++pos;
-        return value;
-    } else {
-        isRelative = false;
-        size_t start = pos;
-        while (pos < s.size() && std::isdigit(s[pos])) ++pos;
-        return std::stoll(s.substr(start, pos - start));
+    if (currentToken.type != TokenType::LParen) {
+        throw std::runtime_error("Expected '(' after function name");
     }
-}
-
-double ExpressionParser::parseCellReference() {
-    std::string ref = currentToken.lexeme;
     advance();
 
-    size_t pos = 0;
-
-    if (ref[pos] != 'R') {
-        throw std::runtime_error("Invalid cell reference");
+    if (currentToken.type != TokenType::CellRef) {
+        throw std::runtime_error("Expected a cell area");
     }
-    ++pos;
-
-    bool rowRelative = false;
-    int64_t rowValue = ExpressionParser::parseCoordPart(ref, pos, rowRelative);
+    instruction.ref = currentToken.reference;
+    advance();
 
-    if (pos >= ref.size() || ref[pos] != 'C') {
-        throw std::runtime_error("Invalid cell reference");
+    if (currentToken.type != TokenType::Colon) {
+        throw std::runtime_error("Expected ':' in cell area");
     }
-    ++pos;
-
-    bool colRelative = false;
-    int64_t colValue = ExpressionParser::parseCoordPart(ref, pos, colRelative);
+    advance();
 
-    Coordinates target;
+    if (currentToken.type != TokenType::CellRef) {
+        throw std::runtime_error("Expected a cell area");
+    }
+    instruction.rangeEnd = currentToken.reference;
+    advance();
 
-    target.row = rowRelative
-        ? currentCellCoordinates.row + rowValue
-        : rowValue;
+    if (currentToken.type != TokenType::RParen) {
+        throw std::runtime_error("Expected ')'");
+    }
+    advance();
 
-    target.col = colRelative
-        ? currentCellCoordinates.col + colValue
-        : colValue;
+    emit(instruction, 1);
+}
 
-    if (!hasCell(target)) {
-        throw std::runtime_error("Referenced cell does not exist");
-    }
+void ExpressionParser::parseCellReference() {
+    Instruction instruction(OpCode::LoadRef);
+    instruction.ref = currentToken.reference;
+    advance();
 
-    return getValue(target);
+    emit(instruction, 1);
 }
\ No newline at end of file
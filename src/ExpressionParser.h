@@ -9,18 +9,19 @@
 #include "Tokenizer.h"
 
 /**
- * @brief Evaluates arithmetic, logical, and functional expressions used in table cells.
+ * @brief Compiles arithmetic, logical, and functional expressions used in table cells.
  *
  * ExpressionParser implements a recursive-descent parser that respects
- * operator precedence and associativity. It evaluates expressions in the
- * context of a table, allowing access to other cells via absolute and
- * relative references.
+ * operator precedence and associativity. Instead of computing values
+ * while parsing, it emits a Program that the Evaluator executes in the
+ * context of a table, so an expression is lexed and parsed only once
+ * no matter how many times it is evaluated.
  */
 class ExpressionParser {
     Tokenizer tokenizer;                 ///< Token stream for the expression
     Token currentToken;                  ///< Currently processed token
-    Table& table;                        ///< Table used to resolve cell references
-    Coordinates currentCellCoordinates;  ///< Coordinates of the evaluated cell
+    Program& program;                    ///< Program being emitted
+    size_t depth;                        ///< Current depth of the evaluation stack
 
     /**
      * @brief Advances to the next token in the token stream.
@@ -29,122 +30,113 @@ class ExpressionParser {
      */
     void advance();
 
+    /**
+     * @brief Appends an instruction to the program.
+     *
+     * Keeps track of the evaluation stack depth so that the Evaluator
+     * can size its stack before running the program.
+     *
+     * @param instruction Instruction to append
+     * @param stackEffect Change of the stack depth caused by the instruction
+     * @return Index of the appended instruction
+     */
+    size_t emit(const Instruction& instruction, int stackEffect);
+
+    /**
+     * @brief Points a previously emitted jump at the next instruction.
+     *
+     * @param jumpIndex Index of the jump instruction
+     */
+    void patchJump(size_t jumpIndex);
+
 public:
     /**
      * @brief Constructs an ExpressionParser.
      *
      * @param tokenizer Tokenizer initialized with the expression
      * @param token Initial token (typically the first token)
-     * @param table Table used to resolve referenced cells
-     * @param currentCellCoordinates Coordinates of the currently evaluated cell
+     * @param program Program that receives the emitted instructions
      */
     ExpressionParser(const Tokenizer& tokenizer,
                      Token token,
-                     Table& table,
-                     const Coordinates& currentCellCoordinates);
+                     Program& program);
+
+    /**
+     * @brief Compiles an expression to a reusable program.
+     *
+     * @param expression Expression string to compile
+     * @return Compiled program
+     *
+     * @throws std::runtime_error if the expression is malformed
+     */
+    static Program compile(std::string_view expression);
 
     /**
      * @brief Evaluates an expression in the context of a table cell.
      *
-     * This is the main entry point for expression evaluation.
+     * Compiles the expression and runs it once. Cells stored in a table
+     * are compiled when they are set, so this entry point is intended
+     * for ad-hoc expressions.
      *
      * @param expression Expression string to evaluate
      * @param table Table providing referenced cell values
      * @param cellCoordinates Coordinates of the evaluated cell
      * @return Numeric result of the evaluation
      */
-    static double evaluate(const std::string& expression,
+    static double evaluate(std::string_view expression,
                            Table& table,
                            Coordinates cellCoordinates);
 
-    /**
-     * @brief Checks whether a cell exists at the given coordinates.
-     *
-     * @param c Cell coordinates
-     * @return true if the cell exists, false otherwise
-     */
-    [[nodiscard]] bool hasCell(Coordinates c) const;
-
-    /**
-     * @brief Retrieves the cached value of a cell.
-     *
-     * @param c Cell coordinates
-     * @return Numeric value stored in the cell
-     */
-    [[nodiscard]] double getValue(Coordinates c) const;
-
-    /**
-     * @brief Retrieves the raw expression stored in a cell.
-     *
-     * @param c Cell coordinates
-     * @return Reference to the cell's expression string
-     */
-    [[nodiscard]] const std::string& getExpression(Coordinates c) const;
-
 private:
     /**
      * @brief Parses a complete expression.
      *
      * This is the top-level parsing function and represents
      * the lowest-precedence rule in the grammar.
-     *
-     * @return Computed expression value
      */
-    double parseExpression();
+    void parseExpression();
 
     /**
      * @brief Parses logical OR expressions (`or`).
      *
      * Left-to-right associative.
-     *
-     * @return 1.0 if true, 0.0 if false
      */
-    double parseLogicalOr();
+    void parseLogicalOr();
 
     /**
      * @brief Parses logical AND expressions (`and`).
      *
      * Left-to-right associative.
-     *
-     * @return 1.0 if true, 0.0 if false
      */
-    double parseLogicalAnd();
+    void parseLogicalAnd();
 
     /**
      * @brief Parses equality expressions (`==`, `!=`).
      *
      * Left-to-right associative.
-     *
-     * @return 1.0 if true, 0.0 if false
      */
-    double parseEquality();
+    void parseEquality();
 
     /**
      * @brief Parses comparison expressions (`<`, `>`).
      *
      * Left-to-right associative.
-     *
-     * @return 1.0 if true, 0.0 if false
      */
-    double parseComparison();
+    void parseComparison();
 
     /**
      * @brief Parses addition and subtraction (`+`, `-`).
      *
      * Left-to-right associative.
-     *
-     * @return Computed numeric value
      */
-    double parseTerm();
+    void parseTerm();
 
     /**
      * @brief Parses multiplication, division, and modulo (`*`, `/`, `%`).
      *
      * Left-to-right associative.
-     *
-     * @return Computed numeric value
      */
-    double parseFactor();
+    void parseFactor();
 
     /**
      * @brief Parses unary expressions.
@@ -153,10 +145,8 @@ private:
      * - unary plus (`+`)
      * - unary minus (`-`)
      * - logical not (`not`)
-     *
-     * @return Computed numeric value
      */
-    double parseUnary();
+    void parseUnary();
 
     /**
      * @brief Parses primary expressions.
@@ -164,12 +154,10 @@ private:
      * Primary expressions include:
      * - numeric literals
      * - parenthesized expressions
-     * - identifiers (functions)
+     * - identifiers (if and aggregation functions)
      * - cell references
-     *
-     * @return Computed numeric value
      */
-    double parsePrimary();
+    void parsePrimary();
 
     /**
      * @brief Parses an if-expression.
@@ -177,39 +165,28 @@ private:
      * Syntax:
      * if(condition, true_value, false_value)
      *
-     * @return true_value if condition is non-zero,
-     * otherwise false_value
+     * Only the selected branch is evaluated at run time.
      */
-    double parseIf();
+    void parseIf();
 
     /**
-     * @brief Parses a single coordinate component of a cell reference.
-     *
-     * Parses row or column parts such as:
-     * - Absolute:  R5, C10
-     * - Relative:  R[0], C[-1]
+     * @brief Parses an aggregation over an area of cells.
      *
-     * Advances the parsing position accordingly and reports
-     * whether the coordinate is relative.
+     * Syntax:
+     * sum(R0C0:R9C2), count(...), min(...), max(...), avg(...)
      *
-     * @param s Full cell reference string
-     * @param pos Current parsing position (updated during parsing)
-     * @param isRelative Set to true if the coordinate is relative
-     * @return Parsed coordinate value
+     * The corners may be absolute or relative references.
      */
-    static int64_t parseCoordPart(const std::string& s,
-                                  size_t& pos,
-                                  bool& isRelative);
+    void parseAggregate();
 
     /**
-     * @brief Parses a cell reference and retrieves its value.
+     * @brief Parses a cell reference and emits a load of its value.
      *
      * Supports both absolute and relative references (e.g., R1C2,
-     * R[-1]C[0]) resolved relative to currentCellCoordinates.
-     *
-     * @return Numeric value of the referenced cell
+     * R[-1]C[0]). Relative parts are kept as offsets and resolved
+     * against the evaluated cell at run time.
      */
-    double parseCellReference();
+    void parseCellReference();
 };
 
 #endif // EXPRESSION_PARSER_H
\ No newline at end of file
@@ -0,0 +1,113 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "FormulaPool.h"
+#include "ExpressionParser.h"
+#include <stdexcept>
+
+FormulaPool::FormulaId FormulaPool::acquire(std::string_view expression) {
+    auto it = index.find(expression);
+    if (it != index.end()) {
+        ++formulas[it->second].uses;
+        return it->second;
+    }
+
+    FormulaId id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = static_cast<FormulaId>(formulas.size());
+        formulas.emplace_back();
+    }
+
+    this->storeText(id, expression);
+
+    Formula& formula = formulas[id];
+    formula.uses = 1;
+    formula.program = FormulaPool::compile(formula.expression);
+
+    return id;
+}
+
+Program FormulaPool::compile(std::string_view expression) {
+    try {
+        return ExpressionParser::compile(expression);
+    } catch (const std::exception& e) {
+        Program program;
+        program.error = e.what();
+        return program;
+    }
+}
+
+FormulaPool::FormulaId FormulaPool::restore(std::string_view expression, Program program, size_t uses) {
+    if (index.find(expression) != index.end()) {
+        throw std::runtime_error("Duplicate formula");
+    }
+
+    const FormulaId id = static_cast<FormulaId>(formulas.size());
+    formulas.emplace_back();
+    this->storeText(id, expression);
+
+    Formula& formula = formulas[id];
+    formula.program = std::move(program);
+    formula.uses = uses;
+    return id;
+}
+
+void FormulaPool::release(FormulaId id) {
+    Formula& formula = formulas[id];
+    if (--formula.uses > 0) {
+        return;
+    }
+
+    index.erase(formula.expression);
+    deadBytes += formula.expression.size();
+    formula.expression = std::string_view();
+    formula.program = Program();
+    freeIds.push_back(id);
+}
+
+size_t FormulaPool::size() const {
+    return index.size();
+}
+
+void FormulaPool::clear() {
+    formulas.clear();
+    index.clear();
+    freeIds.clear();
+    texts.release();
+    deadBytes = 0;
+}
+
+void FormulaPool::storeText(FormulaId id, std::string_view expression) {
+    this->compact();
+
+    Formula& formula = formulas[id];
+    formula.expression = texts.store(expression);
+    index.emplace(formula.expression, id);
+}
+
+void FormulaPool::compact() {
+    // Small arenas are not worth copying; large ones are copied once half of them is dropped text
+    if (deadBytes < Arena::CHUNK_SIZE || deadBytes * 2 < texts.size()) {
+        return;
+    }
+
+    Arena live;
+    for (Formula& formula : formulas) {
+        if (formula.expression.empty()) {
+            continue;
+        }
+
+        // The index keys point into the old arena: re-key the nodes in place
+        auto node = index.extract(formula.expression);
+        formula.expression = live.store(formula.expression);
+        node.key() = formula.expression;
+        index.insert(std::move(node));
+    }
+
+    texts = std::move(live);
+    deadBytes = 0;
+}
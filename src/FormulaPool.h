@@ -0,0 +1,168 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef FORMULA_POOL_H
+#define FORMULA_POOL_H
+
+#include "Arena.h"
+#include "Types.h"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Interned expression texts and their compiled programs.
+ *
+ * References in R1C1 notation are stored relative to the evaluated cell,
+ * so a formula filled down or across the sheet is the same text in every
+ * cell. The pool keeps one copy of every distinct text together with the
+ * program compiled from it; cells hold only the id of their formula and
+ * supply their own coordinates as the anchor when the program runs.
+ *
+ * Formulas are reference counted. A formula that is no longer used by
+ * any cell is dropped and its id is reused.
+ *
+ * The texts are stored back to back in an Arena instead of one string
+ * per formula. The bytes of dropped formulas stay in the arena until they
+ * outweigh the live texts; then the live texts are copied into a new
+ * arena and the old one is released at once.
+ */
+class FormulaPool {
+public:
+    using FormulaId = uint32_t; ///< Index of a formula in the pool
+
+private:
+    /**
+     * @brief A distinct expression text and its compiled program.
+     */
+    struct Formula {
+        std::string_view expression; ///< Expression text (stored in the arena)
+        Program program;        ///< Compiled expression (holds the compilation error, if any)
+        size_t uses = 0;        ///< Number of cells that use the formula
+    };
+
+    std::deque<Formula> formulas;                              ///< Formulas by id (a deque keeps the programs in place)
+    std::unordered_map<std::string_view, FormulaId> index;     ///< Expression text -> formula id
+    std::vector<FormulaId> freeIds;                            ///< Ids of dropped formulas
+    Arena texts;                                               ///< Storage of the expression texts
+    size_t deadBytes = 0;                                      ///< Bytes of dropped texts still in the arena
+
+    /**
+     * @brief Stores a new formula's text and registers it in the index.
+     *
+     * @param id Id of the formula
+     * @param expression Expression text
+     */
+    void storeText(FormulaId id, std::string_view expression);
+
+    /**
+     * @brief Moves the live texts into a new arena if most of the arena is dropped text.
+     */
+    void compact();
+
+public:
+    /**
+     * @brief Finds or creates the formula of an expression and records a use.
+     *
+     * The expression is compiled only the first time it is seen.
+     * Compilation errors are kept in the program and reported when it
+     * is executed.
+     *
+     * @param expression Expression text
+     * @return Id of the formula
+     */
+    FormulaId acquire(std::string_view expression);
+
+    /**
+     * @brief Compiles an expression the way acquire() does.
+     *
+     * Compilation errors are kept in the returned program instead of
+     * being thrown. Loaders that compile on several threads use this
+     * before adding the formulas with restore().
+     *
+     * @param expression Expression text
+     * @return Compiled expression
+     */
+    static Program compile(std::string_view expression);
+
+    /**
+     * @brief Adds a formula whose program was compiled earlier.
+     *
+     * Used when a table is restored from a snapshot: the expression is
+     * not compiled again. The pool must not already hold the text.
+     *
+     * @param expression Expression text
+     * @param program Program compiled from the expression
+     * @param uses Number of cells that use the formula
+     * @return Id of the formula
+     *
+     * @throws std::runtime_error if the expression is already in the pool
+     */
+    FormulaId restore(std::string_view expression, Program program, size_t uses);
+
+    /**
+     * @brief Records that a cell no longer uses a formula.
+     *
+     * @param id Id of the formula
+     */
+    void release(FormulaId id);
+
+    /**
+     * @brief Returns the expression text of a formula.
+     *
+     * @param id Id of the formula
+     * @return Expression text
+     */
+    std::string_view expression(FormulaId id) const {
+        return formulas[id].expression;
+    }
+
+    /**
+     * @brief Returns the compiled program of a formula.
+     *
+     * @param id Id of the formula
+     * @return Compiled expression
+     */
+    const Program& program(FormulaId id) const {
+        return formulas[id].program;
+    }
+
+    /**
+     * @brief Returns the number of cells that use a formula.
+     *
+     * @param id Id of the formula
+     * @return Use count
+     */
+    size_t uses(FormulaId id) const {
+        return formulas[id].uses;
+    }
+
+    /**
+     * @brief Returns the number of distinct formulas in use.
+     *
+     * @return Formula count
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the number of bytes the expression texts occupy.
+     *
+     * Includes the texts of dropped formulas that were not compacted yet.
+     *
+     * @return Size of the text arena in bytes
+     */
+    size_t textBytes() const {
+        return texts.size();
+    }
+
+    /**
+     * @brief Removes all formulas and releases their memory.
+     */
+    void clear();
+};
+
+#endif // FORMULA_POOL_H
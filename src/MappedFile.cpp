@@ -0,0 +1,83 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "MappedFile.h"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_POSIX 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &fileName)
+    : bytes(nullptr), length(0), mapped(false) {
+#ifdef MAPPED_FILE_POSIX
+    const int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file for reading");
+    }
+
+    struct stat info {};
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        length = static_cast<size_t>(info.st_size);
+        if (length == 0) {
+            ::close(fd);
+            return;
+        }
+
+        void* address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            ::madvise(address, length, MADV_SEQUENTIAL);
+            ::close(fd);
+            bytes = static_cast<const char*>(address);
+            mapped = true;
+            return;
+        }
+    }
+    ::close(fd);
+#endif
+
+    readIntoBuffer(fileName);
+}
+
+MappedFile::~MappedFile() {
+#ifdef MAPPED_FILE_POSIX
+    if (mapped) {
+        ::munmap(const_cast<char*>(bytes), length);
+    }
+#endif
+}
+
+void MappedFile::readIntoBuffer(const std::string &fileName) {
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Cannot open file for reading");
+    }
+
+    buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    bytes = buffer.data();
+    length = buffer.size();
+    mapped = false;
+}
+
+const char* MappedFile::data() const {
+    return bytes;
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
+
+std::string_view MappedFile::view() const {
+    return {bytes, length};
+}
+
+bool MappedFile::isMapped() const {
+    return mapped;
+}
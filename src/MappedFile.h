@@ -0,0 +1,84 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Read-only view of a whole file.
+ *
+ * On POSIX systems the file is memory-mapped, so its bytes are read
+ * straight from the page cache without copying. Where mapping is not
+ * available (or fails, e.g. for pipes), the file is read into a buffer
+ * owned by the object. Either way the contents stay valid for the
+ * lifetime of the object.
+ */
+class MappedFile {
+    const char* bytes;        ///< First byte of the contents
+    size_t length;            ///< Number of bytes
+    bool mapped;              ///< True if `bytes` points into a mapping
+    std::vector<char> buffer; ///< Contents read without a mapping
+
+    /**
+     * @brief Reads the whole file into `buffer`.
+     *
+     * @param fileName Path to the file
+     *
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    void readIntoBuffer(const std::string& fileName);
+
+public:
+    /**
+     * @brief Opens and maps a file.
+     *
+     * @param fileName Path to the file
+     *
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    explicit MappedFile(const std::string& fileName);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Returns the first byte of the contents.
+     *
+     * @return Pointer to the contents (may be nullptr for an empty file)
+     */
+    const char* data() const;
+
+    /**
+     * @brief Returns the size of the file.
+     *
+     * @return Number of bytes
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the contents as a string view.
+     *
+     * @return View of all bytes of the file
+     */
+    std::string_view view() const;
+
+    /**
+     * @brief Checks whether the contents are memory-mapped.
+     *
+     * @return true if the file is mapped, false if it was read into a buffer
+     */
+    bool isMapped() const;
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,52 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "OutputBuffer.h"
+#include <charconv>
+#include <stdexcept>
+
+OutputBuffer::OutputBuffer(std::ostream &out, size_t capacity)
+    : out(out), capacity(capacity) {
+    buffer.reserve(capacity);
+}
+
+OutputBuffer::~OutputBuffer() {
+    // Errors cannot be reported from a destructor; callers that need
+    // them call flush() explicitly
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+void OutputBuffer::appendChunked(char c, size_t count) {
+    // A buffer of capacity 0 still makes progress one character at a time
+    const size_t chunkSize = std::max<size_t>(capacity, 1);
+    while (count > 0) {
+        const size_t room = chunkSize - std::min(buffer.size(), chunkSize);
+        const size_t chunk = std::min(count, room);
+        buffer.append(chunk, c);
+        count -= chunk;
+        if (buffer.size() >= chunkSize) {
+            flush();
+        }
+    }
+}
+
+void OutputBuffer::appendInteger(int64_t value) {
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    append(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+}
+
+void OutputBuffer::appendNumber(double value) {
+    char digits[32];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6);
+    append(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+}
+
+void OutputBuffer::flush() {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+    if (!out) {
+        throw std::runtime_error("Cannot write output");
+    }
+}
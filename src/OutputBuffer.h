@@ -0,0 +1,111 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Collects text in a large buffer and writes it to a stream in blocks.
+ *
+ * Appending to the buffer is a memory copy; the stream is called only
+ * when the buffer is full, on flush() and on destruction. This replaces
+ * one formatted stream insertion per cell and per separator with a few
+ * large writes.
+ */
+class OutputBuffer {
+    std::ostream& out;  ///< Destination stream
+    std::string buffer; ///< Pending text
+    size_t capacity;    ///< Buffer size that triggers a write
+
+    /**
+     * @brief Appends a long repetition of a character in chunks, flushing between them.
+     *
+     * @param c Character to append
+     * @param count Number of repetitions
+     */
+    void appendChunked(char c, size_t count);
+
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 20; ///< Default buffer size (1 MiB)
+
+    /**
+     * @brief Constructs a buffer in front of a stream.
+     *
+     * @param out Destination stream
+     * @param capacity Buffer size that triggers a write (default: 1 MiB)
+     */
+    explicit OutputBuffer(std::ostream& out, size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Writes the pending text.
+     */
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    /**
+     * @brief Appends text.
+     *
+     * @param text Text to append
+     */
+    void append(std::string_view text) {
+        buffer.append(text);
+        if (buffer.size() >= capacity) {
+            flush();
+        }
+    }
+
+    /**
+     * @brief Appends a character repeated a number of times.
+     *
+     * Repetitions that do not fit in the buffer are written in chunks of
+     * at most the capacity, so the memory used does not depend on count.
+     *
+     * @param c Character to append
+     * @param count Number of repetitions
+     */
+    void append(char c, size_t count = 1) {
+        if (count > capacity - std::min(buffer.size(), capacity)) {
+            appendChunked(c, count);
+            return;
+        }
+        buffer.append(count, c);
+        if (buffer.size() >= capacity) {
+            flush();
+        }
+    }
+
+    /**
+     * @brief Appends an integer in decimal notation.
+     *
+     * @param value Integer to append
+     */
+    void appendInteger(int64_t value);
+
+    /**
+     * @brief Appends a number the way `std::ostream` prints a double by default.
+     *
+     * Uses the general format with 6 significant digits (like "%g"), so
+     * the text equals `std::cout << value` without locale or stream state.
+     *
+     * @param value Number to append
+     */
+    void appendNumber(double value);
+
+    /**
+     * @brief Writes the pending text to the stream.
+     *
+     * @throws std::runtime_error if the stream reports a write error
+     */
+    void flush();
+};
+
+#endif // OUTPUT_BUFFER_H
@@ -0,0 +1,205 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <string>
+
+std::mutex Profiler::mutex;
+CoordinateMap<Profiler::Entry> Profiler::cells;
+uint64_t Profiler::completions = 0;
+uint64_t Profiler::recalculations = 0;
+double Profiler::recalculationSeconds = 0;
+thread_local std::vector<Profiler::Frame> Profiler::frames;
+thread_local std::vector<Coordinates> Profiler::reads;
+
+size_t Profiler::enter(uint64_t startedAt) {
+    frames.push_back({Clock::now(), 0, startedAt, reads.size()});
+    return frames.size();
+}
+
+double Profiler::leave(double &selfSeconds, Frame &frame) {
+    frame = frames.back();
+    frames.pop_back();
+
+    const std::chrono::duration<double> elapsed = Clock::now() - frame.start;
+    selfSeconds = elapsed.count() - frame.childSeconds;
+
+    if (!frames.empty()) {
+        frames.back().childSeconds += elapsed.count();
+    }
+    return elapsed.count();
+}
+
+void Profiler::countReads(const Frame &frame, bool completed) {
+    if (completed) {
+        for (size_t i = frame.firstRead; i < reads.size(); ++i) {
+            Entry& entry = Profiler::cells[reads[i]];
+            if (entry.evaluatedAt > frame.startedAt) {
+                ++entry.profile.misses;
+            } else {
+                ++entry.profile.hits;
+            }
+        }
+    }
+    reads.resize(frame.firstRead);
+}
+
+Profiler::Evaluation::Evaluation(const Coordinates &cell, size_t pendingDepth, const bool* completed)
+    : cell(cell), completed(completed), exceptions(std::uncaught_exceptions()) {
+    uint64_t startedAt;
+    {
+        // A restarted evaluation keeps the start of its first attempt
+        std::lock_guard<std::mutex> lock(Profiler::mutex);
+        Entry& entry = Profiler::cells[cell];
+        if (!entry.running) {
+            entry.running = true;
+            entry.startedAt = Profiler::completions;
+        }
+        startedAt = entry.startedAt;
+    }
+    this->depth = Profiler::enter(startedAt) + pendingDepth;
+}
+
+Profiler::Evaluation::~Evaluation() {
+    const bool failed = std::uncaught_exceptions() > this->exceptions;
+    const bool computed = !failed && (this->completed == nullptr || *this->completed);
+
+    double selfSeconds;
+    Frame frame;
+    const double totalSeconds = Profiler::leave(selfSeconds, frame);
+
+    std::lock_guard<std::mutex> lock(Profiler::mutex);
+    Profiler::countReads(frame, computed);
+
+    Entry& entry = Profiler::cells[this->cell];
+    entry.profile.totalSeconds += totalSeconds;
+    entry.profile.selfSeconds += selfSeconds;
+    entry.profile.maxDepth = std::max(entry.profile.maxDepth, this->depth);
+
+    if (computed) {
+        ++entry.profile.evaluations;
+        entry.evaluatedAt = ++Profiler::completions;
+    }
+    if (computed || failed) {
+        entry.running = false;
+    }
+}
+
+Profiler::Batch::Batch(int64_t col, int64_t firstRow, size_t count)
+    : col(col), firstRow(firstRow), count(count), exceptions(std::uncaught_exceptions()) {
+    uint64_t startedAt;
+    {
+        std::lock_guard<std::mutex> lock(Profiler::mutex);
+        startedAt = Profiler::completions;
+    }
+    this->depth = Profiler::enter(startedAt);
+}
+
+Profiler::Batch::~Batch() {
+    // A failing batch falls back to per-cell evaluations, which count themselves
+    const bool computed = std::uncaught_exceptions() <= this->exceptions;
+
+    double selfSeconds;
+    Frame frame;
+    const double totalSeconds = Profiler::leave(selfSeconds, frame);
+    const double share = 1.0 / static_cast<double>(this->count);
+
+    std::lock_guard<std::mutex> lock(Profiler::mutex);
+    Profiler::countReads(frame, computed);
+
+    for (size_t i = 0; i < this->count; ++i) {
+        Entry& entry = Profiler::cells[{this->firstRow + static_cast<int64_t>(i), this->col}];
+        entry.profile.totalSeconds += totalSeconds * share;
+        entry.profile.selfSeconds += selfSeconds * share;
+        entry.profile.maxDepth = std::max(entry.profile.maxDepth, this->depth);
+
+        if (computed) {
+            ++entry.profile.evaluations;
+            entry.evaluatedAt = ++Profiler::completions;
+        }
+    }
+}
+
+Profiler::Recalculation::Recalculation() : start(Clock::now()) {
+}
+
+Profiler::Recalculation::~Recalculation() {
+    const std::chrono::duration<double> elapsed = Clock::now() - this->start;
+
+    std::lock_guard<std::mutex> lock(Profiler::mutex);
+    ++Profiler::recalculations;
+    Profiler::recalculationSeconds += elapsed.count();
+}
+
+void Profiler::lookup(const Coordinates &cell) {
+    if (!frames.empty()) {
+        reads.push_back(cell);
+    }
+}
+
+void Profiler::reset() {
+    std::lock_guard<std::mutex> lock(Profiler::mutex);
+    Profiler::cells.clear();
+    Profiler::completions = 0;
+    Profiler::recalculations = 0;
+    Profiler::recalculationSeconds = 0;
+}
+
+Profiler::CellProfile Profiler::get(const Coordinates &cell) {
+    std::lock_guard<std::mutex> lock(Profiler::mutex);
+    const Entry* entry = Profiler::cells.find(cell);
+    return entry == nullptr ? CellProfile() : entry->profile;
+}
+
+std::pair<uint64_t, double> Profiler::getRecalculations() {
+    std::lock_guard<std::mutex> lock(Profiler::mutex);
+    return {Profiler::recalculations, Profiler::recalculationSeconds};
+}
+
+void Profiler::report(std::ostream &out, size_t top) {
+    std::lock_guard<std::mutex> lock(Profiler::mutex);
+
+    std::vector<std::pair<Coordinates, CellProfile>> hottest;
+    hottest.reserve(Profiler::cells.size());
+    Profiler::cells.forEach([&](const Coordinates& cell, const Entry& entry) {
+        hottest.emplace_back(cell, entry.profile);
+    });
+    const size_t shown = std::min(top, hottest.size());
+
+    // Ties are ordered by position, so reports of equal runs are equal
+    std::partial_sort(hottest.begin(), hottest.begin() + static_cast<std::ptrdiff_t>(shown), hottest.end(),
+                      [](const auto& a, const auto& b) {
+                          if (a.second.selfSeconds != b.second.selfSeconds) {
+                              return a.second.selfSeconds > b.second.selfSeconds;
+                          }
+                          return a.first < b.first;
+                      });
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "Recalculations: %llu, total %.6f s, %zu cells profiled\n",
+                  static_cast<unsigned long long>(Profiler::recalculations),
+                  Profiler::recalculationSeconds, hottest.size());
+    out << line;
+
+    std::snprintf(line, sizeof(line), "%-16s %12s %12s %12s %14s %14s %10s\n",
+                  "Cell", "Evaluations", "Hits", "Misses", "Total (ms)", "Self (ms)", "Max depth");
+    out << line;
+
+    for (size_t i = 0; i < shown; ++i) {
+        const auto& [cell, profile] = hottest[i];
+        const std::string name = "R" + std::to_string(cell.row) + "C" + std::to_string(cell.col);
+
+        std::snprintf(line, sizeof(line), "%-16s %12llu %12llu %12llu %14.3f %14.3f %10zu\n",
+                      name.c_str(),
+                      static_cast<unsigned long long>(profile.evaluations),
+                      static_cast<unsigned long long>(profile.hits),
+                      static_cast<unsigned long long>(profile.misses),
+                      profile.totalSeconds * 1e3, profile.selfSeconds * 1e3, profile.maxDepth);
+        out << line;
+    }
+}
@@ -0,0 +1,231 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "CoordinateMap.h"
+#include "Types.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/**
+ * @brief Per-cell counters of the evaluation, for finding the cells a slow
+ * recalculation spends its time on.
+ *
+ * The Evaluator reports to the profiler through the PROFILE_* macros
+ * below. They expand to nothing unless the program is built with
+ * ET_PROFILE defined (the ELECTRONIC_TABLE_PROFILE CMake option), so a
+ * regular build carries no instrumentation at all.
+ *
+ * Evaluations are timed as nested frames per thread: the total time of a
+ * frame includes the cells evaluated while it runs (in the recursive mode
+ * and in aggregates), the self time does not. Cells of a column run that
+ * is evaluated as a batch share the time of the batch evenly.
+ *
+ * A cell counts one evaluation when its value is computed, however often
+ * the iterative mode suspended and restarted its program on the way; the
+ * time of all attempts is added up. Reads of other cells are recorded by
+ * the running frame and counted when it completes, so the reads a
+ * suspended attempt repeats on the restart are counted once. A read is a
+ * miss if the read cell got its value after the reader started (the
+ * reader waited for it), and a hit otherwise. Reads outside of any
+ * evaluation, such as a recalculation asking for a dirty cell, are not
+ * counted.
+ */
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock; ///< Clock used for all timings
+
+    /**
+     * @brief Counters of a single cell.
+     */
+    struct CellProfile {
+        uint64_t evaluations = 0;  ///< Computed values (restarts of a suspended program are not counted)
+        uint64_t hits = 0;         ///< Reads by other cells that found the value already computed
+        uint64_t misses = 0;       ///< Reads by other cells that waited for the value to be computed
+        double totalSeconds = 0;   ///< Time of all executions including nested evaluations
+        double selfSeconds = 0;    ///< Time of all executions without nested evaluations
+        size_t maxDepth = 0;       ///< Deepest nesting of evaluations the cell was executed at
+    };
+
+#ifdef ET_PROFILE
+    static constexpr bool ENABLED = true;  ///< Whether the Evaluator reports to the profiler
+#else
+    static constexpr bool ENABLED = false; ///< Whether the Evaluator reports to the profiler
+#endif
+
+private:
+    /**
+     * @brief An evaluation that is running on the current thread.
+     */
+    struct Frame {
+        Clock::time_point start; ///< Start of the evaluation
+        double childSeconds;     ///< Time of the evaluations nested in it
+        uint64_t startedAt;      ///< Value of `completions` when the evaluation (first) started
+        size_t firstRead;        ///< Index of the frame's first entry in `reads`
+    };
+
+    /**
+     * @brief Counters of a cell and the state used to classify reads of it.
+     */
+    struct Entry {
+        CellProfile profile;      ///< Reported counters
+        uint64_t evaluatedAt = 0; ///< Value of `completions` after the cell was last computed
+        uint64_t startedAt = 0;   ///< Value of `completions` when the unfinished evaluation started
+        bool running = false;     ///< Whether an evaluation was started and not finished yet
+    };
+
+    static std::mutex mutex;                              ///< Guards the counters
+    static CoordinateMap<Entry> cells;                    ///< Counters by cell
+    static uint64_t completions;                          ///< Number of computed values so far
+    static uint64_t recalculations;                       ///< Number of recalculations
+    static double recalculationSeconds;                   ///< Time of all recalculations
+    static thread_local std::vector<Frame> frames;        ///< Running evaluations of this thread
+    static thread_local std::vector<Coordinates> reads;   ///< Cells read by the running frames of this thread
+
+    /**
+     * @brief Starts a frame.
+     *
+     * @param startedAt Value of `completions` when the evaluation started
+     * @return Depth of the new frame (1 for the outermost one)
+     */
+    static size_t enter(uint64_t startedAt);
+
+    /**
+     * @brief Ends the innermost frame.
+     *
+     * @param selfSeconds Receives the time of the frame without its nested frames
+     * @param frame Receives the ended frame
+     * @return Time of the frame
+     */
+    static double leave(double& selfSeconds, Frame& frame);
+
+    /**
+     * @brief Counts the reads of an ended frame and drops them; the mutex must be held.
+     *
+     * @param frame Ended frame
+     * @param completed false to drop the reads without counting them
+     */
+    static void countReads(const Frame& frame, bool completed);
+
+public:
+    /**
+     * @brief Times one execution of a cell's program for as long as it lives.
+     */
+    class Evaluation {
+        Coordinates cell;       ///< Executed cell
+        size_t depth;           ///< Nesting depth of the execution
+        const bool* completed;  ///< Whether the execution computed the value, or nullptr
+        int exceptions;         ///< Uncaught exceptions when the execution started
+
+    public:
+        /**
+         * An execution that ends by an exception computes nothing; one that
+         * ends normally computes the value unless `completed` says otherwise.
+         *
+         * @param cell Executed cell
+         * @param pendingDepth Suspended evaluations of the iterative work
+         *        stack below this one, which do not have frames of their own
+         * @param completed Set by the caller to false if the program was
+         *        suspended; read when the execution ends
+         */
+        explicit Evaluation(const Coordinates& cell, size_t pendingDepth = 0, const bool* completed = nullptr);
+        ~Evaluation();
+
+        Evaluation(const Evaluation&) = delete;
+        Evaluation& operator=(const Evaluation&) = delete;
+    };
+
+    /**
+     * @brief Times the batch evaluation of a column run for as long as it lives.
+     */
+    class Batch {
+        int64_t col;      ///< Column of the run
+        int64_t firstRow; ///< Row of the first cell of the run
+        size_t count;     ///< Number of cells of the run
+        size_t depth;     ///< Nesting depth of the batch
+        int exceptions;   ///< Uncaught exceptions when the batch started
+
+    public:
+        Batch(int64_t col, int64_t firstRow, size_t count);
+        ~Batch();
+
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+    };
+
+    /**
+     * @brief Times a whole recalculation for as long as it lives.
+     */
+    class Recalculation {
+        Clock::time_point start; ///< Start of the recalculation
+
+    public:
+        Recalculation();
+        ~Recalculation();
+
+        Recalculation(const Recalculation&) = delete;
+        Recalculation& operator=(const Recalculation&) = delete;
+    };
+
+    /**
+     * @brief Records a read of a cell by the running evaluation.
+     *
+     * The read is counted as a hit or a miss when the evaluation
+     * completes, and dropped if it is suspended or fails.
+     *
+     * @param cell Read cell
+     */
+    static void lookup(const Coordinates& cell);
+
+    /**
+     * @brief Discards all counters.
+     */
+    static void reset();
+
+    /**
+     * @brief Returns the counters of a cell.
+     *
+     * @param cell Cell coordinates
+     * @return Counters of the cell (all zero if it was never seen)
+     */
+    static CellProfile get(const Coordinates& cell);
+
+    /**
+     * @brief Returns the number and total time of the recalculations.
+     *
+     * @return Pair of the number of recalculations and their time in seconds
+     */
+    static std::pair<uint64_t, double> getRecalculations();
+
+    /**
+     * @brief Writes the total recalculation time and the hottest cells.
+     *
+     * Cells are ordered by self time, the most expensive first.
+     *
+     * @param out Output stream
+     * @param top Maximum number of cells to list
+     */
+    static void report(std::ostream& out, size_t top);
+};
+
+#ifdef ET_PROFILE
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_EVALUATION(...) Profiler::Evaluation PROFILE_CONCAT(profileEvaluation, __LINE__)(__VA_ARGS__)
+#define PROFILE_BATCH(col, firstRow, count) Profiler::Batch PROFILE_CONCAT(profileBatch, __LINE__)(col, firstRow, count)
+#define PROFILE_RECALCULATION() Profiler::Recalculation PROFILE_CONCAT(profileRecalculation, __LINE__)
+#define PROFILE_LOOKUP(cell) Profiler::lookup(cell)
+#else
+#define PROFILE_EVALUATION(...) ((void)0)
+#define PROFILE_BATCH(col, firstRow, count) ((void)0)
+#define PROFILE_RECALCULATION() ((void)0)
+#define PROFILE_LOOKUP(cell) ((void)0)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,138 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "SheetGenerator.h"
+#include "OutputBuffer.h"
+
+#include <fstream>
+#include <stdexcept>
+
+void SheetGenerator::appendReference(std::string &text, const Coordinates &from,
+                                     const Coordinates &to, bool relative) {
+    if (relative) {
+        text += "R[" + std::to_string(to.row - from.row) + "]C[" + std::to_string(to.col - from.col) + "]";
+    } else {
+        text += "R" + std::to_string(to.row) + "C" + std::to_string(to.col);
+    }
+}
+
+std::string SheetGenerator::formula(const Options &options, Random &random,
+                                    const Coordinates &cell, const std::vector<Coordinates> &earlier) {
+    const size_t index = earlier.size();
+    std::string text;
+
+    auto reference = [&](size_t target) {
+        appendReference(text, cell, earlier[target], options.relativeReferences);
+    };
+    auto anyEarlier = [&]() {
+        return static_cast<size_t>(random.below(index));
+    };
+
+    switch (options.shape) {
+        case Shape::Chain:
+            reference(index - 1);
+            text += " + 1";
+            break;
+
+        case Shape::Tree:
+            reference((index - 1) / 2);
+            text += " + 1";
+            break;
+
+        case Shape::Diamond:
+            // Values stay small however long the sheet is
+            text += "(";
+            reference(index - 1);
+            text += " + ";
+            reference(index >= 2 ? index - 2 : 0);
+            text += ") % 1000";
+            break;
+
+        case Shape::RandomDag: {
+            const uint64_t count = 1 + random.below(3);
+            text += "(";
+            for (uint64_t i = 0; i < count; ++i) {
+                if (i > 0) {
+                    text += random.below(2) == 0 ? " + " : " * ";
+                }
+                reference(anyEarlier());
+            }
+            text += ") % 1000";
+            break;
+        }
+
+        case Shape::NestedIf: {
+            // if(a > n, if(...), b) with the innermost branch a plain reference
+            for (int level = 0; level < options.ifDepth; ++level) {
+                text += "if(";
+                reference(anyEarlier());
+                text += " > " + std::to_string(random.below(100)) + ", ";
+            }
+            reference(anyEarlier());
+            for (int level = 0; level < options.ifDepth; ++level) {
+                text += ", ";
+                reference(anyEarlier());
+                text += ")";
+            }
+            break;
+        }
+    }
+
+    return text;
+}
+
+SheetGenerator::Shape SheetGenerator::parseShape(const std::string &name) {
+    if (name == "chain") return Shape::Chain;
+    if (name == "tree") return Shape::Tree;
+    if (name == "diamond") return Shape::Diamond;
+    if (name == "dag") return Shape::RandomDag;
+    if (name == "if") return Shape::NestedIf;
+
+    throw std::runtime_error("Unknown dependency shape: " + name);
+}
+
+void SheetGenerator::write(std::ostream &out, const Options &options) {
+    if (options.rows < 0 || options.cols < 0 || options.ifDepth < 0 ||
+        !(options.density >= 0 && options.density <= 1) ||
+        !(options.formulaRatio >= 0 && options.formulaRatio <= 1)) {
+        throw std::runtime_error("Generator options out of range");
+    }
+
+    Random random(options.seed);
+    OutputBuffer buffer(out);
+    std::vector<Coordinates> occupied;
+
+    for (int64_t row = 0; row < options.rows; ++row) {
+        // Separators are written only before occupied cells, so rows end at their last cell
+        int64_t col = 0;
+
+        for (int64_t c = 0; c < options.cols; ++c) {
+            if (random.unit() >= options.density) {
+                continue;
+            }
+
+            const Coordinates cell(row, c);
+            buffer.append(';', static_cast<size_t>(c - col));
+            col = c;
+
+            if (occupied.empty() || random.unit() >= options.formulaRatio) {
+                buffer.appendInteger(static_cast<int64_t>(random.below(100)));
+            } else {
+                buffer.append(formula(options, random, cell, occupied));
+            }
+            occupied.push_back(cell);
+        }
+        buffer.append('\n');
+    }
+    buffer.flush();
+}
+
+void SheetGenerator::save(const std::string &fileName, const Options &options) {
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open file for writing");
+    }
+
+    SheetGenerator::write(out, options);
+}
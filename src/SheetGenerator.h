@@ -0,0 +1,137 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef SHEET_GENERATOR_H
+#define SHEET_GENERATOR_H
+
+#include "Types.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Writes synthetic sheets in the CSV format read by CmdInterpreter::load().
+ *
+ * Cells are generated row by row. A cell is occupied with probability
+ * `density`, and an occupied cell holds a formula with probability
+ * `formulaRatio`, otherwise an integer constant. Formulas refer only to
+ * occupied cells generated before them, so every sheet evaluates without
+ * missing or circular references; the dependency shape decides which of
+ * those cells they refer to.
+ *
+ * The output depends only on the options: random numbers come from
+ * SplitMix64 over a counter started at the seed, so the same seed gives
+ * the same file on every platform.
+ */
+class SheetGenerator {
+public:
+    /**
+     * @brief How formulas refer to earlier cells.
+     */
+    enum class Shape {
+        Chain,     ///< Every formula refers to the previous occupied cell
+        Tree,      ///< Occupied cell k refers to cell (k - 1) / 2, a binary tree rooted at the first cell
+        Diamond,   ///< Every formula refers to the two previous occupied cells, whose paths meet again
+        RandomDag, ///< Every formula refers to one to three random earlier cells
+        NestedIf   ///< Every formula is an `if` nested ifDepth levels deep over random earlier cells
+    };
+
+    /**
+     * @brief Parameters of a generated sheet.
+     */
+    struct Options {
+        int64_t rows = 1000;             ///< Number of rows
+        int64_t cols = 10;               ///< Number of columns
+        double density = 1.0;            ///< Probability that a cell is occupied
+        double formulaRatio = 0.5;       ///< Probability that an occupied cell holds a formula
+        Shape shape = Shape::Chain;      ///< Dependency shape of the formulas
+        bool relativeReferences = true;  ///< Write R[-1]C[0] instead of R4C2
+        int ifDepth = 3;                 ///< Nesting depth of NestedIf formulas
+        uint64_t seed = 1;               ///< Seed of the random numbers
+    };
+
+private:
+    /**
+     * @brief Deterministic random numbers (SplitMix64 over a counter).
+     */
+    class Random {
+        uint64_t state; ///< Counter advanced by every draw
+
+    public:
+        explicit Random(uint64_t seed) : state(seed) {}
+
+        /// Next 64 random bits
+        uint64_t next() {
+            return Hash::splitmix64(state++);
+        }
+
+        /// Uniform integer in [0, bound)
+        uint64_t below(uint64_t bound) {
+            return next() % bound;
+        }
+
+        /// Uniform double in [0, 1)
+        double unit() {
+            return static_cast<double>(next() >> 11) * 0x1.0p-53;
+        }
+    };
+
+    /**
+     * @brief Writes a reference from one cell to another.
+     *
+     * @param text Output text
+     * @param from Cell containing the reference
+     * @param to Referenced cell
+     * @param relative Write offsets instead of indices
+     */
+    static void appendReference(std::string& text, const Coordinates& from,
+                                const Coordinates& to, bool relative);
+
+    /**
+     * @brief Builds the formula of an occupied cell.
+     *
+     * @param options Sheet parameters
+     * @param random Random numbers
+     * @param cell Cell being generated
+     * @param earlier Occupied cells generated before it (not empty)
+     * @return Formula text
+     */
+    static std::string formula(const Options& options, Random& random,
+                               const Coordinates& cell, const std::vector<Coordinates>& earlier);
+
+public:
+    /**
+     * @brief Parses a shape name: chain, tree, diamond, dag or if.
+     *
+     * @param name Shape name
+     * @return Parsed shape
+     *
+     * @throws std::runtime_error if the name is unknown
+     */
+    static Shape parseShape(const std::string& name);
+
+    /**
+     * @brief Writes a sheet to a stream.
+     *
+     * @param out Output stream
+     * @param options Sheet parameters
+     *
+     * @throws std::runtime_error if the options are out of range
+     */
+    static void write(std::ostream& out, const Options& options);
+
+    /**
+     * @brief Writes a sheet to a file.
+     *
+     * @param fileName Path to the output file
+     * @param options Sheet parameters
+     *
+     * @throws std::runtime_error if the file cannot be opened or the
+     *         options are out of range
+     */
+    static void save(const std::string& fileName, const Options& options);
+};
+
+#endif // SHEET_GENERATOR_H
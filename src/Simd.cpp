@@ -0,0 +1,39 @@
+//
+// Created by Petya Licheva on 10/18/2026.
+//
+
+#include "Simd.h"
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+SimdLevel Simd::detect() {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+#endif
+    return SimdLevel::Baseline;
+}
+
+bool Simd::supports(SimdLevel level) {
+    return level == SimdLevel::Baseline || detect() == SimdLevel::AVX2;
+}
+
+void Simd::setLevel(SimdLevel level) {
+    if (!Simd::supports(level)) {
+        throw std::runtime_error("The processor does not support the requested instruction set");
+    }
+    current().store(level, std::memory_order_relaxed);
+}
+
+std::atomic<SimdLevel>& Simd::current() {
+    static std::atomic<SimdLevel> level([] {
+        const char* requested = std::getenv(LEVEL_VARIABLE);
+        if (requested != nullptr && std::string(requested) == "baseline") {
+            return SimdLevel::Baseline;
+        }
+        return Simd::detect();
+    }());
+    return level;
+}
@@ -0,0 +1,71 @@
+//
+// Created by Petya Licheva on 10/18/2026.
+//
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <atomic>
+
+/**
+ * @brief Instruction sets the vectorized kernels are built for.
+ */
+enum class SimdLevel {
+    Baseline, ///< What the compiler targets by default (SSE2 on x86-64, scalar loops elsewhere)
+    AVX2      ///< AVX2 variants, compiled separately with -mavx2
+};
+
+/**
+ * @brief Selects the instruction set of the vectorized kernels at run time.
+ *
+ * DelimiterScanner and VectorKernels are compiled twice: once for the
+ * baseline of the target architecture and once, in their *Avx2.cpp
+ * files, with AVX2 enabled. Every call checks level() and runs the AVX2
+ * variant only if the processor supports it, so one binary uses AVX2
+ * where it is available and still runs on older processors.
+ *
+ * The level starts as the best one the processor supports. Setting the
+ * environment variable LEVEL_VARIABLE to "baseline" starts with the
+ * baseline instead, which lets benchmarks compare the variants; tests
+ * switch between them with setLevel().
+ */
+class Simd {
+public:
+    static constexpr const char* LEVEL_VARIABLE = "ELECTRONIC_TABLE_SIMD";
+
+    /**
+     * @brief Returns the best level the processor supports.
+     */
+    static SimdLevel detect();
+
+    /**
+     * @brief Checks whether the processor supports a level.
+     *
+     * @param level Level to check
+     * @return true if kernels of the level can run
+     */
+    static bool supports(SimdLevel level);
+
+    /**
+     * @brief Returns the level the kernels currently use.
+     */
+    static SimdLevel level() {
+        return current().load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Changes the level the kernels use.
+     *
+     * @param level New level
+     * @throws std::runtime_error if the processor does not support the level
+     */
+    static void setLevel(SimdLevel level);
+
+private:
+    /**
+     * @brief Returns the process-wide level, initialized on first use.
+     */
+    static std::atomic<SimdLevel>& current();
+};
+
+#endif // SIMD_H
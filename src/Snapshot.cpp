@@ -0,0 +1,310 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "Snapshot.h"
+#include "MappedFile.h"
+#include "OutputBuffer.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<Coordinates> && sizeof(Coordinates) == 2 * sizeof(int64_t),
+              "Snapshot positions are stored as raw Coordinates");
+
+bool Snapshot::isWellFormed(const Program &program) {
+    if (!program.error.empty()) {
+        return program.code.empty();
+    }
+
+    // Stack depth before each instruction (and at the end), -1 if unreached
+    const size_t length = program.code.size();
+    std::vector<int64_t> depth(length + 1, -1);
+    depth[0] = 0;
+
+    auto reach = [&](size_t target, int64_t value) {
+        if (depth[target] != -1 && depth[target] != value) {
+            return false;
+        }
+        depth[target] = value;
+        return true;
+    };
+
+    for (size_t pc = 0; pc < length; ++pc) {
+        const Instruction& instruction = program.code[pc];
+        const int64_t before = depth[pc];
+        if (before == -1) {
+            continue;
+        }
+
+        int64_t operands = 0;
+        int64_t after = before;
+        switch (instruction.op) {
+            case OpCode::PushNumber:
+            case OpCode::LoadRef:
+            case OpCode::Sum:
+            case OpCode::Count:
+            case OpCode::Min:
+            case OpCode::Max:
+            case OpCode::Avg:
+                after = before + 1;
+                break;
+            case OpCode::Negate:
+            case OpCode::Not:
+            case OpCode::ToBool:
+                operands = 1;
+                break;
+            case OpCode::Jump:
+                break;
+            case OpCode::JumpIfFalse:
+            case OpCode::AndJump:
+            case OpCode::OrJump:
+                operands = 1;
+                after = before - 1;
+                break;
+            default:
+                operands = 2;
+                after = before - 1;
+                break;
+        }
+
+        if (before < operands || after > static_cast<int64_t>(program.maxStack)) {
+            return false;
+        }
+
+        const bool jumps = instruction.op == OpCode::Jump || instruction.op == OpCode::JumpIfFalse ||
+                           instruction.op == OpCode::AndJump || instruction.op == OpCode::OrJump;
+        if (jumps) {
+            if (instruction.target <= pc || instruction.target > length) {
+                return false;
+            }
+            // AndJump and OrJump keep the tested value when they jump
+            const int64_t taken = instruction.op == OpCode::JumpIfFalse ? before - 1 : before;
+            if (!reach(instruction.target, taken)) {
+                return false;
+            }
+        }
+        if (instruction.op != OpCode::Jump && !reach(pc + 1, after)) {
+            return false;
+        }
+    }
+
+    return depth[length] == 1;
+}
+
+void Snapshot::save(const std::string &fileName, const Table &table) {
+    std::ofstream out(fileName, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open file for writing");
+    }
+
+    const CellStore& cells = table.getCells();
+    const FormulaPool& pool = cells.getFormulas();
+    const size_t cellCount = cells.size();
+
+    // Formulas in order of first use, numbered without the gaps left by dropped ones
+    std::vector<FormulaPool::FormulaId> order;
+    std::vector<uint32_t> cellFormulas(cellCount);
+    std::vector<uint32_t> dense;
+
+    for (CellStore::CellId id = 0; id < cellCount; ++id) {
+        const FormulaPool::FormulaId formula = cells.formula(id);
+        if (formula >= dense.size()) {
+            dense.resize(formula + 1, UINT32_MAX);
+        }
+        if (dense[formula] == UINT32_MAX) {
+            dense[formula] = static_cast<uint32_t>(order.size());
+            order.push_back(formula);
+        }
+        cellFormulas[id] = dense[formula];
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.cellCount = cellCount;
+    header.formulaCount = order.size();
+    header.focusRow = table.getFocusedCoords().row;
+    header.focusCol = table.getFocusedCoords().col;
+
+    std::vector<FormulaRecord> records(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        const std::string_view expression = pool.expression(order[i]);
+        const Program& program = pool.program(order[i]);
+
+        records[i].textOffset = header.textBytes;
+        records[i].textLength = static_cast<uint32_t>(expression.size());
+        records[i].errorLength = static_cast<uint32_t>(program.error.size());
+        records[i].codeOffset = header.instructionCount;
+        records[i].codeLength = program.code.size();
+        records[i].maxStack = program.maxStack;
+
+        header.textBytes += expression.size() + program.error.size();
+        header.instructionCount += program.code.size();
+    }
+
+    OutputBuffer buffer(out);
+    auto appendBytes = [&](const void* data, size_t bytes) {
+        buffer.append(std::string_view(static_cast<const char*>(data), bytes));
+    };
+    auto pad = [&](uint64_t bytes) {
+        buffer.append('\0', static_cast<size_t>(aligned(bytes) - bytes));
+    };
+
+    appendBytes(&header, sizeof(header));
+    appendBytes(records.data(), records.size() * sizeof(FormulaRecord));
+
+    for (FormulaPool::FormulaId formula : order) {
+        for (const Instruction& instruction : pool.program(formula).code) {
+            InstructionRecord record{};
+            record.number = instruction.number;
+            record.refRow = instruction.ref.row;
+            record.refCol = instruction.ref.col;
+            record.endRow = instruction.rangeEnd.row;
+            record.endCol = instruction.rangeEnd.col;
+            record.target = instruction.target;
+            record.op = static_cast<uint8_t>(instruction.op);
+            record.flags = static_cast<uint8_t>(instruction.ref.rowRelative |
+                                                instruction.ref.colRelative << 1 |
+                                                instruction.rangeEnd.rowRelative << 2 |
+                                                instruction.rangeEnd.colRelative << 3);
+            appendBytes(&record, sizeof(record));
+        }
+    }
+
+    for (CellStore::CellId id = 0; id < cellCount; ++id) {
+        appendBytes(&cells.position(id), sizeof(Coordinates));
+    }
+    for (CellStore::CellId id = 0; id < cellCount; ++id) {
+        const double value = cells.value(id);
+        appendBytes(&value, sizeof(value));
+    }
+    appendBytes(cellFormulas.data(), cellCount * sizeof(uint32_t));
+    pad(cellCount * sizeof(uint32_t));
+
+    for (CellStore::CellId id = 0; id < cellCount; ++id) {
+        const EvalState state = cells.state(id) == EvalState::Evaluated ? EvalState::Evaluated : EvalState::Dirty;
+        buffer.append(static_cast<char>(state));
+    }
+    pad(cellCount);
+
+    for (FormulaPool::FormulaId formula : order) {
+        buffer.append(pool.expression(formula));
+        buffer.append(pool.program(formula).error);
+    }
+    buffer.flush();
+}
+
+void Snapshot::load(const std::string &fileName, Table &table) {
+    const MappedFile file(fileName);
+    const char* const bytes = file.data();
+    const uint64_t size = file.size();
+
+    Header header{};
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Not a table snapshot");
+    }
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.byteOrder != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Not a table snapshot");
+    }
+    if (header.version != VERSION) {
+        throw std::runtime_error("Unsupported snapshot version");
+    }
+
+    // Every count is checked against the file size before it is
+    // multiplied, so a corrupt header cannot overflow the offsets
+    uint64_t offset = sizeof(header);
+    auto section = [&](uint64_t count, uint64_t recordSize) {
+        if (count > (size - offset) / recordSize) {
+            throw std::runtime_error("Corrupt snapshot");
+        }
+        const char* start = bytes + offset;
+        offset += aligned(count * recordSize);
+        offset = std::min(offset, size);
+        return start;
+    };
+
+    const char* formulaSection = section(header.formulaCount, sizeof(FormulaRecord));
+    const char* codeSection = section(header.instructionCount, sizeof(InstructionRecord));
+    const char* positionSection = section(header.cellCount, sizeof(Coordinates));
+    const char* valueSection = section(header.cellCount, sizeof(double));
+    const char* formulaIdSection = section(header.cellCount, sizeof(uint32_t));
+    const char* stateSection = section(header.cellCount, sizeof(uint8_t));
+    const char* textSection = section(header.textBytes, 1);
+
+    const size_t cellCount = static_cast<size_t>(header.cellCount);
+    const size_t formulaCount = static_cast<size_t>(header.formulaCount);
+
+    std::vector<Coordinates> positions(cellCount);
+    std::vector<double> values(cellCount);
+    std::vector<FormulaPool::FormulaId> formulaIds(cellCount);
+    std::vector<EvalState> states(cellCount);
+
+    std::memcpy(positions.data(), positionSection, cellCount * sizeof(Coordinates));
+    std::memcpy(values.data(), valueSection, cellCount * sizeof(double));
+    std::memcpy(formulaIds.data(), formulaIdSection, cellCount * sizeof(uint32_t));
+    std::memcpy(states.data(), stateSection, cellCount);
+
+    std::vector<size_t> uses(formulaCount, 0);
+    for (size_t i = 0; i < cellCount; ++i) {
+        if (formulaIds[i] >= formulaCount || static_cast<uint8_t>(states[i]) > static_cast<uint8_t>(EvalState::Evaluated)) {
+            throw std::runtime_error("Corrupt snapshot");
+        }
+        ++uses[formulaIds[i]];
+    }
+
+    CellStore cells;
+    for (size_t i = 0; i < formulaCount; ++i) {
+        FormulaRecord record{};
+        std::memcpy(&record, formulaSection + i * sizeof(FormulaRecord), sizeof(record));
+
+        const uint64_t textLength = static_cast<uint64_t>(record.textLength) + record.errorLength;
+        if (record.textOffset > header.textBytes || textLength > header.textBytes - record.textOffset ||
+            record.codeOffset > header.instructionCount ||
+            record.codeLength > header.instructionCount - record.codeOffset) {
+            throw std::runtime_error("Corrupt snapshot");
+        }
+
+        Program program;
+        program.maxStack = static_cast<size_t>(record.maxStack);
+        program.error.assign(textSection + record.textOffset + record.textLength, record.errorLength);
+        program.code.reserve(static_cast<size_t>(record.codeLength));
+
+        for (uint64_t k = 0; k < record.codeLength; ++k) {
+            InstructionRecord saved{};
+            std::memcpy(&saved, codeSection + (record.codeOffset + k) * sizeof(InstructionRecord), sizeof(saved));
+            if (saved.op > static_cast<uint8_t>(OpCode::Avg)) {
+                throw std::runtime_error("Corrupt snapshot");
+            }
+
+            Instruction& instruction = program.code.emplace_back(static_cast<OpCode>(saved.op));
+            instruction.number = saved.number;
+            instruction.ref = CellReference(saved.refRow, saved.refCol, saved.flags & 1, saved.flags & 2);
+            instruction.rangeEnd = CellReference(saved.endRow, saved.endCol, saved.flags & 4, saved.flags & 8);
+            instruction.target = static_cast<size_t>(saved.target);
+        }
+
+        if (!isWellFormed(program)) {
+            throw std::runtime_error("Corrupt snapshot");
+        }
+
+        try {
+            cells.restoreFormula(std::string_view(textSection + record.textOffset, record.textLength),
+                                 std::move(program), uses[i]);
+        } catch (const std::runtime_error&) {
+            throw std::runtime_error("Corrupt snapshot");
+        }
+    }
+
+    try {
+        cells.restoreCells(std::move(positions), std::move(formulaIds), std::move(values), std::move(states));
+    } catch (const std::runtime_error&) {
+        throw std::runtime_error("Corrupt snapshot");
+    }
+
+    table.restore(std::move(cells), Coordinates(header.focusRow, header.focusCol));
+}
@@ -0,0 +1,141 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "Table.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Versioned binary image of a table.
+ *
+ * A snapshot holds everything a CSV file loses: the cached value and
+ * evaluation state of every cell and the compiled program of every
+ * distinct formula. Opening a snapshot therefore neither parses nor
+ * recalculates anything; the file is memory-mapped and its arrays are
+ * copied into the table's CellStore as they are.
+ *
+ * Layout (native byte order, every section aligned to 8 bytes):
+ *
+ *     Header
+ *     FormulaRecord[formulaCount]
+ *     InstructionRecord[instructionCount]
+ *     Coordinates[cellCount]     positions
+ *     double[cellCount]          cached values
+ *     uint32_t[cellCount]        formula index of each cell
+ *     uint8_t[cellCount]         evaluation states
+ *     char[textBytes]            expression and error texts
+ *
+ * The header starts with a magic string, the format version and a byte
+ * order mark; files with another version or byte order are rejected.
+ */
+class Snapshot {
+public:
+    static constexpr uint32_t VERSION = 1; ///< Version written by save()
+
+private:
+    /**
+     * @brief Fixed-size start of a snapshot file.
+     */
+    struct Header {
+        char magic[8];             ///< MAGIC
+        uint32_t version;          ///< Format version
+        uint32_t byteOrder;        ///< BYTE_ORDER_MARK as written by the saving machine
+        uint64_t cellCount;        ///< Number of cells
+        uint64_t formulaCount;     ///< Number of distinct formulas
+        uint64_t instructionCount; ///< Number of instructions of all programs
+        uint64_t textBytes;        ///< Size of the text section
+        int64_t focusRow;          ///< Row of the focused cell
+        int64_t focusCol;          ///< Column of the focused cell
+    };
+
+    /**
+     * @brief A distinct formula: its text and program.
+     *
+     * The error text of a formula that failed to compile directly follows
+     * its expression text.
+     */
+    struct FormulaRecord {
+        uint64_t textOffset;       ///< Offset of the expression in the text section
+        uint32_t textLength;       ///< Length of the expression
+        uint32_t errorLength;      ///< Length of the compilation error (0 on success)
+        uint64_t codeOffset;       ///< Index of the first instruction
+        uint64_t codeLength;       ///< Number of instructions
+        uint64_t maxStack;         ///< Maximum stack depth of the program
+    };
+
+    /**
+     * @brief An Instruction without padding, so files are byte-for-byte reproducible.
+     */
+    struct InstructionRecord {
+        double number;             ///< Instruction::number
+        int64_t refRow;            ///< Instruction::ref row
+        int64_t refCol;            ///< Instruction::ref column
+        int64_t endRow;            ///< Instruction::rangeEnd row
+        int64_t endCol;            ///< Instruction::rangeEnd column
+        uint64_t target;           ///< Instruction::target
+        uint8_t op;                ///< Instruction::op
+        uint8_t flags;             ///< Relative flags of `ref` and `rangeEnd` (bits 0-3)
+        uint8_t padding[6];        ///< Always zero
+    };
+
+    static constexpr char MAGIC[8] = {'E', 'T', 'S', 'N', 'A', 'P', '\r', '\n'}; ///< First bytes of every snapshot
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;                        ///< Reads differently on other byte orders
+
+    /**
+     * @brief Rounds a section size up to the section alignment.
+     *
+     * @param bytes Size of a section
+     * @return Size including the padding after it
+     */
+    static uint64_t aligned(uint64_t bytes) {
+        return (bytes + 7) & ~static_cast<uint64_t>(7);
+    }
+
+    /**
+     * @brief Checks that a restored program cannot leave its stack.
+     *
+     * Jumps must go forward, every instruction must find enough operands
+     * on the stack and must be reached with the same depth on every path,
+     * the depth must stay within maxStack and the program must end with
+     * exactly one value. Programs written by the compiler always pass.
+     *
+     * @param program Program read from a snapshot
+     * @return true if the program is safe to execute
+     */
+    static bool isWellFormed(const Program& program);
+
+public:
+    /**
+     * @brief Writes a table to a snapshot file.
+     *
+     * Formulas are renumbered densely, so ids of dropped formulas leave no
+     * gaps. Cells that are being evaluated are saved as dirty.
+     *
+     * @param fileName Path to the output file
+     * @param table Table to save
+     *
+     * @throws std::runtime_error if the file cannot be opened or written
+     */
+    static void save(const std::string& fileName, const Table& table);
+
+    /**
+     * @brief Replaces the contents of a table with a snapshot.
+     *
+     * Cells saved as evaluated keep their values and are not recalculated;
+     * the dependency graph is built on the first edit (see Table::restore()).
+     * The table is left unchanged if the file is rejected.
+     *
+     * @param fileName Path to the snapshot file
+     * @param table Table to fill
+     *
+     * @throws std::runtime_error if the file cannot be opened, is not a
+     *         snapshot, has an unsupported version or is corrupt
+     */
+    static void load(const std::string& fileName, Table& table);
+};
+
+#endif // SNAPSHOT_H
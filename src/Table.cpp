@@ -3,23 +3,80 @@
 //
 
 #include "Table.h"
+#include "Evaluator.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+
+namespace {
+    /// Ranges of cells per thread when restore() is given a pool
+    constexpr size_t RESTORE_RANGES_PER_THREAD = 4;
+}
 
 std::pair<int64_t, int64_t> Table::findTableBounds() const {
-    int64_t maxRow = 0;
-    int64_t maxCol = 0;
+    const Area bounds = cells.bounds();
+    return {std::max<int64_t>(0, bounds.maxRow()), std::max<int64_t>(0, bounds.maxCol())};
+}
+
+Table::Table() : cells(), focusedCoords(Coordinates()) {}
+
+void Table::set(Coordinates coords, std::string_view expression) {
+  if (this->batchOpen) {
+      this->batch.emplace_back(coords, std::string(expression));
+      return;
+  }
+
+  this->write(coords, expression);
+
+  const Coordinates changed = this->focusedCoords;
+  this->invalidateDependents(std::span<const Coordinates>(&changed, 1));
+}
+
+void Table::setMany(std::span<const CellUpdate> updates) {
+    TRACE_SPAN("set many", "table");
+    std::vector<Coordinates> changed;
+    changed.reserve(updates.size());
+
+    for (const auto& [coords, expression] : updates) {
+        this->write(coords, expression);
+        changed.push_back(this->focusedCoords);
+    }
+
+    this->invalidateDependents(changed);
+}
 
-    for (const auto& [key, cell] : cells) {
-        maxRow = std::max(maxRow, cell.coords.row);
-        maxCol = std::max(maxCol, cell.coords.col);
+void Table::beginBatch() {
+    if (this->batchOpen) {
+        throw std::runtime_error("A batch is already open");
     }
+    this->batch.clear();
+    this->batchOpen = true;
+}
+
+void Table::commitBatch() {
+    if (!this->batchOpen) {
+        throw std::runtime_error("No open batch for this table");
+    }
+
+    std::vector<CellUpdate> updates;
+    updates.swap(this->batch);
+    this->batchOpen = false;
 
-    return {maxRow, maxCol};
+    this->setMany(updates);
 }
 
-Table::Table() : cells(std::unordered_map<Coordinates, Cell, Hash>()), focusedCoords(Coordinates()) {}
+void Table::abortBatch() {
+    std::vector<CellUpdate>().swap(this->batch);
+    this->batchOpen = false;
+}
+
+bool Table::inBatch() const {
+    return this->batchOpen;
+}
 
-void Table::set(Coordinates coords, const std::string &expression) {
+void Table::write(Coordinates coords, std::string_view expression) {
   if(coords.row < 0 || coords.col < 0) {
       this->focusedCoords.row += coords.row;
       this->focusedCoords.col += coords.col;
@@ -28,103 +85,352 @@ void Table::set(Coordinates coords, const std::string &expression) {
       this->focusedCoords.col = coords.col;
   }
 
-  this->cells[this->focusedCoords] = Cell(expression, this->focusedCoords);
-    this->invalidateEvalState();
+  this->buildDependencies();
+
+  if (this->hasCell(this->focusedCoords)) {
+      this->updateDependencies(this->focusedCoords, false);
+  }
+
+  this->cells.put(this->focusedCoords, expression);
+  this->updateDependencies(this->focusedCoords, true);
 }
 
-std::string Table::get(Coordinates coords) const {
-  return this->cells.at(coords).expression;
+void Table::insert(const Coordinates &coords, std::string_view expression) {
+    if (this->batchOpen || this->hasCell(coords)) {
+        this->set(coords, expression);
+        return;
+    }
+
+    this->focusedCoords = coords;
+    this->cells.put(coords, expression);
+    this->dependenciesBuilt = false;
+    this->dirtyCells.push_back(coords);
 }
 
-double Table::sum(Coordinates leftCell, Coordinates rightCell) const {
-    return this->cells.at(leftCell).cachedValue
-    + this->cells.at(rightCell).cachedValue;
+void Table::reserve(size_t cellCount) {
+    this->cells.reserve(cellCount);
+    this->dirtyCells.reserve(cellCount);
 }
 
-int Table::count(Coordinates leftCell, Coordinates rightCell) const {
-    if (rightCell.row < leftCell.row) {
-        throw std::invalid_argument("Invalid x coordinates");
-    }
-    if (rightCell.col < leftCell.col) {
-        throw std::invalid_argument("Invalid y coordinates");
-    }
+void Table::restore(CellStore &&restored, const Coordinates &focus, ThreadPool* pool) {
+    this->cells = std::move(restored);
+    this->focusedCoords = focus;
+    this->clearDependencies();
+    this->dependenciesBuilt = this->cells.empty();
+
+    // Every range counts its dirty cells first, so it can then fill its
+    // own part of the list
+    const size_t count = this->cells.size();
+    const size_t rangeCount = pool == nullptr ? 1 : pool->size() * RESTORE_RANGES_PER_THREAD;
+    const size_t rangeSize = count / rangeCount + 1;
+    std::vector<size_t> firstDirty(rangeCount + 1, 0);
 
-    int counter = 0;
-    for(int64_t i = leftCell.row; i <= rightCell.row; ++i) {
-        for (int64_t j = leftCell.col; j <= rightCell.col; ++j) {
-            Coordinates currentCell = {i, j};
-            if(!this->cells.at(currentCell).expression.empty()) {
-                counter++;
+    auto forEachRange = [&](auto&& work) {
+        auto run = [&](size_t from, size_t to) {
+            for (size_t r = from; r < to; ++r) {
+                const size_t begin = std::min(count, r * rangeSize);
+                work(r, begin, std::min(count, begin + rangeSize));
             }
+        };
+        if (pool == nullptr) {
+            run(0, rangeCount);
+        } else {
+            pool->parallelFor(rangeCount, 1, run);
+        }
+    };
+
+    forEachRange([&](size_t r, size_t begin, size_t end) {
+        size_t dirty = 0;
+        for (size_t id = begin; id < end; ++id) {
+            dirty += this->cells.state(static_cast<CellStore::CellId>(id)) != EvalState::Evaluated;
         }
+        firstDirty[r + 1] = dirty;
+    });
+    for (size_t r = 0; r < rangeCount; ++r) {
+        firstDirty[r + 1] += firstDirty[r];
     }
 
-    return counter;
+    this->dirtyCells.clear();
+    this->dirtyCells.resize(firstDirty.back());
+    forEachRange([&](size_t r, size_t begin, size_t end) {
+        size_t next = firstDirty[r];
+        for (size_t id = begin; id < end; ++id) {
+            const CellStore::CellId cell = static_cast<CellStore::CellId>(id);
+            if (this->cells.state(cell) != EvalState::Evaluated) {
+                this->cells.setState(cell, EvalState::Dirty);
+                this->dirtyCells[next++] = this->cells.position(cell);
+            }
+        }
+    });
 }
 
-double Table::min(Coordinates leftCell, Coordinates rightCell) const {
-    const double left = this->cells.at(leftCell).cachedValue;
-    const double right = this->cells.at(rightCell).cachedValue;
+void Table::clear() {
+    TRACE_SPAN("clear", "table");
+    this->cells = CellStore();
+    this->focusedCoords = Coordinates();
+    this->dependenciesBuilt = true;
+
+    this->dependents = CoordinateMap<uint32_t>();
+    this->rangeDependents.clear();
+    std::vector<Coordinates>().swap(this->dirtyCells);
+    std::vector<Coordinates>().swap(this->precedentBuffer);
+    std::vector<Coordinates>().swap(this->pendingBuffer);
+    std::vector<DependentEdge>().swap(this->edges);
+    this->freeEdges = NO_EDGE;
+    this->abortBatch();
+}
 
-    if (left < right)
-        return left;
+const Coordinates& Table::getFocusedCoords() const {
+    return this->focusedCoords;
+}
 
-    return right;
+std::string Table::get(Coordinates coords) const {
+  return std::string(this->cells.expression(this->cells.at(coords)));
 }
 
-double Table::max(Coordinates leftCell, Coordinates rightCell) const {
-    const double left = this->cells.at(leftCell).cachedValue;
-    const double right = this->cells.at(rightCell).cachedValue;
+const Program& Table::getProgram(const Coordinates &coords) const {
+    return this->cells.program(this->cells.at(coords));
+}
 
-    if (left > right)
-        return left;
+bool Table::hasCell(const Coordinates &coords) const {
+    return this->cells.contains(coords);
+}
 
-    return right;
+double Table::sum(Coordinates leftCell, Coordinates rightCell) {
+    return Evaluator::aggregate(OpCode::Sum, Area(leftCell, rightCell), *this, EvaluationMode::Iterative);
 }
 
-double Table::avg(Coordinates leftCell, Coordinates rightCell) const {
-    const double left = this->cells.at(leftCell).cachedValue;
-    const double right = this->cells.at(rightCell).cachedValue;
+int Table::count(Coordinates leftCell, Coordinates rightCell) {
+    return static_cast<int>(Evaluator::aggregate(OpCode::Count, Area(leftCell, rightCell), *this,
+                                                 EvaluationMode::Iterative));
+}
 
-    return (left + right) / 2;
+double Table::min(Coordinates leftCell, Coordinates rightCell) {
+    return Evaluator::aggregate(OpCode::Min, Area(leftCell, rightCell), *this, EvaluationMode::Iterative);
 }
 
-const std::unordered_map<Coordinates, Cell, Hash>& Table::getCells() const {
+double Table::max(Coordinates leftCell, Coordinates rightCell) {
+    return Evaluator::aggregate(OpCode::Max, Area(leftCell, rightCell), *this, EvaluationMode::Iterative);
+}
+
+double Table::avg(Coordinates leftCell, Coordinates rightCell) {
+    return Evaluator::aggregate(OpCode::Avg, Area(leftCell, rightCell), *this, EvaluationMode::Iterative);
+}
+
+const CellStore& Table::getCells() const {
     return this->cells;
 }
 
 double Table::getCachedValue(const Coordinates &address) const {
-    return this->cells.at(address).cachedValue;
+    return this->cells.value(this->cells.at(address));
 }
 
 void Table::setCachedValue(double value, const Coordinates &address) {
-    this->cells.at(address).cachedValue = value;
+    this->cells.setValue(this->cells.at(address), value);
+}
+
+void Table::storeResult(CellStore::CellId id, double value) {
+    this->cells.setValue(id, value);
+    this->cells.setState(id, EvalState::Evaluated);
 }
 
 bool Table::isBeingEvaluated(const Coordinates &address) const {
-    auto it = evalState.find(address);
-    return it != evalState.end() &&
-           it->second == EvalState::Visiting;
+    const CellStore::CellId id = cells.find(address);
+    return id != CellStore::NO_CELL &&
+           cells.state(id) == EvalState::Visiting;
 }
 
 bool Table::isEvaluated(const Coordinates &address) const {
-    auto it = evalState.find(address);
-    return it != evalState.end() &&
-           it->second == EvalState::Evaluated;
+    const CellStore::CellId id = cells.find(address);
+    return id != CellStore::NO_CELL &&
+           cells.state(id) == EvalState::Evaluated;
 }
 
 void Table::markEvaluating(const Coordinates &address) {
-    evalState[address] = EvalState::Visiting;
+    cells.setState(cells.at(address), EvalState::Visiting);
 }
 
 void Table::markEvaluated(const Coordinates &address)  {
-    evalState[address] = EvalState::Evaluated;
+    cells.setState(cells.at(address), EvalState::Evaluated);
+}
+
+void Table::markDirty(const Coordinates &address) {
+    cells.setState(cells.at(address), EvalState::Dirty);
 }
 
 void Table::clearEvaluationState(const Coordinates &address)  {
-    evalState.erase(address);
+    const CellStore::CellId id = cells.find(address);
+    if (id != CellStore::NO_CELL) {
+        cells.setState(id, EvalState::Dirty);
+    }
 }
 
 void Table::invalidateEvalState() {
-    evalState.clear();
-}
\ No newline at end of file
+    TRACE_SPAN("invalidate all", "table");
+    cells.resetStates();
+
+    dirtyCells.assign(cells.begin(), cells.end());
+}
+
+std::vector<Coordinates> Table::getPrecedents(const Coordinates &address) const {
+    std::vector<Coordinates> precedents;
+
+    for (const Instruction& instruction : this->getProgram(address).code) {
+        if (instruction.op == OpCode::LoadRef) {
+            precedents.push_back(instruction.ref.resolve(address));
+        } else if (instruction.isAggregate()) {
+            Area area(instruction.ref.resolve(address), instruction.rangeEnd.resolve(address));
+            this->forEachCellInArea(area, [&](CellStore::CellId id) {
+                precedents.push_back(this->cells.position(id));
+            });
+        }
+    }
+
+    return precedents;
+}
+
+std::vector<Coordinates> Table::getDependents(const Coordinates &address) {
+    this->buildDependencies();
+
+    std::vector<Coordinates> result;
+    if (const uint32_t* head = dependents.find(address)) {
+        for (uint32_t e = *head; e != NO_EDGE; e = edges[e].next) {
+            result.push_back(edges[e].dependent);
+        }
+    }
+
+    // Edges are added at the front of the lists; report them in the order they were added
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+ProbeStatistics Table::getDependentsStatistics() {
+    this->buildDependencies();
+    return this->dependents.probeStatistics();
+}
+
+const std::vector<Coordinates>& Table::getDirtyCells() const {
+    return dirtyCells;
+}
+
+void Table::clearDirtyCells() {
+    dirtyCells.clear();
+}
+
+void Table::updateDependencies(const Coordinates &address, bool add) {
+    std::vector<Coordinates>& precedents = this->precedentBuffer;
+    precedents.clear();
+    bool aggregates = false;
+
+    for (const Instruction& instruction : this->getProgram(address).code) {
+        if (instruction.op == OpCode::LoadRef) {
+            precedents.push_back(instruction.ref.resolve(address));
+        } else if (instruction.isAggregate()) {
+            aggregates = true;
+            if (add) {
+                Area area(instruction.ref.resolve(address), instruction.rangeEnd.resolve(address));
+                rangeDependents.add(area, address);
+            }
+        }
+    }
+
+    if (aggregates && !add) {
+        rangeDependents.remove(address);
+    }
+
+    // A cell is registered once per precedent, even if it references it several times
+    std::sort(precedents.begin(), precedents.end());
+    precedents.erase(std::unique(precedents.begin(), precedents.end()), precedents.end());
+
+    for (const Coordinates& precedent : precedents) {
+        if (add) {
+            uint32_t entry = freeEdges;
+            if (entry != NO_EDGE) {
+                freeEdges = edges[entry].next;
+            } else {
+                entry = static_cast<uint32_t>(edges.size());
+                edges.emplace_back();
+            }
+
+            // New edges go to the front of the list
+            uint32_t* head = dependents.tryEmplace(precedent, NO_EDGE).first;
+            edges[entry] = {address, *head};
+            *head = entry;
+            continue;
+        }
+
+        uint32_t* head = dependents.find(precedent);
+        if (head == nullptr) {
+            continue;
+        }
+
+        uint32_t* link = head;
+        while (*link != NO_EDGE) {
+            const uint32_t entry = *link;
+            if (edges[entry].dependent == address) {
+                *link = edges[entry].next;
+                edges[entry].next = freeEdges;
+                freeEdges = entry;
+            } else {
+                link = &edges[entry].next;
+            }
+        }
+
+        if (*head == NO_EDGE) {
+            dependents.erase(precedent);
+        }
+    }
+}
+
+void Table::clearDependencies() {
+    this->dependents.clear();
+    this->rangeDependents.clear();
+    this->edges.clear();
+    this->freeEdges = NO_EDGE;
+}
+
+void Table::buildDependencies() {
+    if (this->dependenciesBuilt) {
+        return;
+    }
+
+    TRACE_SPAN("build dependencies", "table");
+    this->dependenciesBuilt = true;
+    this->clearDependencies();
+    this->dependents.reserve(this->cells.size());
+    this->edges.reserve(this->cells.size());
+    for (const Coordinates& c : this->cells) {
+        this->updateDependencies(c, true);
+    }
+}
+
+void Table::invalidateDependents(std::span<const Coordinates> changed) {
+    // The changed cells themselves are always recalculated
+    for (const Coordinates& address : changed) {
+        this->markDirty(address);
+        dirtyCells.push_back(address);
+    }
+
+    std::vector<Coordinates>& pending = this->pendingBuffer;
+    pending.assign(changed.begin(), changed.end());
+
+    auto invalidate = [&](const Coordinates& dependent) {
+        if (isEvaluated(dependent)) {
+            this->markDirty(dependent);
+            dirtyCells.push_back(dependent);
+            pending.push_back(dependent);
+        }
+    };
+
+    while (!pending.empty()) {
+        Coordinates current = pending.back();
+        pending.pop_back();
+
+        if (const uint32_t* head = dependents.find(current)) {
+            for (uint32_t e = *head; e != NO_EDGE; e = edges[e].next) {
+                invalidate(edges[e].dependent);
+            }
+        }
+        rangeDependents.forEachContaining(current, invalidate);
+    }
+}
@@ -5,9 +5,17 @@
 #ifndef TABLE_H
 #define TABLE_H
 
+#include "AreaIndex.h"
+#include "CellStore.h"
+#include "CoordinateMap.h"
 #include "Types.h"
-#include <unordered_map>
+#include <span>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
+
+class ThreadPool;
 
 /**
  * @brief Represents a sparse two-dimensional table of cells.
@@ -16,17 +24,96 @@
  * handling of large tables with mostly empty entries.
  */
 class Table {
+public:
+    using CellUpdate = std::pair<Coordinates, std::string>; ///< A cell and the expression to store in it
+
 private:
-    std::unordered_map<Coordinates, Cell, Hash> cells; ///< Stored non-empty cells
+    /**
+     * @brief An entry of a list of dependents.
+     *
+     * The lists of all cells share one vector, and entries of removed
+     * edges are chained into a free list and reused, so registering an
+     * edge does not allocate once the vector has grown.
+     */
+    struct DependentEdge {
+        Coordinates dependent; ///< Cell that references the key cell
+        uint32_t next;         ///< Index of the next entry of the list, or NO_EDGE
+    };
+
+    static constexpr uint32_t NO_EDGE = UINT32_MAX; ///< End of a list of dependents
+
+    CellStore cells; ///< Stored non-empty cells with their cached values and evaluation states
     Coordinates focusedCoords; ///< Currently focused cell
-    std::unordered_map<Coordinates, EvalState, Hash> evalState; ///< Stored states of the cells in the table
+    CoordinateMap<uint32_t> dependents; ///< Cell -> first entry of the list of cells that reference it
+    std::vector<DependentEdge> edges; ///< Entries of all lists of dependents
+    uint32_t freeEdges = NO_EDGE; ///< First entry of the free list
+    std::vector<Coordinates> precedentBuffer; ///< Reused by updateDependencies()
+    std::vector<Coordinates> pendingBuffer; ///< Reused by invalidateDependents()
+    std::vector<Coordinates> dirtyCells; ///< Cells that have to be recalculated
+    AreaIndex rangeDependents; ///< Aggregated areas and the cells that aggregate them
+    bool dependenciesBuilt = true; ///< False after insert() or restore(), until the dependency edges are first needed
+    std::vector<CellUpdate> batch; ///< Writes recorded since beginBatch(), applied by commitBatch()
+    bool batchOpen = false; ///< True between beginBatch() and commitBatch() or abortBatch()
+
+    /**
+     * @brief Stores an expression and updates the dependency edges, without invalidating.
+     *
+     * Moves the focus like set().
+     *
+     * @param coords Coordinates of the cell (negative values are relative to the focus)
+     * @param expression Expression to store in the cell
+     */
+    void write(Coordinates coords, std::string_view expression);
+
+    /**
+     * @brief Registers or removes the dependency edges of a cell.
+     *
+     * Every cell referenced by the cell's program gets (or loses) the
+     * cell in its list of dependents. Aggregated areas are registered as
+     * a whole in an AreaIndex, so cells created inside them later are
+     * also tracked.
+     *
+     * @param address the address of the cell
+     * @param add true to register the edges, false to remove them
+     */
+    void updateDependencies(const Coordinates& address, bool add);
+
+    /**
+     * @brief Registers the dependency edges of all cells if insert() or restore() skipped them.
+     *
+     * A loaded or restored table is often only evaluated and read, so the
+     * edges are built (from scratch) when an edit or a query needs them.
+     */
+    void buildDependencies();
+
+    /**
+     * @brief Removes all dependency edges.
+     */
+    void clearDependencies();
+
+    /**
+     * @brief Marks changed cells and all of their transitive dependents as dirty.
+     *
+     * The walk starts from all changed cells at once, so a cell reached
+     * from several of them is visited once. It stops at cells that are
+     * already dirty, because their dependents cannot hold a value
+     * computed from them.
+     * Aggregating cells are found by looking every reached cell up in
+     * the AreaIndex, so the cost follows the affected cells rather than
+     * the number of aggregated areas in the sheet.
+     *
+     * @param changed the addresses of the changed cells
+     */
+    void invalidateDependents(std::span<const Coordinates> changed);
 
 public:
     /**
      * @brief Computes the bounding rectangle of all non-empty cells.
      *
-     * Determines the maximum row and column indices occupied by any cell.
-     * If the table is empty, the returned values are implementation-defined.
+     * Determines the maximum row and column indices occupied by any cell
+     * (at least 0). The bounds are maintained by the CellStore as cells
+     * are added, so the call does not scan the cells.
+     * If the table is empty, (0, 0) is returned.
      *
      * @return Pair of (maxRow, maxCol)
      */
@@ -43,12 +130,129 @@ public:
      * @brief Sets or updates the expression of a cell.
      *
      * If the cell at the given coordinates does not exist, it is created.
-     * Any previously cached value is expected to be recomputed on demand.
+     * The expression is compiled here, once per distinct text: cells with
+     * the same expression share one compiled program (see FormulaPool).
+     * Compilation errors are kept in the program and reported when the
+     * cell is evaluated.
+     * Only the cell and its transitive dependents are marked dirty,
+     * cached values of all other cells remain valid.
+     * While a batch is open (see beginBatch()), the write is only
+     * recorded and applied by commitBatch().
      *
      * @param coords Coordinates of the cell
      * @param expression Expression to store in the cell
      */
-    void set(Coordinates coords, const std::string &expression);
+    void set(Coordinates coords, std::string_view expression);
+
+    /**
+     * @brief Sets the expressions of several cells as one change.
+     *
+     * The updates are applied in order with the same rules as set(),
+     * including coordinates relative to the focus, so the resulting
+     * expressions and focus are those of calling set() for each update.
+     * The dependents of all changed cells are then invalidated in a
+     * single walk over the union of the affected cells, instead of one
+     * walk per update.
+     *
+     * @param updates Cells and their new expressions
+     */
+    void setMany(std::span<const CellUpdate> updates);
+
+    /**
+     * @brief Opens a batch of writes.
+     *
+     * Following set() and insert() calls are recorded instead of being
+     * applied one by one; reads see the table as it was before the batch
+     * until commitBatch(). A batch that is neither committed nor aborted
+     * is discarded with the table (or by clear()).
+     *
+     * @throws std::runtime_error if a batch is already open
+     */
+    void beginBatch();
+
+    /**
+     * @brief Applies the recorded writes with setMany() and closes the batch.
+     *
+     * The batch is closed before the writes are applied, so an exception
+     * leaves no batch open. Recalculation is left to the caller.
+     *
+     * @throws std::runtime_error if no batch is open
+     */
+    void commitBatch();
+
+    /**
+     * @brief Discards the recorded writes and closes the batch.
+     *
+     * Does nothing if no batch is open.
+     */
+    void abortBatch();
+
+    /**
+     * @brief Checks whether a batch is open.
+     *
+     * @return true between beginBatch() and commitBatch() or abortBatch()
+     */
+    bool inBatch() const;
+
+    /**
+     * @brief Adds a cell while a table is being filled in bulk.
+     *
+     * Like set(), but the dependents of the new cell are not walked: the
+     * cell is only stored and marked dirty. Its dependency edges are not
+     * registered either; they are built for all cells on the first edit
+     * (see restore()). This is valid when no cell of the table has been
+     * evaluated yet, as when a file is loaded into an empty table. If the
+     * position is already occupied, the call falls back to set(). While a
+     * batch is open, the cell is recorded like a set().
+     *
+     * @param coords Coordinates of the cell (absolute)
+     * @param expression Expression to store in the cell
+     */
+    void insert(const Coordinates& coords, std::string_view expression);
+
+    /**
+     * @brief Reserves room for a number of cells.
+     *
+     * @param cellCount Expected number of cells
+     */
+    void reserve(size_t cellCount);
+
+    /**
+     * @brief Replaces the contents of the table with previously saved cells.
+     *
+     * Cached values and evaluation states come with the cells, so cells
+     * saved as evaluated need no recalculation; all others are marked
+     * dirty. The dependency edges are not built here but on the first
+     * edit (or getDependents() call), which keeps opening a saved table
+     * proportional to copying its arrays.
+     *
+     * With a pool, the list of dirty cells is filled by ranges of cells
+     * on the pool's threads.
+     *
+     * @param restored Cells to take over (see CellStore::restoreCells())
+     * @param focus Focused cell of the saved table
+     * @param pool Threads to collect the dirty cells with, or nullptr to use the calling thread
+     */
+    void restore(CellStore&& restored, const Coordinates& focus, ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Removes all cells and releases their memory.
+     *
+     * Cells, formula texts, programs and dependency edges live in a few
+     * large arrays and arenas, so the table is released with a handful
+     * of deallocations instead of one or more per cell. The focus moves
+     * back to (0, 0) and an open batch is discarded.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the currently focused cell.
+     *
+     * Negative coordinates passed to set() are relative to it.
+     *
+     * @return Coordinates of the focused cell
+     */
+    const Coordinates& getFocusedCoords() const;
 
     /**
      * @brief Retrieves the expression stored in a cell.
@@ -60,25 +264,73 @@ public:
      */
     std::string get(Coordinates coords) const;
 
+    /**
+     * @brief Retrieves the compiled expression of a cell.
+     *
+     * @param coords Coordinates of the cell
+     * @return Program compiled from the cell's expression
+     *
+     * @throws std::out_of_range if the cell does not exist
+     */
+    const Program& getProgram(const Coordinates& coords) const;
+
+    /**
+     * @brief Checks whether a cell exists at the given coordinates.
+     *
+     * @param coords Cell coordinates
+     * @return true if the cell exists, false otherwise
+     */
+    bool hasCell(const Coordinates& coords) const;
+
+    /**
+     * @brief Visits the existing cells inside an area in row-major order.
+     *
+     * The cost follows the number of occupied tiles, not the size of
+     * the rectangle (see CellStore::forEachInArea()).
+     *
+     * The visitor receives the CellStore id of each cell, so its state,
+     * value and position can be read from getCells() without another
+     * lookup by coordinates.
+     *
+     * @param area Rectangle to visit (corners may be given in any order)
+     * @param visit Function called with the id of every existing cell
+     */
+    template <typename Visitor>
+    void forEachCellInArea(const Area& area, Visitor&& visit) const {
+        cells.forEachInArea(area, std::forward<Visitor>(visit));
+    }
+
     /**
      * @brief Computes the sum of all non-empty cells in a rectangular area.
      *
-     * Only cells that exist and contain expressions are considered.
+     * A cell is non-empty if it exists in the table, i.e. set() was
+     * called for it; positions that were never set are skipped. These
+     * helpers share Evaluator::aggregate() with the sum, count, min, max
+     * and avg functions of the expression language, so they return the
+     * same results and raise the same errors. Cells without a cached
+     * value are evaluated first; a cell whose expression cannot be
+     * evaluated (an empty one included) makes the helper throw.
      *
      * @param leftCell Upper-left corner of the area
      * @param rightCell Bottom-right corner of the area
-     * @return Sum of evaluated cell values
+     * @return Sum of evaluated cell values (0 for an empty area)
+     *
+     * @throws std::runtime_error if a cell in the area cannot be evaluated
      */
-    double sum(Coordinates leftCell, Coordinates rightCell) const;
+    double sum(Coordinates leftCell, Coordinates rightCell);
 
     /**
      * @brief Counts non-empty cells in a rectangular area.
      *
+     * Every existing cell is counted; like sum(), the cells are evaluated.
+     *
      * @param leftCell Upper-left corner of the area
      * @param rightCell Bottom-right corner of the area
      * @return Number of existing cells within the area
+     *
+     * @throws std::runtime_error if a cell in the area cannot be evaluated
      */
-    int count(Coordinates leftCell, Coordinates rightCell) const;
+    int count(Coordinates leftCell, Coordinates rightCell);
 
     /**
      * @brief Finds the minimum value among non-empty cells in a rectangular area.
@@ -86,8 +338,11 @@ public:
      * @param leftCell Upper-left corner of the area
      * @param rightCell Bottom-right corner of the area
      * @return Minimum evaluated value
+     *
+     * @throws std::runtime_error if the area holds no cells or a cell
+     *         cannot be evaluated
      */
-    double min(Coordinates leftCell, Coordinates rightCell) const;
+    double min(Coordinates leftCell, Coordinates rightCell);
 
     /**
      * @brief Finds the maximum value among non-empty cells in a rectangular area.
@@ -95,25 +350,33 @@ public:
      * @param leftCell Upper-left corner of the area
      * @param rightCell Bottom-right corner of the area
      * @return Maximum evaluated value
+     *
+     * @throws std::runtime_error if the area holds no cells or a cell
+     *         cannot be evaluated
      */
-    double max(Coordinates leftCell, Coordinates rightCell) const;
+    double max(Coordinates leftCell, Coordinates rightCell);
 
     /**
      * @brief Computes the average value of non-empty cells in a rectangular area.
      *
+     * The average is sum() divided by count() over the same cells.
+     *
      * @param leftCell Upper-left corner of the area
      * @param rightCell Bottom-right corner of the area
      * @return Average evaluated value
+     *
+     * @throws std::runtime_error if the area holds no cells or a cell
+     *         cannot be evaluated
      */
-    double avg(Coordinates leftCell, Coordinates rightCell) const;
+    double avg(Coordinates leftCell, Coordinates rightCell);
 
     /**
      * @brief Provides read-only access to all stored cells.
      * Intended for inspection, debugging, or iteration.
      *
-     * @return Reference to the internal cell map
+     * @return Reference to the internal cell store
      */
-    const std::unordered_map<Coordinates, Cell, Hash> &getCells() const;
+    const CellStore &getCells() const;
 
     /**
     * @brief Finds the cached value of a cell in the table
@@ -131,6 +394,16 @@ public:
     */
     void setCachedValue(double value, const Coordinates &address);
 
+    /**
+     * @brief Stores the evaluated value of a cell and marks it as evaluated.
+     *
+     * Used by batch evaluation, which already knows the ids of the cells.
+     *
+     * @param id Id of the cell in the table's CellStore
+     * @param value Evaluated value
+     */
+    void storeResult(CellStore::CellId id, double value);
+
     /**
      * @brief Checks if the cell is currently visited and if its value is being evaluated right now
      *
@@ -159,13 +432,25 @@ public:
     /**
      * @brief Marks the cell as evaluated.
      *
+     * Evaluation states are kept in a dense array next to the cached
+     * values, so concurrent calls for different cells are safe.
+     *
      * @param address the address of the cell
      */
     void markEvaluated(const Coordinates& address);
 
+    /**
+     * @brief Marks the cell as waiting for recalculation.
+     *
+     * @param address the address of the cell
+     */
+    void markDirty(const Coordinates& address);
+
     /**
      * @brief Clears the evaluation state of the cell.
      *
+     * Does nothing if the cell does not exist.
+     *
      * @param address the address of the cell
      */
     void clearEvaluationState(const Coordinates& address);
@@ -175,6 +460,50 @@ public:
      */
     void invalidateEvalState();
 
+    /**
+     * @brief Finds the cells referenced by the expression of a cell.
+     *
+     * Relative references are resolved against the cell's coordinates.
+     * References in every branch of the expression are reported, and
+     * aggregated areas contribute the cells that currently exist in them.
+     *
+     * @param address the address of the cell
+     * @return Coordinates of the referenced cells
+     */
+    std::vector<Coordinates> getPrecedents(const Coordinates& address) const;
+
+    /**
+     * @brief Finds the cells whose expressions reference a cell.
+     *
+     * @param address the address of the cell
+     * @return Coordinates of the dependent cells
+     */
+    std::vector<Coordinates> getDependents(const Coordinates& address);
+
+    /**
+     * @brief Measures the probe lengths of the map of dependents.
+     *
+     * Builds the dependency edges first if they were skipped.
+     *
+     * @return Probe-length statistics of the map from cells to their lists of dependents
+     */
+    ProbeStatistics getDependentsStatistics();
+
+    /**
+     * @brief Provides the cells that have to be recalculated.
+     *
+     * The list may also contain duplicates and cells that were evaluated
+     * on demand after being marked dirty; such entries can be skipped.
+     *
+     * @return Reference to the list of dirty cells
+     */
+    const std::vector<Coordinates>& getDirtyCells() const;
+
+    /**
+     * @brief Empties the list of dirty cells after a recalculation.
+     */
+    void clearDirtyCells();
+
 };
 
 #endif // TABLE_H
\ No newline at end of file
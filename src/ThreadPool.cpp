@@ -0,0 +1,165 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <memory>
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : slices(std::max<size_t>(threadCount, 1)), job(nullptr), grain(1),
+      generation(0), running(0), stopping(false) {
+    for (size_t id = 1; id < slices.size(); ++id) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, id);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::forCurrentThread(size_t threadCount) {
+    thread_local std::unique_ptr<ThreadPool> pool;
+    if (!pool || pool->size() != std::max<size_t>(threadCount, 1)) {
+        pool.reset();
+        pool = std::make_unique<ThreadPool>(threadCount);
+    }
+    return *pool;
+}
+
+size_t ThreadPool::size() const {
+    return slices.size();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain,
+                             const std::function<void(size_t, size_t)> &body) {
+    if (count == 0) {
+        return;
+    }
+
+    // Small loops are not worth waking anybody up
+    if (workers.empty() || count <= grain) {
+        body(0, count);
+        return;
+    }
+
+    const size_t threads = slices.size();
+    for (size_t id = 0; id < threads; ++id) {
+        std::lock_guard<std::mutex> lock(slices[id].mutex);
+        slices[id].begin = count * id / threads;
+        slices[id].end = count * (id + 1) / threads;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->job = &body;
+        this->grain = std::max<size_t>(grain, 1);
+        this->running = workers.size();
+        ++this->generation;
+    }
+    wakeUp.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return running == 0; });
+    this->job = nullptr;
+}
+
+void ThreadPool::workerLoop(size_t id) {
+    size_t seenGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        work(id);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --running;
+        }
+        finished.notify_one();
+    }
+}
+
+void ThreadPool::work(size_t id) {
+    size_t begin;
+    size_t end;
+
+    do {
+        while (take(id, begin, end)) {
+            (*job)(begin, end);
+        }
+    } while (steal(id));
+}
+
+bool ThreadPool::take(size_t id, size_t &begin, size_t &end) {
+    Slice& slice = slices[id];
+    std::lock_guard<std::mutex> lock(slice.mutex);
+
+    if (slice.begin >= slice.end) {
+        return false;
+    }
+
+    begin = slice.begin;
+    end = std::min(slice.end, slice.begin + grain);
+    slice.begin = end;
+    return true;
+}
+
+bool ThreadPool::steal(size_t id) {
+    while (true) {
+        // Pick the victim with the most remaining work
+        size_t victim = id;
+        size_t largest = 0;
+        for (size_t other = 0; other < slices.size(); ++other) {
+            if (other == id) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(slices[other].mutex);
+            size_t remaining = slices[other].end - std::min(slices[other].begin, slices[other].end);
+            if (remaining > largest) {
+                largest = remaining;
+                victim = other;
+            }
+        }
+
+        if (victim == id) {
+            return false;
+        }
+
+        size_t begin;
+        size_t end;
+        {
+            std::lock_guard<std::mutex> lock(slices[victim].mutex);
+            Slice& slice = slices[victim];
+            if (slice.begin >= slice.end) {
+                continue; // The victim finished meanwhile, look again
+            }
+            size_t remaining = slice.end - slice.begin;
+            begin = slice.end - (remaining + 1) / 2;
+            end = slice.end;
+            slice.end = begin;
+        }
+
+        std::lock_guard<std::mutex> lock(slices[id].mutex);
+        slices[id].begin = begin;
+        slices[id].end = end;
+        return true;
+    }
+}
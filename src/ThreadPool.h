@@ -0,0 +1,130 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed-size pool of worker threads with range work stealing.
+ *
+ * The pool executes parallel loops. Every loop is split into one
+ * contiguous slice per worker; a worker consumes its own slice in
+ * small chunks from the front, and when it runs out of work it steals
+ * the back half of the largest remaining slice of another worker.
+ * The calling thread takes part in the loop as worker 0.
+ */
+class ThreadPool {
+    /**
+     * @brief The part of the current loop owned by one worker.
+     */
+    struct Slice {
+        std::mutex mutex; ///< Guards begin and end
+        size_t begin = 0; ///< First index not yet taken
+        size_t end = 0;   ///< One past the last index of the slice
+    };
+
+    std::vector<std::thread> workers;  ///< Background threads (workers 1..n-1)
+    std::vector<Slice> slices;         ///< One slice per worker, including the caller
+
+    std::mutex mutex;                  ///< Guards the job state below
+    std::condition_variable wakeUp;    ///< Signals a new job or shutdown
+    std::condition_variable finished;  ///< Signals that all workers left the job
+    const std::function<void(size_t, size_t)>* job; ///< Body of the current loop
+    size_t grain;                      ///< Number of indices taken at once
+    size_t generation;                 ///< Incremented for every new job
+    size_t running;                    ///< Background workers still inside the job
+    bool stopping;                     ///< Set when the pool is destroyed
+
+    /**
+     * @brief Main loop of a background worker.
+     *
+     * @param id Index of the worker's slice
+     */
+    void workerLoop(size_t id);
+
+    /**
+     * @brief Runs chunks of the current job until no work is left anywhere.
+     *
+     * @param id Index of the worker's own slice
+     */
+    void work(size_t id);
+
+    /**
+     * @brief Takes the next chunk from a worker's own slice.
+     *
+     * @param id Index of the slice
+     * @param begin Receives the first index of the chunk
+     * @param end Receives one past the last index of the chunk
+     * @return true if a chunk was taken
+     */
+    bool take(size_t id, size_t& begin, size_t& end);
+
+    /**
+     * @brief Moves the back half of another worker's slice into a worker's slice.
+     *
+     * @param id Index of the stealing worker
+     * @return true if any work was stolen
+     */
+    bool steal(size_t id);
+
+public:
+    /**
+     * @brief Starts a pool.
+     *
+     * @param threadCount Total number of threads, including the caller (at least 1)
+     */
+    explicit ThreadPool(size_t threadCount);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Stops and joins all background workers.
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Returns a pool kept for the calling thread.
+     *
+     * The pool is started on the first call and reused by later calls
+     * with the same thread count, so repeated recalculations and loads
+     * do not start and join their workers every time. A call with a
+     * different count replaces the pool. Every calling thread has its
+     * own pool, so loops started from different threads do not share
+     * workers.
+     *
+     * @param threadCount Total number of threads, including the caller
+     * @return Pool of threadCount threads (at least 1)
+     */
+    static ThreadPool& forCurrentThread(size_t threadCount);
+
+    /**
+     * @brief Returns the number of threads taking part in a loop.
+     *
+     * @return Thread count, including the caller
+     */
+    size_t size() const;
+
+    /**
+     * @brief Executes a loop over [0, count) in parallel.
+     *
+     * The body is called with disjoint index ranges that together cover
+     * the loop. The call returns when the whole loop has finished. The
+     * body must not throw.
+     *
+     * @param count Number of loop indices
+     * @param grain Number of indices handed to the body at once (at least 1)
+     * @param body Function called with a half-open range [begin, end)
+     */
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+};
+
+#endif // THREAD_POOL_H
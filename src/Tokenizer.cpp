@@ -3,6 +3,7 @@
 //
 
 #include "Tokenizer.h"
+#include <charconv>
 #include <stdexcept>
 
 void Tokenizer::skipWhitespace() {
@@ -11,9 +12,9 @@ void Tokenizer::skipWhitespace() {
     }
 }
 
-Token* Tokenizer::tokenizeNumber() {
+std::optional<Token> Tokenizer::tokenizeNumber() {
     if (!std::isdigit(input[pos])) {
-        return nullptr;
+        return std::nullopt;
     }
 
     size_t start = pos;
@@ -21,54 +22,67 @@ Token* Tokenizer::tokenizeNumber() {
         ++pos;
     }
 
-    return new Token{TokenType::Number, input.substr(start, pos - start)};
+    Token token{TokenType::Number, input.substr(start, pos - start)};
+    auto [end, ec] = std::from_chars(token.lexeme.data(), token.lexeme.data() + token.lexeme.size(), token.number);
+    if (ec != std::errc() || end != token.lexeme.data() + token.lexeme.size()) {
+        throw std::runtime_error("Invalid number");
+    }
+    return token;
 }
 
-Token* Tokenizer::tokenizeCellReference() {
+std::optional<Token> Tokenizer::tokenizeCellReference() {
     if (input[pos] != 'R') {
-        return nullptr;
+        return std::nullopt;
     }
 
     size_t start = pos++;
 
-    auto parseIndex = [&]() {
-        if (pos < input.size() && input[pos] == '[') {
+    // Decodes one coordinate while walking over it
+    auto parseIndex = [&](int64_t& value, bool& relative) {
+        relative = pos < input.size() && input[pos] == '[';
+        if (relative) {
             ++pos;
-            if (pos < input.size() && (input[pos] == '-' || std::isdigit(input[pos]))) {
-                ++pos;
-                while (pos < input.size() && std::isdigit(input[pos])) {
-                    ++pos;
-                }
-            }
+        }
+
+        size_t digits = pos;
+        if (relative && pos < input.size() && input[pos] == '-') {
+            ++pos;
+        }
+        while (pos < input.size() && std::isdigit(input[pos])) {
+            ++pos;
+        }
+
+        auto [end, ec] = std::from_chars(input.data() + digits, input.data() + pos, value);
+        if (ec != std::errc() || end != input.data() + pos) {
+            throw std::runtime_error(relative ? "Invalid relative reference" : "Invalid absolute reference");
+        }
+
+        if (relative) {
             if (pos >= input.size() || input[pos] != ']') {
                 throw std::runtime_error("Invalid relative reference");
             }
             ++pos;
-        } else {
-            if (!std::isdigit(input[pos])) {
-                throw std::runtime_error("Invalid absolute reference");
-            }
-            while (pos < input.size() && std::isdigit(input[pos])) {
-                ++pos;
-            }
         }
     };
 
-    parseIndex();  // row
+    CellReference reference;
+    parseIndex(reference.row, reference.rowRelative);
 
     if (pos >= input.size() || input[pos] != 'C') {
         throw std::runtime_error("Invalid cell reference (missing C)");
     }
     ++pos;
 
-    parseIndex();  // column
+    parseIndex(reference.col, reference.colRelative);
 
-    return new Token{TokenType::CellRef, input.substr(start, pos - start)};
+    Token token{TokenType::CellRef, input.substr(start, pos - start)};
+    token.reference = reference;
+    return token;
 }
 
-Token* Tokenizer::tokenizeIdentifier() {
+std::optional<Token> Tokenizer::tokenizeIdentifier() {
     if (!std::isalpha(static_cast<unsigned char>(input[pos]))) {
-        return nullptr;
+        return std::nullopt;
     }
 
     size_t start = pos++;
@@ -77,26 +91,32 @@ Token* Tokenizer::tokenizeIdentifier() {
         ++pos;
            }
 
-    return new Token{TokenType::Identifier, input.substr(start, pos - start)};
+    return Token{TokenType::Identifier, input.substr(start, pos - start)};
 }
 
 Token Tokenizer::tokenizeOperator() {
+    const size_t start = pos;
     char c = input[pos++];
 
+    auto token = [&](TokenType type) {
+        return Token{type, input.substr(start, pos - start)};
+    };
+
     switch (c) {
-        case '+': return {TokenType::Plus, "+"};
-        case '-': return {TokenType::Minus, "-"};
-        case '*': return {TokenType::Mul, "*"};
-        case '/': return {TokenType::Div, "/"};
-        case '%': return {TokenType::Mod, "%"};
-        case '(': return {TokenType::LParen, "("};
-        case ')': return {TokenType::RParen, ")"};
-        case ',': return {TokenType::Comma, ","};
+        case '+': return token(TokenType::Plus);
+        case '-': return token(TokenType::Minus);
+        case '*': return token(TokenType::Mul);
+        case '/': return token(TokenType::Div);
+        case '%': return token(TokenType::Mod);
+        case '(': return token(TokenType::LParen);
+        case ')': return token(TokenType::RParen);
+        case ',': return token(TokenType::Comma);
+        case ':': return token(TokenType::Colon);
 
         case '=': {
             if (pos < input.size() && input[pos] == '=') {
                 ++pos;
-                return {TokenType::Equal, "=="};
+                return token(TokenType::Equal);
             }
             break;
         }
@@ -104,43 +124,37 @@ Token Tokenizer::tokenizeOperator() {
         case '!': {
             if (pos < input.size() && input[pos] == '=') {
                 ++pos;
-                return {TokenType::NotEqual, "!="};
+                return token(TokenType::NotEqual);
             }
             break;
         }
 
-        case '<': return {TokenType::Less, "<"};
-        case '>': return {TokenType::Greater, ">"};
+        case '<': return token(TokenType::Less);
+        case '>': return token(TokenType::Greater);
         default: break;
     }
 
     throw std::runtime_error(std::string("Unexpected character: ") + c);
 }
 
-Tokenizer::Tokenizer(const std::string &input)
+Tokenizer::Tokenizer(std::string_view input)
     : input(input), pos(0) {}
 
 Token Tokenizer::next() {
     skipWhitespace();
 
     if (pos >= input.size()) {
-        return {TokenType::End, ""};
+        return {TokenType::End, input.substr(pos)};
     }
 
     if (auto t = tokenizeNumber()) {
-        Token temp(t->type,t->lexeme);
-        delete t;
-        return temp;
+        return *t;
     }
     if (auto t = tokenizeCellReference()) {
-        Token temp(t->type,t->lexeme);
-        delete t;
-        return temp;
+        return *t;
     }
-    if (auto t = tokenizeIdentifier())    {
-        Token temp(t->type,t->lexeme);
-        delete t;
-        return temp;
+    if (auto t = tokenizeIdentifier()) {
+        return *t;
     }
 
     return tokenizeOperator();
@@ -6,6 +6,8 @@
 #define TOKENIZER_H
 
 #include "Types.h"
+#include <optional>
+#include <string_view>
 
 /**
  * @brief Performs lexical analysis of an expression string.
@@ -14,10 +16,14 @@
  * that can be consumed by the ExpressionParser. It recognizes
  * numeric literals, operators, identifiers, keywords, and cell
  * references, while ignoring whitespace.
+ *
+ * The input is not copied and tokens refer to it (see Token), so
+ * tokenizing allocates nothing; the expression must outlive the
+ * Tokenizer and the tokens it returns.
  */
 class Tokenizer {
-    const std::string input; ///< Expression being tokenized
-    size_t pos;               ///< Current position in the input string
+    std::string_view input; ///< Expression being tokenized
+    size_t pos;             ///< Current position in the input string
 
     /**
      * @brief Skips whitespace characters.
@@ -32,10 +38,12 @@ class Tokenizer {
      *
      * Supports integer and floating-point representations.
      *
-     * @return Token of type Number if a numeric literal is found,
-     *         otherwise std::nullopt
+     * @return Token of type Number with its decoded value if a numeric
+     *         literal is found, otherwise std::nullopt
+     *
+     * @throws std::runtime_error if the literal is out of range
      */
-    Token* tokenizeNumber();
+    std::optional<Token> tokenizeNumber();
 
     /**
      * @brief Attempts to tokenize a cell reference.
@@ -44,13 +52,15 @@ class Tokenizer {
      * - Absolute: R5C3
      * - Relative: R[-1]C[0]
      *
-     * @return Token of type CellRef if successful,
-     *         otherwise std::nullopt
+     * Both coordinates are decoded while they are read.
+     *
+     * @return Token of type CellRef with its decoded reference if
+     *         successful, otherwise std::nullopt
      *
      * @throws std::runtime_error if the syntax resembles a cell
-     *         reference but is malformed.
+     *         reference but is malformed or a coordinate is out of range.
      */
-    Token* tokenizeCellReference();
+    std::optional<Token> tokenizeCellReference();
 
     /**
      * @brief Attempts to tokenize an identifier.
@@ -61,7 +71,7 @@ class Tokenizer {
      * @return Token of type Identifier if successful,
      *         otherwise std::nullopt
      */
-    Token* tokenizeIdentifier();
+    std::optional<Token> tokenizeIdentifier();
 
     /**
      * @brief Tokenizes operators and punctuation.
@@ -71,6 +81,7 @@ class Tokenizer {
      * - Comparison operators: ==, !=, <, >
      * - Parentheses: (, )
      * - Comma: ,
+     * - Colon: : (separates the corners of an area)
      *
      * @return Token representing the parsed operator or symbol
      *
@@ -82,9 +93,9 @@ public:
     /**
      * @brief Constructs a Tokenizer for an expression.
      *
-     * @param input Expression string to tokenize
+     * @param input Expression string to tokenize; it must outlive the tokens
      */
-    explicit Tokenizer(const std::string& input);
+    explicit Tokenizer(std::string_view input);
 
     /**
      * @brief Retrieves the next token from the input.
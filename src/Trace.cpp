@@ -0,0 +1,85 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "Trace.h"
+#include "OutputBuffer.h"
+
+#include <fstream>
+#include <stdexcept>
+
+std::atomic<bool> Trace::enabled(false);
+std::mutex Trace::mutex;
+std::string Trace::fileName;
+Trace::Clock::time_point Trace::origin;
+std::vector<Trace::Event> Trace::events;
+
+uint32_t Trace::threadId() {
+    static std::atomic<uint32_t> nextId(1);
+    thread_local const uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void Trace::record(const char *name, const char *category,
+                   Clock::time_point start, Clock::time_point end) {
+    const uint32_t thread = Trace::threadId();
+
+    std::lock_guard<std::mutex> lock(Trace::mutex);
+    if (!Trace::isEnabled()) {
+        return;
+    }
+
+    Trace::events.push_back({
+        name, category, thread,
+        std::chrono::duration_cast<std::chrono::microseconds>(start - Trace::origin).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+    });
+}
+
+void Trace::start(const std::string &traceFile) {
+    std::lock_guard<std::mutex> lock(Trace::mutex);
+    Trace::fileName = traceFile;
+    Trace::events.clear();
+    Trace::origin = Clock::now();
+    Trace::enabled.store(true, std::memory_order_relaxed);
+}
+
+void Trace::stop() {
+    std::vector<Event> finished;
+    std::string traceFile;
+    {
+        std::lock_guard<std::mutex> lock(Trace::mutex);
+        if (!Trace::isEnabled()) {
+            return;
+        }
+        Trace::enabled.store(false, std::memory_order_relaxed);
+        finished.swap(Trace::events);
+        traceFile = Trace::fileName;
+    }
+
+    std::ofstream out(traceFile, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open file for writing");
+    }
+
+    // Names and categories are string literals without characters to escape
+    OutputBuffer buffer(out);
+    buffer.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (size_t i = 0; i < finished.size(); ++i) {
+        const Event& event = finished[i];
+        buffer.append(i == 0 ? "\n" : ",\n");
+        buffer.append("{\"name\":\"");
+        buffer.append(event.name);
+        buffer.append("\",\"cat\":\"");
+        buffer.append(event.category);
+        buffer.append("\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+        buffer.appendInteger(event.thread);
+        buffer.append(",\"ts\":");
+        buffer.appendInteger(event.start);
+        buffer.append(",\"dur\":");
+        buffer.appendInteger(event.duration);
+        buffer.append('}');
+    }
+    buffer.append("\n]}\n");
+    buffer.flush();
+}
@@ -0,0 +1,138 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Timeline of the phases of a run in the Chrome trace-event format.
+ *
+ * Spans mark phases such as parsing, inserting, building dependencies and
+ * evaluating; they are recorded with the thread that ran them while
+ * tracing is on and written as JSON by stop(). The file opens in
+ * chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Tracing is switched on and off at run time. A span checks the switch
+ * once when it starts, so a span costs a single branch while tracing is
+ * off.
+ */
+class Trace {
+public:
+    using Clock = std::chrono::steady_clock; ///< Clock used for all timestamps
+
+private:
+    /**
+     * @brief A finished span ("complete" event of the trace format).
+     */
+    struct Event {
+        const char* name;     ///< Phase name (a string literal)
+        const char* category; ///< Subsystem of the phase (a string literal)
+        uint32_t thread;      ///< Trace id of the thread that ran the span
+        int64_t start;        ///< Start in microseconds since start()
+        int64_t duration;     ///< Duration in microseconds
+    };
+
+    static std::atomic<bool> enabled;  ///< Runtime switch
+    static std::mutex mutex;           ///< Guards the fields below
+    static std::string fileName;       ///< File written by stop()
+    static Clock::time_point origin;   ///< Time of start()
+    static std::vector<Event> events;  ///< Finished spans
+
+    /**
+     * @brief Returns the trace id of the calling thread.
+     *
+     * Threads are numbered in the order they first finish a span.
+     */
+    static uint32_t threadId();
+
+    /**
+     * @brief Stores a finished span.
+     */
+    static void record(const char* name, const char* category,
+                       Clock::time_point start, Clock::time_point end);
+
+public:
+    /**
+     * @brief Times a phase from construction to destruction.
+     *
+     * Nothing is recorded if tracing was off when the span started.
+     */
+    class Span {
+        const char* name;          ///< Phase name
+        const char* category;      ///< Subsystem of the phase
+        bool active;               ///< Tracing was on at the start
+        Clock::time_point start;   ///< Start of the phase
+
+    public:
+        /**
+         * @param name Phase name; must be a string literal
+         * @param category Subsystem of the phase; must be a string literal
+         */
+        Span(const char* name, const char* category)
+            : name(name), category(category), active(Trace::isEnabled()) {
+            if (this->active) {
+                this->start = Clock::now();
+            }
+        }
+
+        ~Span() {
+            this->end();
+        }
+
+        /**
+         * @brief Ends the phase before the end of the scope.
+         */
+        void end() {
+            if (this->active) {
+                this->active = false;
+                Trace::record(this->name, this->category, this->start, Clock::now());
+            }
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+    };
+
+    /**
+     * @brief Returns whether spans are being recorded.
+     */
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Starts recording spans.
+     *
+     * Spans recorded before are discarded. Timestamps of the trace are
+     * relative to this call.
+     *
+     * @param traceFile Path of the JSON file written by stop()
+     */
+    static void start(const std::string& traceFile);
+
+    /**
+     * @brief Stops recording and writes the trace file.
+     *
+     * Spans that are still running when tracing stops are not recorded.
+     * Does nothing if tracing is off.
+     *
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    static void stop();
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/// Traces the rest of the enclosing scope as a phase
+#define TRACE_SPAN(name, category) Trace::Span TRACE_CONCAT(traceSpan, __LINE__)(name, category)
+
+#endif // TRACE_H
@@ -7,7 +7,10 @@
 
 #include <chrono>
 #include <cstdint>
+#include <cstdlib>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <algorithm>
 
 /**
@@ -44,15 +47,65 @@ struct Coordinates {
     bool operator==(const Coordinates& other) const {
         return row == other.row && col == other.col;
     }
+
+    /**
+     * @brief Row-major ordering comparison operator.
+     *
+     * @param other Another Coordinates object
+     * @return true if this position comes before `other` in row-major order
+     */
+    bool operator<(const Coordinates& other) const {
+        return row < other.row || (row == other.row && col < other.col);
+    }
 };
 
 /**
  * @brief Hash functor for Coordinates.
  *
  * Intended for use with unordered containers
- * (e.g., std::unordered_map, std::unordered_set).
+ * (e.g., std::unordered_map, CoordinateMap).
  */
 struct Hash {
+    /// Environment variable that fixes the default seed (a decimal number)
+    static constexpr const char* SEED_VARIABLE = "ELECTRONIC_TABLE_HASH_SEED";
+
+    uint64_t seed; ///< Added to both coordinates before mixing
+
+    /**
+     * @brief Creates a hash with the process-wide default seed.
+     */
+    Hash() : seed(Hash::defaultSeed()) {}
+
+    /**
+     * @brief Creates a hash with a fixed seed.
+     *
+     * Equal seeds give equal hashes, and so equal layouts of the
+     * containers that use them, in every run.
+     *
+     * @param seed Seed of the hash
+     */
+    explicit Hash(uint64_t seed) : seed(seed) {}
+
+    /**
+     * @brief Returns the seed of default-constructed hashes.
+     *
+     * The seed is taken from the environment variable named by
+     * SEED_VARIABLE if it is set, which makes hash layouts reproducible
+     * for performance tests; otherwise it is random per process, which
+     * reduces hash collision attacks.
+     *
+     * @return Process-wide default seed
+     */
+    static uint64_t defaultSeed() {
+        static const uint64_t SEED = [] {
+            const char* fixed = std::getenv(SEED_VARIABLE);
+            if (fixed != nullptr && *fixed != '\0') {
+                return static_cast<uint64_t>(std::strtoull(fixed, nullptr, 10));
+            }
+            return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        }();
+        return SEED;
+    }
 
     /**
      * @brief SplitMix64 hash function.
@@ -75,18 +128,12 @@ struct Hash {
     /**
      * @brief Computes a hash value for Coordinates.
      *
-     * A fixed random seed is used to reduce hash collision
-     * attacks and improve distribution.
-     *
      * @param c Coordinates to hash
      * @return Hash value
      */
     size_t operator()(const Coordinates& c) const {
-        static const uint64_t FIXED_RANDOM =
-            std::chrono::steady_clock::now().time_since_epoch().count();
-
-        uint64_t h1 = splitmix64(static_cast<uint64_t>(c.row) + FIXED_RANDOM);
-        uint64_t h2 = splitmix64(static_cast<uint64_t>(c.col) + FIXED_RANDOM);
+        uint64_t h1 = splitmix64(static_cast<uint64_t>(c.row) + seed);
+        uint64_t h2 = splitmix64(static_cast<uint64_t>(c.col) + seed);
         return h1 ^ (h2 << 1);
     }
 };
@@ -154,37 +201,132 @@ struct Area {
     int64_t minCol() const {
         return std::min(from.col, to.col);
     }
+
+    /**
+     * @brief Checks whether a position lies inside the area.
+     *
+     * @param c Coordinates to check
+     * @return true if `c` is inside the rectangle (borders included)
+     */
+    bool contains(const Coordinates& c) const {
+        return c.row >= minRow() && c.row <= maxRow() &&
+               c.col >= minCol() && c.col <= maxCol();
+    }
 };
 
 /**
- * @brief Represents a spreadsheet cell.
+ * @brief Represents a decoded cell reference.
  *
- * A cell stores:
- * - The original expression
- * - A cached numeric value (after evaluation)
- * - Its position in the table
+ * Each part of the reference is either absolute (R5) or relative
+ * to the evaluated cell (R[-1]). Relative parts store an offset.
  */
-struct Cell {
-    std::string expression; ///< Raw expression text
-    double cachedValue;     ///< Cached evaluation result
-    Coordinates coords;     ///< Cell position
+struct CellReference {
+    int64_t row;      ///< Absolute row index or relative row offset
+    int64_t col;      ///< Absolute column index or relative column offset
+    bool rowRelative; ///< True if the row part is relative
+    bool colRelative; ///< True if the column part is relative
+
+    /**
+     * @brief Constructs a cell reference.
+     *
+     * @param row Row index or offset (default: 0)
+     * @param col Column index or offset (default: 0)
+     * @param rowRelative Whether the row part is relative (default: false)
+     * @param colRelative Whether the column part is relative (default: false)
+     */
+    CellReference(int64_t row = 0, int64_t col = 0,
+                  bool rowRelative = false, bool colRelative = false)
+        : row(row), col(col), rowRelative(rowRelative), colRelative(colRelative) {}
 
     /**
-     * @brief Constructs a Cell with default values.
+     * @brief Resolves the reference against the coordinates of the evaluated cell.
+     *
+     * @param anchor Coordinates of the cell that contains the reference
+     * @return Coordinates of the referenced cell
      */
-    Cell() : expression(""), coords({0,0}), cachedValue(0.0) {}
+    Coordinates resolve(const Coordinates& anchor) const {
+        return {
+            rowRelative ? anchor.row + row : row,
+            colRelative ? anchor.col + col : col
+        };
+    }
+};
+
+/**
+ * @brief Operations of a compiled expression program.
+ *
+ * Programs are executed on a stack of doubles. Logical values are
+ * represented as 1.0 (true) and 0.0 (false), and any value >= 1.0
+ * is treated as true.
+ */
+enum class OpCode {
+    PushNumber,  ///< Pushes `number`
+    LoadRef,     ///< Pushes the value of the cell addressed by `ref`
+    Negate,      ///< Unary minus
+    Not,         ///< Logical not
+    Add,         ///< '+'
+    Sub,         ///< '-'
+    Mul,         ///< '*'
+    Div,         ///< '/' (throws on division by zero)
+    Mod,         ///< '%'
+    Equal,       ///< '=='
+    NotEqual,    ///< '!='
+    Less,        ///< '<'
+    Greater,     ///< '>'
+    ToBool,      ///< Converts the top of the stack to 1.0 or 0.0
+    Jump,        ///< Unconditional jump to `target`
+    JumpIfFalse, ///< Pops the condition and jumps to `target` if it is false
+    AndJump,     ///< If the top is false replaces it with 0.0 and jumps, otherwise pops it
+    OrJump,      ///< If the top is true replaces it with 1.0 and jumps, otherwise pops it
+    Sum,         ///< Pushes the sum of the existing cells in the area `ref`:`rangeEnd`
+    Count,       ///< Pushes the number of existing cells in the area
+    Min,         ///< Pushes the minimum of the existing cells in the area
+    Max,         ///< Pushes the maximum of the existing cells in the area
+    Avg          ///< Pushes the average of the existing cells in the area
+};
+
+/**
+ * @brief A single instruction of a compiled expression program.
+ */
+struct Instruction {
+    OpCode op;              ///< Operation to execute
+    double number;          ///< Operand of PushNumber
+    CellReference ref;      ///< Operand of LoadRef, first corner of an aggregated area
+    CellReference rangeEnd; ///< Second corner of an aggregated area
+    size_t target;          ///< Jump destination (index into the program)
 
     /**
-     * @brief Constructs a Cell.
+     * @brief Constructs an instruction without operands.
      *
-     * The cached value is initialized to 0.0 and is expected
-     * to be updated after expression evaluation.
+     * @param op Operation to execute
+     */
+    explicit Instruction(OpCode op)
+        : op(op), number(0.0), ref(), rangeEnd(), target(0) {}
+
+    /**
+     * @brief Checks whether the instruction aggregates an area of cells.
      *
-     * @param expression Expression stored in the cell
-     * @param coords Coordinates of the cell
+     * @return true for Sum, Count, Min, Max and Avg
      */
-    Cell(const std::string& expression, Coordinates coords)
-        : expression(expression), cachedValue(0.0), coords(coords) {}
+    bool isAggregate() const {
+        return op == OpCode::Sum || op == OpCode::Count || op == OpCode::Min ||
+               op == OpCode::Max || op == OpCode::Avg;
+    }
+};
+
+/**
+ * @brief Represents an expression compiled once and executed many times.
+ *
+ * A program is produced by the ExpressionParser front end and executed
+ * by the Evaluator. If the expression could not be compiled, `error`
+ * holds the message that is reported when the program is executed.
+ */
+struct Program {
+    std::vector<Instruction> code; ///< Instructions in execution order
+    size_t maxStack;               ///< Maximum depth of the evaluation stack
+    std::string error;             ///< Compilation error (empty on success)
+
+    Program() : maxStack(0) {}
 };
 
 /**
@@ -202,6 +344,7 @@ enum TokenType {
     LParen,     ///< '('
     RParen,     ///< ')'
     Comma,      ///< ','
+    Colon,      ///< ':'
     Equal,      ///< '=='
     NotEqual,   ///< '!='
     Less,       ///< '<'
@@ -212,12 +355,19 @@ enum TokenType {
 
 /**
  * @brief Represents a single token in an expression.
+ *
+ * The lexeme is a view into the expression being tokenized, so tokens
+ * are small values that never allocate; they are valid only while that
+ * expression is. Numbers and cell references are decoded by the
+ * tokenizer as it reads them, so the parser does not read their text again.
  */
 struct Token {
-    TokenType type;     ///< Token category
-    std::string lexeme; ///< Raw token text
+    TokenType type;          ///< Token category
+    std::string_view lexeme; ///< Raw token text
+    double number;           ///< Value of a Number token
+    CellReference reference; ///< Decoded CellRef token
 
-    Token() : type(Start), lexeme("") {}
+    Token() : type(Start), number(0) {}
 
     /**
      * @brief Constructs a Token.
@@ -225,18 +375,27 @@ struct Token {
      * @param type Token type
      * @param lexeme Token text as it appears in the expression
      */
-    Token(TokenType type, std::string  lexeme)
-        : type(type), lexeme(std::move(lexeme)) {}
+    Token(TokenType type, std::string_view lexeme)
+        : type(type), lexeme(lexeme), number(0) {}
 };
 
 /**
  * @brief Represents the evaluation state of the cells in the table structure (class).
  */
-enum class EvalState {
+enum class EvalState : uint8_t {
+    Dirty,    ///< State that means the cell has to be recalculated (same as having no state)
     Visiting, ///< State that means if the table engine is visiting the cell right now or not
     Evaluated ///< State thet means if the table engine is evaluated already the value of the cell or not
 };
 
+/**
+ * @brief Selects how referenced cells are evaluated.
+ */
+enum class EvaluationMode {
+    Recursive, ///< Referenced cells are evaluated through nested calls (stack depth grows with reference chains)
+    Iterative  ///< Referenced cells are evaluated through an explicit work stack (bounded stack depth)
+};
+
 /**
  * @brief Represents the calculated result as a pair of status (didParse) and a double value.
  */
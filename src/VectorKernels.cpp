@@ -0,0 +1,85 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#include "VectorKernels.h"
+#include "VectorKernelsImpl.h"
+#include "Simd.h"
+#include <cmath>
+
+const VectorKernels::Variant VectorKernels::BASELINE = {
+        LANES, addKernel, subKernel, mulKernel, divKernel,
+        equalKernel, notEqualKernel, lessKernel, greaterKernel,
+        negateKernel, logicalNotKernel, toBoolKernel, hasZeroKernel
+};
+
+const VectorKernels::Variant &VectorKernels::variant() {
+    if (AVX2_VARIANT != nullptr && Simd::level() == SimdLevel::AVX2) {
+        return *AVX2_VARIANT;
+    }
+    return BASELINE;
+}
+
+size_t VectorKernels::width() {
+    return variant().width;
+}
+
+void VectorKernels::fill(double *a, double value, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = value;
+    }
+}
+
+void VectorKernels::add(double *a, const double *b, size_t n) {
+    variant().add(a, b, n);
+}
+
+void VectorKernels::sub(double *a, const double *b, size_t n) {
+    variant().sub(a, b, n);
+}
+
+void VectorKernels::mul(double *a, const double *b, size_t n) {
+    variant().mul(a, b, n);
+}
+
+void VectorKernels::div(double *a, const double *b, size_t n) {
+    variant().div(a, b, n);
+}
+
+void VectorKernels::mod(double *a, const double *b, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = std::fmod(a[i], b[i]);
+    }
+}
+
+void VectorKernels::equal(double *a, const double *b, size_t n) {
+    variant().equal(a, b, n);
+}
+
+void VectorKernels::notEqual(double *a, const double *b, size_t n) {
+    variant().notEqual(a, b, n);
+}
+
+void VectorKernels::less(double *a, const double *b, size_t n) {
+    variant().less(a, b, n);
+}
+
+void VectorKernels::greater(double *a, const double *b, size_t n) {
+    variant().greater(a, b, n);
+}
+
+void VectorKernels::negate(double *a, size_t n) {
+    variant().negate(a, n);
+}
+
+void VectorKernels::logicalNot(double *a, size_t n) {
+    variant().logicalNot(a, n);
+}
+
+void VectorKernels::toBool(double *a, size_t n) {
+    variant().toBool(a, n);
+}
+
+bool VectorKernels::hasZero(const double *a, size_t n) {
+    return variant().hasZero(a, n);
+}
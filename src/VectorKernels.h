@@ -0,0 +1,102 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+
+#ifndef VECTOR_KERNELS_H
+#define VECTOR_KERNELS_H
+
+#include <cstddef>
+
+/**
+ * @brief Element-wise operations over dense arrays of doubles.
+ *
+ * The kernels implement the arithmetic and comparison operations of
+ * compiled programs for many cells at once. Binary kernels compute
+ * `a[i] = a[i] op b[i]`, unary kernels update `a[i]` in place. Logical
+ * results are 1.0 and 0.0, exactly as in the scalar Evaluator.
+ *
+ * The kernels use SSE2 on x86-64 and plain loops on other architectures.
+ * A second set, compiled with AVX2 enabled in VectorKernelsAvx2.cpp,
+ * processes four doubles per instruction and runs when Simd::level()
+ * selects it. Operations without a vector form (fill, modulo) always run
+ * as scalar loops.
+ */
+class VectorKernels {
+public:
+    /**
+     * @brief Returns the number of doubles processed per vector instruction.
+     *
+     * @return 4 with AVX2, 2 with SSE2, 1 for the scalar fallback
+     */
+    static size_t width();
+
+    /// a[i] = value
+    static void fill(double* a, double value, size_t n);
+    /// a[i] = a[i] + b[i]
+    static void add(double* a, const double* b, size_t n);
+    /// a[i] = a[i] - b[i]
+    static void sub(double* a, const double* b, size_t n);
+    /// a[i] = a[i] * b[i]
+    static void mul(double* a, const double* b, size_t n);
+    /// a[i] = a[i] / b[i] (the caller checks for zero divisors)
+    static void div(double* a, const double* b, size_t n);
+    /// a[i] = fmod(a[i], b[i])
+    static void mod(double* a, const double* b, size_t n);
+    /// a[i] = (a[i] == b[i]) ? 1.0 : 0.0
+    static void equal(double* a, const double* b, size_t n);
+    /// a[i] = (a[i] != b[i]) ? 1.0 : 0.0
+    static void notEqual(double* a, const double* b, size_t n);
+    /// a[i] = (a[i] < b[i]) ? 1.0 : 0.0
+    static void less(double* a, const double* b, size_t n);
+    /// a[i] = (a[i] > b[i]) ? 1.0 : 0.0
+    static void greater(double* a, const double* b, size_t n);
+    /// a[i] = -a[i]
+    static void negate(double* a, size_t n);
+    /// a[i] = (a[i] < 1.0) ? 1.0 : 0.0
+    static void logicalNot(double* a, size_t n);
+    /// a[i] = (a[i] >= 1.0) ? 1.0 : 0.0
+    static void toBool(double* a, size_t n);
+
+    /**
+     * @brief Checks whether an array contains a zero (of either sign).
+     *
+     * @param a Array to check
+     * @param n Number of elements
+     * @return true if some a[i] == 0.0
+     */
+    static bool hasZero(const double* a, size_t n);
+
+private:
+    using BinaryKernel = void (*)(double* a, const double* b, size_t n);
+    using UnaryKernel = void (*)(double* a, size_t n);
+
+    /**
+     * @brief The kernels of one instruction set.
+     */
+    struct Variant {
+        size_t width;
+        BinaryKernel add;
+        BinaryKernel sub;
+        BinaryKernel mul;
+        BinaryKernel div;
+        BinaryKernel equal;
+        BinaryKernel notEqual;
+        BinaryKernel less;
+        BinaryKernel greater;
+        UnaryKernel negate;
+        UnaryKernel logicalNot;
+        UnaryKernel toBool;
+        bool (*hasZero)(const double* a, size_t n);
+    };
+
+    static const Variant BASELINE;            ///< Kernels for the default target of the compiler
+    static const Variant AVX2;                ///< AVX2 kernels; defined only when VectorKernelsAvx2.cpp is built with AVX2
+    static const Variant* const AVX2_VARIANT; ///< &AVX2, or nullptr if the library was built without it
+
+    /**
+     * @brief Returns the kernels of the level selected by Simd::level().
+     */
+    static const Variant& variant();
+};
+
+#endif // VECTOR_KERNELS_H
@@ -0,0 +1,23 @@
+//
+// Created by Petya Licheva on 10/18/2026.
+//
+// AVX2 variant of the VectorKernels. CMake compiles this file with AVX2
+// enabled on x86, so VectorKernelsImpl.h selects its 4-lane bodies;
+// elsewhere it only defines AVX2_VARIANT as nullptr.
+//
+
+#include "VectorKernels.h"
+
+#if defined(__AVX2__)
+#include "VectorKernelsImpl.h"
+
+const VectorKernels::Variant VectorKernels::AVX2 = {
+        LANES, addKernel, subKernel, mulKernel, divKernel,
+        equalKernel, notEqualKernel, lessKernel, greaterKernel,
+        negateKernel, logicalNotKernel, toBoolKernel, hasZeroKernel
+};
+
+const VectorKernels::Variant* const VectorKernels::AVX2_VARIANT = &VectorKernels::AVX2;
+#else
+const VectorKernels::Variant* const VectorKernels::AVX2_VARIANT = nullptr;
+#endif
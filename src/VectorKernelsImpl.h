@@ -0,0 +1,198 @@
+//
+// Created by Petya Licheva on 10/18/2026.
+//
+
+#ifndef VECTOR_KERNELS_IMPL_H
+#define VECTOR_KERNELS_IMPL_H
+
+// Bodies of the vectorized kernels, included by VectorKernels.cpp (baseline)
+// and VectorKernelsAvx2.cpp (compiled with AVX2). Everything here has
+// internal linkage, so each translation unit gets its own copy compiled
+// for its own instruction set and the linker never merges them.
+
+#include <cstddef>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+    // One register of doubles and the operations the kernels need. Every
+    // comparison yields an all-ones or all-zeros mask per element, which is
+    // turned into 1.0 / 0.0 by masking the bits of 1.0.
+#if defined(__AVX__)
+    using Lanes = __m256d;
+    constexpr size_t LANES = 4;
+
+    inline Lanes load(const double* p) { return _mm256_loadu_pd(p); }
+    inline void store(double* p, Lanes v) { _mm256_storeu_pd(p, v); }
+    inline Lanes broadcast(double x) { return _mm256_set1_pd(x); }
+    inline Lanes addLanes(Lanes a, Lanes b) { return _mm256_add_pd(a, b); }
+    inline Lanes subLanes(Lanes a, Lanes b) { return _mm256_sub_pd(a, b); }
+    inline Lanes mulLanes(Lanes a, Lanes b) { return _mm256_mul_pd(a, b); }
+    inline Lanes divLanes(Lanes a, Lanes b) { return _mm256_div_pd(a, b); }
+    inline Lanes andLanes(Lanes a, Lanes b) { return _mm256_and_pd(a, b); }
+    inline Lanes xorLanes(Lanes a, Lanes b) { return _mm256_xor_pd(a, b); }
+    inline Lanes eqMask(Lanes a, Lanes b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    inline Lanes neqMask(Lanes a, Lanes b) { return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ); }
+    inline Lanes ltMask(Lanes a, Lanes b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    inline Lanes gtMask(Lanes a, Lanes b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    inline Lanes geMask(Lanes a, Lanes b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+    inline bool anyMask(Lanes m) { return _mm256_movemask_pd(m) != 0; }
+#elif defined(__SSE2__)
+    using Lanes = __m128d;
+    constexpr size_t LANES = 2;
+
+    inline Lanes load(const double* p) { return _mm_loadu_pd(p); }
+    inline void store(double* p, Lanes v) { _mm_storeu_pd(p, v); }
+    inline Lanes broadcast(double x) { return _mm_set1_pd(x); }
+    inline Lanes addLanes(Lanes a, Lanes b) { return _mm_add_pd(a, b); }
+    inline Lanes subLanes(Lanes a, Lanes b) { return _mm_sub_pd(a, b); }
+    inline Lanes mulLanes(Lanes a, Lanes b) { return _mm_mul_pd(a, b); }
+    inline Lanes divLanes(Lanes a, Lanes b) { return _mm_div_pd(a, b); }
+    inline Lanes andLanes(Lanes a, Lanes b) { return _mm_and_pd(a, b); }
+    inline Lanes xorLanes(Lanes a, Lanes b) { return _mm_xor_pd(a, b); }
+    inline Lanes eqMask(Lanes a, Lanes b) { return _mm_cmpeq_pd(a, b); }
+    inline Lanes neqMask(Lanes a, Lanes b) { return _mm_cmpneq_pd(a, b); }
+    inline Lanes ltMask(Lanes a, Lanes b) { return _mm_cmplt_pd(a, b); }
+    inline Lanes gtMask(Lanes a, Lanes b) { return _mm_cmpgt_pd(a, b); }
+    inline Lanes geMask(Lanes a, Lanes b) { return _mm_cmpge_pd(a, b); }
+    inline bool anyMask(Lanes m) { return _mm_movemask_pd(m) != 0; }
+#else
+    constexpr size_t LANES = 1;
+#endif
+
+    /**
+     * @brief Applies a binary operation element-wise.
+     *
+     * @param vectorOp Operation on whole registers
+     * @param scalarOp Operation on single elements (used for the tail)
+     */
+    template <typename VectorOp, typename ScalarOp>
+    void binary(double* a, const double* b, size_t n, VectorOp vectorOp, ScalarOp scalarOp) {
+        size_t i = 0;
+#if defined(__AVX__) || defined(__SSE2__)
+        for (; i + LANES <= n; i += LANES) {
+            store(a + i, vectorOp(load(a + i), load(b + i)));
+        }
+#else
+        (void)vectorOp;
+#endif
+        for (; i < n; ++i) {
+            a[i] = scalarOp(a[i], b[i]);
+        }
+    }
+
+    /**
+     * @brief Applies a unary operation element-wise.
+     *
+     * @param vectorOp Operation on whole registers
+     * @param scalarOp Operation on single elements (used for the tail)
+     */
+    template <typename VectorOp, typename ScalarOp>
+    void unary(double* a, size_t n, VectorOp vectorOp, ScalarOp scalarOp) {
+        size_t i = 0;
+#if defined(__AVX__) || defined(__SSE2__)
+        for (; i + LANES <= n; i += LANES) {
+            store(a + i, vectorOp(load(a + i)));
+        }
+#else
+        (void)vectorOp;
+#endif
+        for (; i < n; ++i) {
+            a[i] = scalarOp(a[i]);
+        }
+    }
+
+    inline double boolValue(bool value) {
+        return value ? 1.0 : 0.0;
+    }
+
+#if defined(__AVX__) || defined(__SSE2__)
+#define VECTOR_OP(expr) [](Lanes x, Lanes y) { return expr; }
+#define VECTOR_UNARY_OP(expr) [](Lanes x) { return expr; }
+#define ONE broadcast(1.0)
+#else
+#define VECTOR_OP(expr) nullptr
+#define VECTOR_UNARY_OP(expr) nullptr
+#endif
+
+    void addKernel(double* a, const double* b, size_t n) {
+        binary(a, b, n, VECTOR_OP(addLanes(x, y)),
+               [](double x, double y) { return x + y; });
+    }
+
+    void subKernel(double* a, const double* b, size_t n) {
+        binary(a, b, n, VECTOR_OP(subLanes(x, y)),
+               [](double x, double y) { return x - y; });
+    }
+
+    void mulKernel(double* a, const double* b, size_t n) {
+        binary(a, b, n, VECTOR_OP(mulLanes(x, y)),
+               [](double x, double y) { return x * y; });
+    }
+
+    void divKernel(double* a, const double* b, size_t n) {
+        binary(a, b, n, VECTOR_OP(divLanes(x, y)),
+               [](double x, double y) { return x / y; });
+    }
+
+    void equalKernel(double* a, const double* b, size_t n) {
+        binary(a, b, n, VECTOR_OP(andLanes(eqMask(x, y), ONE)),
+               [](double x, double y) { return boolValue(x == y); });
+    }
+
+    void notEqualKernel(double* a, const double* b, size_t n) {
+        binary(a, b, n, VECTOR_OP(andLanes(neqMask(x, y), ONE)),
+               [](double x, double y) { return boolValue(x != y); });
+    }
+
+    void lessKernel(double* a, const double* b, size_t n) {
+        binary(a, b, n, VECTOR_OP(andLanes(ltMask(x, y), ONE)),
+               [](double x, double y) { return boolValue(x < y); });
+    }
+
+    void greaterKernel(double* a, const double* b, size_t n) {
+        binary(a, b, n, VECTOR_OP(andLanes(gtMask(x, y), ONE)),
+               [](double x, double y) { return boolValue(x > y); });
+    }
+
+    void negateKernel(double* a, size_t n) {
+        unary(a, n, VECTOR_UNARY_OP(xorLanes(x, broadcast(-0.0))),
+              [](double x) { return -x; });
+    }
+
+    void logicalNotKernel(double* a, size_t n) {
+        unary(a, n, VECTOR_UNARY_OP(andLanes(ltMask(x, ONE), ONE)),
+              [](double x) { return boolValue(x < 1.0); });
+    }
+
+    void toBoolKernel(double* a, size_t n) {
+        unary(a, n, VECTOR_UNARY_OP(andLanes(geMask(x, ONE), ONE)),
+              [](double x) { return boolValue(x >= 1.0); });
+    }
+
+    bool hasZeroKernel(const double* a, size_t n) {
+        size_t i = 0;
+#if defined(__AVX__) || defined(__SSE2__)
+        const Lanes zero = broadcast(0.0);
+        for (; i + LANES <= n; i += LANES) {
+            if (anyMask(eqMask(load(a + i), zero))) {
+                return true;
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            if (a[i] == 0.0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+#undef VECTOR_OP
+#undef VECTOR_UNARY_OP
+#undef ONE
+}
+
+#endif // VECTOR_KERNELS_IMPL_H
@@ -7,7 +7,7 @@
 #include <string>
 
 #include "CmdInterpreter.h"
-#include "ExpressionParser.h"
+#include "Evaluator.h"
 #include "Table.h"
 
 struct Workflow {
@@ -18,14 +18,7 @@ struct Workflow {
 };
 
 void evaluateAll(Table& table) {
-    for (const auto& el : table.getCells()) {
-        double value = ExpressionParser::evaluate(
-            el.second.expression,
-            table,
-            el.first
-        );
-        table.setCachedValue(value, el.first);
-    }
+    Evaluator::recalculate(table);
 }
 
 void executeWorkflow(const Workflow& wf) {
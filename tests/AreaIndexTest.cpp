@@ -0,0 +1,107 @@
+//
+// Created by Petya Licheva on 10/18/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/AreaIndex.h"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace {
+    std::vector<Coordinates> containing(const AreaIndex& index, const Coordinates& position) {
+        std::vector<Coordinates> found;
+        index.forEachContaining(position, [&](const Coordinates& dependent) {
+            found.push_back(dependent);
+        });
+        std::sort(found.begin(), found.end());
+        return found;
+    }
+}
+
+TEST_CASE("Area index finds the areas containing a position", "[areas]") {
+    AreaIndex index;
+    REQUIRE(index.empty());
+    REQUIRE(containing(index, {0,0}).empty());
+
+    index.add(Area({0,0}, {0,0}), {0,1});
+    index.add(Area({20,70}, {5,60}), {1,1});                       // across tile boundaries, corners swapped
+    index.add(Area({0,0}, {999999,3}), {2,1});                     // a long column
+    index.add(Area({-5,-5}, {-1,-1}), {3,1});                      // negative positions
+    const int64_t far = std::numeric_limits<int64_t>::max();
+    index.add(Area({std::numeric_limits<int64_t>::min(), 0}, {far, far}), {4,1}); // the widest area
+    REQUIRE(index.size() == 5);
+
+    REQUIRE(containing(index, {0,0}) == std::vector<Coordinates>{{0,1}, {2,1}, {4,1}});
+    REQUIRE(containing(index, {16,64}) == std::vector<Coordinates>{{1,1}, {4,1}});
+    REQUIRE(containing(index, {999999,3}) == std::vector<Coordinates>{{2,1}, {4,1}});
+    REQUIRE(containing(index, {1000000,3}) == std::vector<Coordinates>{{4,1}});
+    REQUIRE(containing(index, {-3,-3}) == std::vector<Coordinates>{{3,1}});
+    REQUIRE(containing(index, {-3,3}) == std::vector<Coordinates>{{4,1}});
+}
+
+TEST_CASE("Area index removes all areas of a dependent", "[areas]") {
+    AreaIndex index;
+    index.add(Area({0,0}, {10,10}), {0,20});
+    index.add(Area({5,5}, {5,5}), {0,20});
+    index.add(Area({0,0}, {10,10}), {1,20});
+
+    REQUIRE(containing(index, {5,5}) == std::vector<Coordinates>{{0,20}, {0,20}, {1,20}});
+
+    index.remove({0,20});
+    REQUIRE(index.size() == 1);
+    REQUIRE(containing(index, {5,5}) == std::vector<Coordinates>{{1,20}});
+
+    // Removed entries and buckets are reused
+    index.remove({0,20});
+    index.add(Area({5,5}, {6,6}), {2,20});
+    REQUIRE(containing(index, {6,6}) == std::vector<Coordinates>{{1,20}, {2,20}});
+
+    index.remove({1,20});
+    index.remove({2,20});
+    REQUIRE(index.empty());
+    REQUIRE(containing(index, {5,5}).empty());
+
+    index.add(Area({1,1}, {2,2}), {3,20});
+    index.clear();
+    REQUIRE(index.empty());
+    REQUIRE(containing(index, {1,1}).empty());
+}
+
+TEST_CASE("Area index matches a linear scan", "[areas]") {
+    AreaIndex index;
+    std::vector<std::pair<Area, Coordinates>> areas;
+
+    uint64_t state = 3;
+    auto next = [&](uint64_t bound) {
+        return static_cast<int64_t>(Hash::splitmix64(state++) % bound);
+    };
+
+    for (int step = 0; step < 3000; ++step) {
+        const Coordinates dependent(next(200), 500);
+        if (next(4) == 0) {
+            index.remove(dependent);
+            std::erase_if(areas, [&](const auto& area) { return area.second == dependent; });
+            continue;
+        }
+
+        // Mostly small areas, some spanning many blocks
+        const int64_t size = next(10) == 0 ? 2000 : 20;
+        const Coordinates from(next(3000) - 500, next(600) - 100);
+        const Area area(from, {from.row + next(size), from.col + next(size)});
+        index.add(area, dependent);
+        areas.emplace_back(area, dependent);
+    }
+    REQUIRE(index.size() == areas.size());
+
+    for (int query = 0; query < 2000; ++query) {
+        const Coordinates position(next(3600) - 600, next(800) - 200);
+        std::vector<Coordinates> expected;
+        for (const auto& [area, dependent] : areas) {
+            if (area.contains(position)) {
+                expected.push_back(dependent);
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(containing(index, position) == expected);
+    }
+}
@@ -0,0 +1,52 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/Arena.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+
+TEST_CASE("Arena stores texts back to back", "[arena]") {
+    Arena arena;
+    REQUIRE(arena.chunkCount() == 0);
+
+    std::string source = "R[-1]C[0] + 1";
+    std::string_view a = arena.store(source);
+    std::string_view b = arena.store("sum(R0C0:R9C0)");
+    source = "changed";
+
+    REQUIRE(a == "R[-1]C[0] + 1");
+    REQUIRE(b == "sum(R0C0:R9C0)");
+    REQUIRE(b.data() == a.data() + a.size());
+    REQUIRE(arena.size() == a.size() + b.size());
+    REQUIRE(arena.chunkCount() == 1);
+    REQUIRE(arena.store("").empty());
+}
+
+TEST_CASE("Arena grows by chunks and releases them at once", "[arena]") {
+    Arena arena;
+
+    void* aligned = arena.allocate(24, 16);
+    REQUIRE(reinterpret_cast<uintptr_t>(aligned) % 16 == 0);
+
+    // Texts larger than a chunk get a chunk of their own
+    std::string large(Arena::CHUNK_SIZE * 2, 'x');
+    std::string_view copy = arena.store(large);
+    REQUIRE(copy == large);
+    REQUIRE(arena.chunkCount() == 2);
+
+    for (int i = 0; i < 10000; ++i) {
+        arena.store("1234567890");
+    }
+    REQUIRE(arena.chunkCount() == 3);
+
+    Arena moved(std::move(arena));
+    REQUIRE(copy == large);
+    REQUIRE(moved.chunkCount() == 3);
+    REQUIRE(arena.chunkCount() == 0);
+
+    moved.release();
+    REQUIRE(moved.chunkCount() == 0);
+    REQUIRE(moved.size() == 0);
+}
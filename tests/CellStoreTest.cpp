@@ -0,0 +1,180 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/CellStore.h"
+#include "../src/ThreadPool.h"
+#include <vector>
+
+TEST_CASE("Cell store put and find", "[store]") {
+    CellStore store;
+    REQUIRE(store.empty());
+
+    store.put({0,0}, "1");
+    store.put({15,63}, "2");
+    store.put({16,64}, "3");
+    store.put({-1,-70}, "4");
+    store.put({100000,100000}, "5");
+
+    REQUIRE(store.size() == 5);
+    REQUIRE(store.expression(store.at({15,63})) == "2");
+    REQUIRE(store.expression(store.at({16,64})) == "3");
+    REQUIRE(store.expression(store.at({-1,-70})) == "4");
+    REQUIRE(store.position(store.at({-1,-70})) == Coordinates(-1,-70));
+    REQUIRE(store.find({1,1}) == CellStore::NO_CELL);
+    REQUIRE_FALSE(store.contains({100000,99999}));
+    REQUIRE_THROWS_AS(store.at({5,5}), std::out_of_range);
+
+    const CellStore::CellId id = store.at({15,63});
+    REQUIRE(store.put({15,63}, "6") == id);
+    REQUIRE(store.size() == 5);
+    REQUIRE(store.expression(id) == "6");
+
+    store.clear();
+    REQUIRE(store.empty());
+    REQUIRE(store.find({0,0}) == CellStore::NO_CELL);
+}
+
+TEST_CASE("Cell store keeps values and states per cell", "[store]") {
+    CellStore store;
+    const CellStore::CellId a = store.put({0,0}, "1");
+    const CellStore::CellId b = store.put({0,1}, "2");
+
+    REQUIRE(store.value(a) == 0.0);
+    REQUIRE(store.state(a) == EvalState::Dirty);
+
+    store.setValue(a, 4.0);
+    store.setState(a, EvalState::Evaluated);
+    store.setState(b, EvalState::Visiting);
+    REQUIRE(store.value(a) == 4.0);
+    REQUIRE(store.value(b) == 0.0);
+    REQUIRE(store.state(a) == EvalState::Evaluated);
+
+    store.resetStates();
+    REQUIRE(store.state(a) == EvalState::Dirty);
+    REQUIRE(store.state(b) == EvalState::Dirty);
+
+    // Replacing a cell resets its value and state
+    store.setValue(b, 9.0);
+    store.setState(b, EvalState::Evaluated);
+    store.put({0,1}, "3");
+    REQUIRE(store.value(b) == 0.0);
+    REQUIRE(store.state(b) == EvalState::Dirty);
+
+    REQUIRE(std::vector<Coordinates>(store.begin(), store.end()) == std::vector<Coordinates>{{0,0}, {0,1}});
+}
+
+TEST_CASE("Cell store visits areas in row-major order", "[store]") {
+    CellStore store;
+    std::vector<Coordinates> positions = {
+        {40,3}, {0,0}, {0,200}, {17,65}, {17,2}, {99999,9}, {3,64}, {500000,500000}
+    };
+    for (const Coordinates& c : positions) {
+        store.put(c, "1");
+    }
+
+    auto collect = [&](const Area& area) {
+        std::vector<Coordinates> visited;
+        store.forEachInArea(area, [&](CellStore::CellId id) {
+            visited.push_back(store.position(id));
+        });
+        return visited;
+    };
+
+    // Small area: overlapping tiles are scanned
+    REQUIRE(collect(Area({0,0}, {20,70})) == std::vector<Coordinates>{{0,0}, {3,64}, {17,2}, {17,65}});
+
+    // Huge area: allocated tiles are filtered
+    REQUIRE(collect(Area({99999,9}, {0,0})) == std::vector<Coordinates>{{0,0}, {17,2}, {40,3}, {99999,9}});
+    REQUIRE(collect(Area({1,1}, {2,2})).empty());
+}
+
+TEST_CASE("Cell store maintains its bounds", "[store]") {
+    CellStore store;
+    REQUIRE(store.bounds().from == Coordinates(0,0));
+    REQUIRE(store.bounds().to == Coordinates(0,0));
+
+    store.put({5,7}, "1");
+    REQUIRE(store.bounds().from == Coordinates(5,7));
+    REQUIRE(store.bounds().to == Coordinates(5,7));
+
+    store.put({-3,100}, "2");
+    store.put({20,-1}, "3");
+    store.put({5,7}, "4");
+    REQUIRE(store.bounds().from == Coordinates(-3,-1));
+    REQUIRE(store.bounds().to == Coordinates(20,100));
+
+    store.clear();
+    store.put({1000,1000}, "5");
+    REQUIRE(store.bounds().from == Coordinates(1000,1000));
+    REQUIRE(store.bounds().to == Coordinates(1000,1000));
+}
+
+TEST_CASE("Cell store row walks skip empty slots", "[store]") {
+    CellStore store;
+    // Both edges of a tile row and both sides of a tile boundary
+    for (int64_t col : {0, 1, 62, 63, 64, 127, 130}) {
+        store.put({16,col}, std::to_string(col));
+    }
+    store.put({17,5}, "x");
+
+    auto collect = [&](const Area& area) {
+        std::vector<int64_t> visited;
+        store.forEachInArea(area, [&](CellStore::CellId id) {
+            visited.push_back(store.position(id).col);
+        });
+        return visited;
+    };
+
+    REQUIRE(collect(Area({16,0}, {16,200})) == std::vector<int64_t>{0, 1, 62, 63, 64, 127, 130});
+    REQUIRE(collect(Area({16,1}, {16,63})) == std::vector<int64_t>{1, 62, 63});
+    REQUIRE(collect(Area({16,63}, {17,64})) == std::vector<int64_t>{63, 64});
+    REQUIRE(collect(Area({0,2}, {10000000,61})) == std::vector<int64_t>{5});
+}
+
+TEST_CASE("Cell store restores sorted cells on a pool", "[store]") {
+    // Rows of several tiles, columns on both sides of tile boundaries
+    std::vector<Coordinates> positions;
+    for (int64_t row = -20; row < 300; row += (row % 7 == 0 ? 3 : 1)) {
+        for (int64_t col : {-65, -1, 0, 63, 64, 200}) {
+            positions.push_back({row, col});
+        }
+    }
+
+    auto restore = [&](const std::vector<Coordinates>& cells, ThreadPool* pool) {
+        CellStore store;
+        store.restoreFormula("1", FormulaPool::compile("1"), cells.size());
+        store.restoreCells(cells, std::vector<FormulaPool::FormulaId>(cells.size(), 0),
+                           std::vector<double>(cells.size(), 0.0),
+                           std::vector<EvalState>(cells.size(), EvalState::Dirty), pool);
+        return store;
+    };
+
+    ThreadPool pool(4);
+    CellStore serial = restore(positions, nullptr);
+    CellStore parallel = restore(positions, &pool);
+
+    for (CellStore::CellId id = 0; id < positions.size(); ++id) {
+        REQUIRE(parallel.find(positions[id]) == id);
+    }
+    REQUIRE(parallel.find({1,0}) == CellStore::NO_CELL);
+    REQUIRE(parallel.bounds().from == serial.bounds().from);
+    REQUIRE(parallel.bounds().to == serial.bounds().to);
+
+    std::vector<CellStore::CellId> serialOrder;
+    std::vector<CellStore::CellId> parallelOrder;
+    serial.forEachInArea(serial.bounds(), [&](CellStore::CellId id) { serialOrder.push_back(id); });
+    parallel.forEachInArea(parallel.bounds(), [&](CellStore::CellId id) { parallelOrder.push_back(id); });
+    REQUIRE(parallelOrder == serialOrder);
+    REQUIRE(parallelOrder.size() == positions.size());
+
+    // Duplicates are found in every range; unsorted rows need the serial placement
+    std::vector<Coordinates> duplicate = positions;
+    duplicate[duplicate.size() / 2 + 1] = duplicate[duplicate.size() / 2];
+    REQUIRE_THROWS_AS(restore(duplicate, &pool), std::runtime_error);
+
+    std::vector<Coordinates> unsorted = positions;
+    std::swap(unsorted.front(), unsorted.back());
+    REQUIRE_THROWS_AS(restore(unsorted, &pool), std::runtime_error);
+    REQUIRE(restore(unsorted, nullptr).find(positions.back()) == 0);
+}
@@ -3,8 +3,12 @@
 //
 #include <catch2/catch_test_macros.hpp>
 #include "../src/CmdInterpreter.h"
+#include "../src/Evaluator.h"
 #include "../src/Table.h"
 #include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 TEST_CASE("Save and load table", "[cmd]") {
     Table t;
@@ -12,9 +16,8 @@ TEST_CASE("Save and load table", "[cmd]") {
     t.set({0,1}, "20");
 
     // Set cached values
-    auto cells = t.getCells();
-    for (auto& [coords, cell] : cells) {
-        cell.cachedValue = std::stod(cell.expression);
+    for (const Coordinates& c : t.getCells()) {
+        t.setCachedValue(std::stod(t.get(c)), c);
     }
 
     std::string filename = "test_table.csv";
@@ -31,4 +34,312 @@ TEST_CASE("Save and load table", "[cmd]") {
 
     // Cleanup
     std::remove(filename.c_str());
-}
\ No newline at end of file
+}
+TEST_CASE("Load scans rows and fields in place", "[cmd]") {
+    std::string filename = "test_load.csv";
+    {
+        std::ofstream out(filename);
+        out << "1;;R0C0 + 1\n;\n\n;;;7;\n5;R[-4]C[1]";
+    }
+
+    Table t;
+    CmdInterpreter::load(filename, t);
+
+    REQUIRE(t.getCells().size() == 5);
+    REQUIRE(t.get({0,0}) == "1");
+    REQUIRE(t.get({0,2}) == "R0C0 + 1");
+    REQUIRE(t.get({3,3}) == "7");
+    REQUIRE(t.get({4,0}) == "5");
+    REQUIRE(t.get({4,1}) == "R[-4]C[1]");
+    REQUIRE_FALSE(t.hasCell({0,1}));
+    REQUIRE(t.getDirtyCells().size() == 5);
+
+    // Loading into a table that is already evaluated invalidates dependents
+    Table evaluated;
+    evaluated.set({0,0}, "100");
+    evaluated.set({5,5}, "sum(R0C0:R4C4)");
+    Evaluator::recalculate(evaluated);
+    REQUIRE(evaluated.getCachedValue({5,5}) == 100.0);
+
+    CmdInterpreter::load(filename, evaluated);
+    Evaluator::recalculate(evaluated);
+    REQUIRE(evaluated.getCachedValue({5,5}) == 1.0 + 2.0 + 7.0 + 5.0 + 2.0);
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Load handles fields across scan windows", "[cmd]") {
+    std::string filename = "test_windows.csv";
+    {
+        std::ofstream out(filename);
+        for (int64_t row = 0; row < 20000; ++row) {
+            out << row << ";;R[0]C[-2] + 1\n";
+        }
+    }
+
+    Table t;
+    CmdInterpreter::load(filename, t);
+
+    REQUIRE(t.getCells().size() == 40000);
+    for (int64_t row = 0; row < 20000; ++row) {
+        REQUIRE(t.get({row,0}) == std::to_string(row));
+        REQUIRE(t.get({row,2}) == "R[0]C[-2] + 1");
+    }
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Parallel load matches the single-threaded load", "[cmd]") {
+    std::string filename = "test_parallel_load.csv";
+    {
+        std::ofstream out(filename);
+        for (int64_t row = 0; row < 40000; ++row) {
+            if (row % 7 == 3) {
+                out << "\n";
+                continue;
+            }
+            out << row << ";R[0]C[-1] * 2;;" << (row % 5 == 0 ? "" : "R[0]C[-3] + R[0]C[-2]") << "\n";
+        }
+        out << "1;;2";
+    }
+
+    Table serial;
+    Table parallel;
+    CmdInterpreter::load(filename, serial);
+    CmdInterpreter::load(filename, parallel, 4);
+
+    // Formulas are numbered in order of first use on both paths
+    const CellStore& serialCells = serial.getCells();
+    const CellStore& parallelCells = parallel.getCells();
+    REQUIRE(parallelCells.size() == serialCells.size());
+    REQUIRE(parallelCells.getFormulas().size() == serialCells.getFormulas().size());
+    for (CellStore::CellId id = 0; id < serialCells.size(); ++id) {
+        const Coordinates& c = serialCells.position(id);
+        REQUIRE(parallelCells.position(id) == c);
+        REQUIRE(parallelCells.formula(id) == serialCells.formula(id));
+        REQUIRE(parallelCells.getFormulas().uses(parallelCells.formula(id)) ==
+                serialCells.getFormulas().uses(serialCells.formula(id)));
+        REQUIRE(parallel.get(c) == serial.get(c));
+    }
+    REQUIRE(parallel.get({40000,2}) == "2");
+    REQUIRE(parallel.getFocusedCoords() == serial.getFocusedCoords());
+
+    // Loading into a non-empty table goes through set() on both paths
+    CmdInterpreter::load(filename, parallel, 4);
+    REQUIRE(parallel.getCells().size() == serial.getCells().size());
+
+    Evaluator::recalculate(serial);
+    Evaluator::recalculate(parallel);
+    REQUIRE(parallel.getCachedValue({39999,3}) == serial.getCachedValue({39999,3}));
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Load reports missing files", "[cmd]") {
+    Table t;
+    REQUIRE_THROWS_AS(CmdInterpreter::load("missing_file.csv", t), std::runtime_error);
+}
+
+TEST_CASE("Save visits only occupied cells", "[cmd]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({2,3}, "R0C0 * 2");
+    t.set({2,1}, "4");
+    t.set({3,0}, "5");
+
+    std::string filename = "test_save.csv";
+    CmdInterpreter::save(filename, t);
+
+    std::ifstream in(filename);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    REQUIRE(contents == "1\n\n;4;;R0C0 * 2\n5\n");
+
+    Table loaded;
+    CmdInterpreter::load(filename, loaded);
+    REQUIRE(loaded.getCells().size() == 4);
+    REQUIRE(loaded.get({2,3}) == "R0C0 * 2");
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Sparse save and load", "[cmd]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({100000,100000}, "R0C0 + 1");
+    t.set({5,2}, "sum(R0C0:R5C1)");
+
+    std::string filename = "test_sparse.csv";
+    CmdInterpreter::saveSparse(filename, t);
+
+    std::ifstream in(filename);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    REQUIRE(contents == "0;0;1\n5;2;sum(R0C0:R5C1)\n100000;100000;R0C0 + 1\n");
+    in.close();
+
+    Table loaded;
+    CmdInterpreter::loadSparse(filename, loaded);
+    REQUIRE(loaded.getCells().size() == 3);
+    REQUIRE(loaded.get({100000,100000}) == "R0C0 + 1");
+    REQUIRE(loaded.get({5,2}) == "sum(R0C0:R5C1)");
+
+    {
+        std::ofstream out(filename);
+        out << "1;x;2\n";
+    }
+    REQUIRE_THROWS_AS(CmdInterpreter::loadSparse(filename, loaded), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Printing covers exactly the requested area", "[cmd]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({1000000,5000}, "1 / 3");
+    t.set({1000001,5002}, "1000000");
+    t.set({1000002,5001}, "R[-2]C[-1] * 15 / 2");
+    t.set({1000001,5004}, "5");
+    Evaluator::recalculate(t);
+
+    auto capture = [](auto print) {
+        std::ostringstream out;
+        std::streambuf* previous = std::cout.rdbuf(out.rdbuf());
+        print();
+        std::cout.rdbuf(previous);
+        return out.str();
+    };
+
+    const Area area({1000000,5000}, {1000003,5002});
+    REQUIRE(capture([&] { CmdInterpreter::printValue(area, t); }) ==
+            "0.333333, , \n"
+            ", , 1e+06\n"
+            ", 2.5, \n"
+            ", , \n");
+
+    // Corners may be given in any order
+    const Area reversed({1000002,5002}, {1000001,5001});
+    REQUIRE(capture([&] { CmdInterpreter::printExpression(reversed, t); }) ==
+            ", 1000000\n"
+            "R[-2]C[-1] * 15 / 2, \n");
+
+    Table small;
+    small.set({1,1}, "2");
+    small.set({0,2}, "R1C1 - 4");
+    Evaluator::recalculate(small);
+    REQUIRE(capture([&] { CmdInterpreter::printAllValues(small); }) == ", , -2\n, 2, \n");
+    REQUIRE(capture([&] { CmdInterpreter::printAllExpressions(Table()); }).empty());
+}
+
+TEST_CASE("Map statistics list the table's hash maps", "[cmd]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({0,1}, "R0C0 + 1");
+    t.set({100,100}, "R0C0 * 2");
+
+    std::ostringstream out;
+    std::streambuf* previous = std::cout.rdbuf(out.rdbuf());
+    CmdInterpreter::printMapStatistics(t);
+    std::cout.rdbuf(previous);
+
+    std::istringstream lines(out.str());
+    std::string directory;
+    std::string dependents;
+    std::getline(lines, directory);
+    std::getline(lines, dependents);
+
+    REQUIRE(directory.rfind("tile directory", 0) == 0);
+    REQUIRE(directory.find(" 2 keys") != std::string::npos);
+    REQUIRE(dependents.rfind("dependents", 0) == 0);
+    REQUIRE(dependents.find(" 1 keys") != std::string::npos);
+    REQUIRE(dependents.find("probe avg") != std::string::npos);
+}
+
+TEST_CASE("Batched sets are applied and recalculated at commit", "[cmd]") {
+    Table t;
+    CmdInterpreter::set({0,0}, "1", t);
+    CmdInterpreter::set({1,0}, "R[-1]C[0] + 1", t);
+    CmdInterpreter::set({0,1}, "sum(R0C0:R1C0)", t);
+    Evaluator::recalculate(t);
+    REQUIRE(t.getCachedValue({0,1}) == 3.0);
+
+    CmdInterpreter::begin(t);
+    REQUIRE_THROWS_AS(CmdInterpreter::begin(t), std::runtime_error);
+
+    CmdInterpreter::set({0,0}, "10", t);
+    CmdInterpreter::set({2,0}, "R[-1]C[0] * 2", t);
+
+    // Other tables are not part of the batch
+    Table other;
+    CmdInterpreter::set({0,0}, "5", other);
+    REQUIRE(other.hasCell({0,0}));
+    REQUIRE_THROWS_AS(CmdInterpreter::commit(other), std::runtime_error);
+
+    // Nothing is applied before the commit
+    REQUIRE(t.get({0,0}) == "1");
+    REQUIRE_FALSE(t.hasCell({2,0}));
+
+    CmdInterpreter::commit(t);
+    REQUIRE(t.getCachedValue({0,0}) == 10.0);
+    REQUIRE(t.getCachedValue({1,0}) == 11.0);
+    REQUIRE(t.getCachedValue({2,0}) == 22.0);
+    REQUIRE(t.getCachedValue({0,1}) == 21.0);
+    REQUIRE(t.getDirtyCells().empty());
+
+    // The batch is closed: writes apply directly again
+    REQUIRE_THROWS_AS(CmdInterpreter::commit(t), std::runtime_error);
+    CmdInterpreter::set({0,0}, "2", t);
+    REQUIRE(t.get({0,0}) == "2");
+}
+
+TEST_CASE("Aborted batches are discarded", "[cmd]") {
+    Table t;
+    CmdInterpreter::set({0,0}, "1", t);
+
+    CmdInterpreter::begin(t);
+    CmdInterpreter::set({0,0}, "10", t);
+    CmdInterpreter::set({1,0}, "R[-1]C[0] + 1", t);
+    CmdInterpreter::abort(t);
+
+    REQUIRE(t.get({0,0}) == "1");
+    REQUIRE_FALSE(t.hasCell({1,0}));
+    REQUIRE_THROWS_AS(CmdInterpreter::commit(t), std::runtime_error);
+
+    // A new batch starts empty
+    CmdInterpreter::begin(t);
+    CmdInterpreter::set({0,0}, "3", t);
+    CmdInterpreter::commit(t);
+    REQUIRE(t.getCachedValue({0,0}) == 3.0);
+    REQUIRE_FALSE(t.hasCell({1,0}));
+}
+
+TEST_CASE("Unfinished batches end with their table", "[cmd]") {
+    {
+        Table t;
+        CmdInterpreter::begin(t);
+        CmdInterpreter::set({0,0}, "1", t);
+    }
+
+    // The batch of the destroyed table does not block or capture others
+    Table u;
+    CmdInterpreter::begin(u);
+    Table v;
+    CmdInterpreter::begin(v);
+    CmdInterpreter::set({0,0}, "2", u);
+    CmdInterpreter::set({0,0}, "3", v);
+    REQUIRE_FALSE(u.hasCell({0,0}));
+
+    CmdInterpreter::commit(u);
+    CmdInterpreter::commit(v);
+    REQUIRE(u.getCachedValue({0,0}) == 2.0);
+    REQUIRE(v.getCachedValue({0,0}) == 3.0);
+
+    // Neither does a table that failed in the middle of a batch
+    try {
+        Table w;
+        CmdInterpreter::begin(w);
+        throw std::runtime_error("failure between begin and commit");
+    } catch (const std::runtime_error&) {
+    }
+    Table x;
+    REQUIRE_NOTHROW(CmdInterpreter::begin(x));
+    CmdInterpreter::abort(x);
+}
@@ -0,0 +1,104 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/CoordinateMap.h"
+#include <map>
+#include <vector>
+
+TEST_CASE("Coordinate map inserts, finds and erases keys", "[map]") {
+    CoordinateMap<int> map(42);
+    REQUIRE(map.empty());
+    REQUIRE(map.find({1,2}) == nullptr);
+    REQUIRE_FALSE(map.erase({1,2}));
+
+    REQUIRE(map.tryEmplace({1,2}, 7).second);
+    REQUIRE_FALSE(map.tryEmplace({1,2}, 8).second);
+    REQUIRE(*map.find({1,2}) == 7);
+
+    map[{-3,5}] += 4;
+    REQUIRE(map[{-3,5}] == 4);
+    REQUIRE(map.size() == 2);
+
+    REQUIRE(map.erase({1,2}));
+    REQUIRE_FALSE(map.contains({1,2}));
+    REQUIRE(map.contains({-3,5}));
+    REQUIRE(map.size() == 1);
+}
+
+TEST_CASE("Coordinate map matches an ordered map under random edits", "[map]") {
+    CoordinateMap<int64_t> map(7);
+    std::map<Coordinates, int64_t> expected;
+
+    uint64_t state = 1;
+    for (int step = 0; step < 200000; ++step) {
+        const uint64_t r = Hash::splitmix64(state++);
+        const Coordinates key(static_cast<int64_t>(r % 300), static_cast<int64_t>((r >> 16) % 300));
+
+        if ((r >> 40) % 3 == 0) {
+            REQUIRE(map.erase(key) == (expected.erase(key) == 1));
+        } else {
+            map[key] = step;
+            expected[key] = step;
+        }
+    }
+
+    REQUIRE(map.size() == expected.size());
+    for (const auto& [key, value] : expected) {
+        REQUIRE(map.find(key) != nullptr);
+        REQUIRE(*map.find(key) == value);
+    }
+
+    size_t visited = 0;
+    map.forEach([&](const Coordinates& key, int64_t value) {
+        REQUIRE(expected.at(key) == value);
+        ++visited;
+    });
+    REQUIRE(visited == expected.size());
+}
+
+TEST_CASE("Coordinate map layout depends only on the seed", "[map]") {
+    auto layout = [](uint64_t seed) {
+        CoordinateMap<int> map(seed);
+        for (int64_t row = 0; row < 1000; ++row) {
+            map.tryEmplace({row, row % 7}, static_cast<int>(row));
+        }
+
+        std::vector<Coordinates> keys;
+        map.forEach([&](const Coordinates& key, int) {
+            keys.push_back(key);
+        });
+        return keys;
+    };
+
+    REQUIRE(layout(123) == layout(123));
+    REQUIRE(layout(123) != layout(456));
+}
+
+TEST_CASE("Coordinate map reports probe lengths", "[map]") {
+    CoordinateMap<int> map(1);
+    REQUIRE(map.probeStatistics().size == 0);
+    REQUIRE(map.probeStatistics().averageProbeLength == 0.0);
+
+    map.reserve(1000);
+    const size_t capacity = map.capacity();
+    REQUIRE(capacity * 7 >= 1000 * 8);
+
+    for (int64_t i = 0; i < 1000; ++i) {
+        map.tryEmplace({i, -i}, 0);
+    }
+    REQUIRE(map.capacity() == capacity);
+
+    const ProbeStatistics statistics = map.probeStatistics();
+    REQUIRE(statistics.size == 1000);
+    REQUIRE(statistics.capacity == capacity);
+    REQUIRE(statistics.loadFactor() <= 0.875);
+    REQUIRE(statistics.averageProbeLength >= 1.0);
+    REQUIRE(statistics.averageProbeLength < 3.0);
+    REQUIRE(statistics.maxProbeLength >= 1);
+
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(map.capacity() == capacity);
+    REQUIRE(map.probeStatistics().maxProbeLength == 0);
+}
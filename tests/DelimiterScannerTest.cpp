@@ -0,0 +1,76 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/DelimiterScanner.h"
+#include "SimdTestUtils.h"
+#include <string>
+#include <vector>
+
+TEST_CASE("Delimiter scanner finds every separator", "[scanner]") {
+    // Separators at block edges, runs of separators and a scalar tail
+    std::string text;
+    for (size_t i = 0; i < 203; ++i) {
+        if (i % 16 == 15 || i % 32 == 0 || (i > 100 && i < 110)) {
+            text += ';';
+        } else if (i % 7 == 3) {
+            text += '\n';
+        } else {
+            text += static_cast<char>('a' + i % 26);
+        }
+    }
+
+    forEachLevel([&] {
+        // Every start offset, so unaligned loads and short inputs are covered
+        for (size_t offset = 0; offset < 40; ++offset) {
+            const std::string part = text.substr(offset);
+            std::vector<uint32_t> expected;
+            for (size_t i = 0; i < part.size(); ++i) {
+                if (part[i] == ';' || part[i] == '\n') {
+                    expected.push_back(static_cast<uint32_t>(i));
+                }
+            }
+
+            std::vector<uint32_t> positions(part.size());
+            const size_t count = DelimiterScanner::find(part.data(), part.size(), positions.data());
+            positions.resize(count);
+            REQUIRE(positions == expected);
+        }
+    });
+}
+
+TEST_CASE("Delimiter scanner ignores other bytes", "[scanner]") {
+    // Bytes that differ from the separators in a single bit, and high bytes
+    std::string text(64, ':');
+    text[5] = '\x0b';
+    text[20] = static_cast<char>(0xbb);
+    text[33] = '\n';
+    text[63] = ';';
+
+    forEachLevel([&] {
+        std::vector<uint32_t> positions(text.size());
+        REQUIRE(DelimiterScanner::find(text.data(), text.size(), positions.data()) == 2);
+        REQUIRE(positions[0] == 33);
+        REQUIRE(positions[1] == 63);
+        REQUIRE(DelimiterScanner::find(text.data(), 0, positions.data()) == 0);
+        REQUIRE((DelimiterScanner::width() == 1 || DelimiterScanner::width() == 16 || DelimiterScanner::width() == 32));
+    });
+}
+
+TEST_CASE("Instruction set follows the selected level", "[scanner]") {
+    const SimdLevel original = Simd::level();
+    REQUIRE(Simd::supports(SimdLevel::Baseline));
+    REQUIRE(Simd::supports(Simd::detect()));
+
+    Simd::setLevel(SimdLevel::Baseline);
+    REQUIRE(Simd::level() == SimdLevel::Baseline);
+    REQUIRE(DelimiterScanner::width() <= 16);
+
+    if (Simd::supports(SimdLevel::AVX2)) {
+        Simd::setLevel(SimdLevel::AVX2);
+        REQUIRE(Simd::level() == SimdLevel::AVX2);
+    } else {
+        REQUIRE_THROWS(Simd::setLevel(SimdLevel::AVX2));
+    }
+    Simd::setLevel(original);
+}
@@ -0,0 +1,324 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/Evaluator.h"
+#include "../src/ExpressionParser.h"
+#include "../src/Table.h"
+#include <cmath>
+#include <string>
+
+TEST_CASE("Compiled program is reused across evaluations", "[evaluator]") {
+    Table t;
+    Program program = ExpressionParser::compile("R[0]C[-1] * 2 + 1");
+
+    t.set({0,0}, "1");
+    t.set({1,0}, "5");
+
+    REQUIRE(Evaluator::run(program, t, {0,1}) == 3.0);
+    REQUIRE(Evaluator::run(program, t, {1,1}) == 11.0);
+}
+
+TEST_CASE("Cell values are cached after evaluation", "[evaluator]") {
+    Table t;
+    t.set({0,0}, "0");
+    t.set({0,1}, "R0C0 + 1");
+    t.set({0,2}, "R0C0 + R0C1");
+
+    REQUIRE(Evaluator::getValue(t, {0,2}) == 1.0);
+    REQUIRE(t.isEvaluated({0,0}));
+    REQUIRE(t.isEvaluated({0,1}));
+    REQUIRE(Evaluator::getValue(t, {0,1}) == 1.0);
+}
+
+TEST_CASE("Only the selected branches are evaluated", "[evaluator]") {
+    Table t;
+    REQUIRE(ExpressionParser::evaluate("if(1, 5, 1/0)", t, {0,0}) == 5.0);
+    REQUIRE(ExpressionParser::evaluate("if(0, R9C9, 7)", t, {0,0}) == 7.0);
+    REQUIRE(ExpressionParser::evaluate("0 and 1/0", t, {0,0}) == 0.0);
+    REQUIRE(ExpressionParser::evaluate("1 or 1/0", t, {0,0}) == 1.0);
+}
+
+TEST_CASE("Evaluation errors", "[evaluator]") {
+    Table t;
+    t.set({0,0}, "R0C1");
+    t.set({0,1}, "R0C0");
+    t.set({1,0}, "1 +");
+    t.set({1,1}, "R5C5");
+
+    REQUIRE_THROWS_AS(Evaluator::getValue(t, {0,0}), std::runtime_error);
+    REQUIRE_THROWS_AS(Evaluator::getValue(t, {1,0}), std::runtime_error);
+    REQUIRE_THROWS_AS(Evaluator::getValue(t, {1,1}), std::runtime_error);
+    REQUIRE_FALSE(t.isBeingEvaluated({0,0}));
+}
+
+TEST_CASE("Recalculation only touches dirty cells", "[evaluator]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({0,1}, "R0C0 + 1");
+    t.set({0,2}, "R0C1 * 10");
+    t.set({1,0}, "100");
+    t.set({1,1}, "R1C0 + 1");
+
+    Evaluator::recalculate(t);
+    REQUIRE(t.getDirtyCells().empty());
+    REQUIRE(t.getCachedValue({0,2}) == 20.0);
+    REQUIRE(t.getCachedValue({1,1}) == 101.0);
+
+    t.set({0,0}, "2");
+    REQUIRE_FALSE(t.isEvaluated({0,0}));
+    REQUIRE_FALSE(t.isEvaluated({0,1}));
+    REQUIRE_FALSE(t.isEvaluated({0,2}));
+    REQUIRE(t.isEvaluated({1,0}));
+    REQUIRE(t.isEvaluated({1,1}));
+
+    Evaluator::recalculate(t);
+    REQUIRE(t.getCachedValue({0,2}) == 30.0);
+    REQUIRE(t.getCachedValue({1,1}) == 101.0);
+}
+
+TEST_CASE("Referencing a cell created later", "[evaluator]") {
+    Table t;
+    t.set({0,0}, "R5C5 + 1");
+    REQUIRE_THROWS_AS(Evaluator::recalculate(t), std::runtime_error);
+
+    t.set({5,5}, "41");
+    Evaluator::recalculate(t);
+    REQUIRE(t.getCachedValue({0,0}) == 42.0);
+}
+
+TEST_CASE("Long reference chains evaluate without recursion", "[evaluator]") {
+    const int64_t length = 100000;
+
+    Table t;
+    t.set({0,0}, "1");
+    for (int64_t row = 1; row < length; ++row) {
+        t.set({row,0}, "R[-1]C[0] + 1");
+    }
+
+    REQUIRE(Evaluator::getValue(t, {length - 1, 0}, EvaluationMode::Iterative) == static_cast<double>(length));
+    REQUIRE(t.isEvaluated({length / 2, 0}));
+}
+
+TEST_CASE("Recursive and iterative modes agree", "[evaluator]") {
+    auto build = [](Table& t) {
+        t.set({0,0}, "2");
+        t.set({0,1}, "R0C0 * 3");
+        t.set({1,0}, "if(R0C1 > 5, R0C0 + R0C1, R9C9)");
+        t.set({1,1}, "R1C0 % 4 + R0C1 / R0C0");
+    };
+
+    Table recursive;
+    Table iterative;
+    build(recursive);
+    build(iterative);
+
+    Evaluator::recalculate(recursive, EvaluationMode::Recursive);
+    Evaluator::recalculate(iterative, EvaluationMode::Iterative);
+
+    for (const Coordinates& c : recursive.getCells()) {
+        REQUIRE(recursive.getCachedValue(c) == iterative.getCachedValue(c));
+    }
+
+    // References behind a failing instruction are never evaluated, so
+    // both modes report the first error the program reaches
+    auto buildFailing = [](Table& t) {
+        t.set({0,5}, "R0C0 + 1/0 + R1C0");
+        t.set({0,6}, "R0C0 + R7C7 + R1C0");
+        t.set({0,7}, "R0C0 + avg(R5C5:R6C6) + R1C0");
+        t.set({0,0}, "2");
+        t.set({1,0}, "R9C9");
+    };
+
+    Table recursiveFailing;
+    Table iterativeFailing;
+    buildFailing(recursiveFailing);
+    buildFailing(iterativeFailing);
+
+    REQUIRE_THROWS_WITH(Evaluator::recalculate(recursiveFailing, EvaluationMode::Recursive), "Division by zero");
+    REQUIRE_THROWS_WITH(Evaluator::recalculate(iterativeFailing, EvaluationMode::Iterative), "Division by zero");
+    REQUIRE_FALSE(iterativeFailing.isEvaluated({1,0}));
+
+    for (EvaluationMode mode : {EvaluationMode::Recursive, EvaluationMode::Iterative}) {
+        Table t;
+        buildFailing(t);
+        REQUIRE_THROWS_WITH(Evaluator::getValue(t, {0,6}, mode), "Referenced cell does not exist");
+        REQUIRE_THROWS_WITH(Evaluator::getValue(t, {0,7}, mode), "Empty area");
+        REQUIRE_FALSE(t.isEvaluated({1,0}));
+    }
+}
+
+TEST_CASE("Iterative mode detects circular references", "[evaluator]") {
+    Table t;
+    t.set({0,0}, "R2C0");
+    t.set({1,0}, "R0C0");
+    t.set({2,0}, "R1C0 + 1");
+
+    REQUIRE_THROWS_AS(Evaluator::getValue(t, {0,0}, EvaluationMode::Iterative), std::runtime_error);
+    REQUIRE_FALSE(t.isBeingEvaluated({0,0}));
+    REQUIRE_FALSE(t.isBeingEvaluated({1,0}));
+    REQUIRE_FALSE(t.isBeingEvaluated({2,0}));
+}
+
+TEST_CASE("Iterative mode reads straight-line references before restarting", "[evaluator]") {
+    Table t;
+    std::string sum = "0";
+    for (int64_t col = 0; col < 300; ++col) {
+        t.set({0,col}, col == 0 ? "1" : "R[0]C[-1] % 7 + 1");
+        sum += " + R0C" + std::to_string(col);
+    }
+    t.set({1,0}, sum);
+
+    // R2C0 is an error, but only behind a branch that is not taken
+    t.set({2,0}, "1 / 0");
+    t.set({1,1}, "R0C0 + if(R0C1 > 100, R2C0, R0C2) * R0C3");
+
+    double expected = 0.0;
+    double value = 1.0;
+    for (int64_t col = 0; col < 300; ++col) {
+        expected += value;
+        value = std::fmod(value, 7.0) + 1.0;
+    }
+    REQUIRE(Evaluator::getValue(t, {1,0}, EvaluationMode::Iterative) == expected);
+    REQUIRE(Evaluator::getValue(t, {1,1}, EvaluationMode::Iterative) == 1.0 + 3.0 * 4.0);
+    REQUIRE_FALSE(t.isEvaluated({2,0}));
+
+    // A later reference to the cell itself is still reported as circular
+    t.set({3,0}, "R1C0 + R4C0 + R3C0");
+    t.set({4,0}, "5");
+    REQUIRE_THROWS_AS(Evaluator::getValue(t, {3,0}, EvaluationMode::Iterative), std::runtime_error);
+    REQUIRE_FALSE(t.isBeingEvaluated({3,0}));
+}
+
+TEST_CASE("Parallel recalculation matches the serial path", "[evaluator]") {
+    auto build = [](Table& t) {
+        for (int64_t col = 0; col < 20; ++col) {
+            t.set({0,col}, std::to_string(col + 1));
+        }
+        for (int64_t row = 1; row < 300; ++row) {
+            for (int64_t col = 0; col < 20; ++col) {
+                if (col == 0) {
+                    t.set({row,col}, "R[-1]C[0] / 3 + R[-1]C[19]");
+                } else if (col % 3 == 0) {
+                    t.set({row,col}, "if(R[-1]C[-1] > R[-1]C[0], R[-1]C[-1] - 1, R0C0 * 7 % 5)");
+                } else {
+                    t.set({row,col}, "R[-1]C[0] * 3 + R[0]C[-1] / 7");
+                }
+            }
+        }
+        // A reference cycle through a branch that is never taken
+        t.set({400,0}, "if(1, 5, R400C1)");
+        t.set({400,1}, "R400C0 + 1");
+    };
+
+    Table serial;
+    Table parallel;
+    build(serial);
+    build(parallel);
+
+    Evaluator::recalculate(serial);
+    Evaluator::recalculate(parallel, EvaluationMode::Iterative, 4);
+
+    REQUIRE(parallel.getDirtyCells().empty());
+    for (const Coordinates& c : serial.getCells()) {
+        REQUIRE(parallel.isEvaluated(c));
+        REQUIRE(serial.getCachedValue(c) == parallel.getCachedValue(c));
+    }
+
+    serial.set({0,5}, "100");
+    parallel.set({0,5}, "100");
+    Evaluator::recalculate(serial);
+    Evaluator::recalculate(parallel, EvaluationMode::Iterative, 4);
+
+    for (const Coordinates& c : serial.getCells()) {
+        REQUIRE(serial.getCachedValue(c) == parallel.getCachedValue(c));
+    }
+}
+
+TEST_CASE("Parallel recalculation reports errors", "[evaluator]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({0,1}, "R0C0 / 0");
+    t.set({1,0}, "R1C1");
+    t.set({1,1}, "R1C0");
+
+    REQUIRE_THROWS_AS(Evaluator::recalculate(t, EvaluationMode::Iterative, 4), std::runtime_error);
+    REQUIRE_FALSE(t.getDirtyCells().empty());
+
+    t.set({0,1}, "R0C0 / 2");
+    t.set({1,1}, "3");
+    Evaluator::recalculate(t, EvaluationMode::Iterative, 4);
+    REQUIRE(t.getCachedValue({0,1}) == 0.5);
+    REQUIRE(t.getCachedValue({1,0}) == 3.0);
+}
+
+TEST_CASE("Aggregated areas take part in recalculation", "[evaluator]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({1,0}, "R[-1]C[0] + 1");
+    t.set({2,0}, "R[-1]C[0] + 1");
+    t.set({0,1}, "sum(R0C0:R99C0)");
+    t.set({1,1}, "R0C1 * 2");
+
+    Evaluator::recalculate(t);
+    REQUIRE(t.getCachedValue({0,1}) == 6.0);
+    REQUIRE(t.getCachedValue({1,1}) == 12.0);
+
+    // A cell created inside the area invalidates the aggregate
+    t.set({50,0}, "10");
+    REQUIRE_FALSE(t.isEvaluated({0,1}));
+    REQUIRE_FALSE(t.isEvaluated({1,1}));
+
+    Evaluator::recalculate(t, EvaluationMode::Iterative, 4);
+    REQUIRE(t.getCachedValue({0,1}) == 16.0);
+    REQUIRE(t.getCachedValue({1,1}) == 32.0);
+
+    t.set({0,2}, "sum(R0C0:R0C2)");
+    REQUIRE_THROWS_AS(Evaluator::recalculate(t), std::runtime_error);
+}
+
+TEST_CASE("Column runs are evaluated as batches", "[evaluator]") {
+    auto build = [](Table& t) {
+        for (int64_t row = 0; row < 600; ++row) {
+            t.set({row,0}, std::to_string(row % 17 + 1));
+            t.set({row,1}, std::to_string(row % 5));
+            t.set({row,2}, "R[0]C[-2] * 3 - -R[0]C[-1] / 4 + R[0]C[-2] % 3");
+            t.set({row,3}, "(R[0]C[-1] > 10) + (R[0]C[-2] == 2) + not R[0]C[-2] + (R[0]C[-3] != 4)");
+            // Reads its own column: evaluated one cell at a time
+            t.set({row,4}, row == 0 ? "1" : "R[-1]C[0] + R[0]C[-2]");
+        }
+    };
+
+    Table batched;
+    Table single;
+    build(batched);
+    build(single);
+
+    Evaluator::recalculate(batched);
+    for (const Coordinates& c : single.getCells()) {
+        Evaluator::getValue(single, c);
+    }
+
+    for (const Coordinates& c : single.getCells()) {
+        REQUIRE(batched.isEvaluated(c));
+        REQUIRE(batched.getCachedValue(c) == single.getCachedValue(c));
+    }
+}
+
+TEST_CASE("Column runs report errors of single cells", "[evaluator]") {
+    Table t;
+    for (int64_t row = 0; row < 50; ++row) {
+        t.set({row,0}, std::to_string(row + 1));
+        t.set({row,1}, "10 / (R[0]C[-1] - 30)");
+    }
+
+    REQUIRE_THROWS_WITH(Evaluator::recalculate(t), "Division by zero");
+    REQUIRE(t.isEvaluated({28,1}));
+    REQUIRE_FALSE(t.isEvaluated({29,1}));
+    REQUIRE_FALSE(t.isBeingEvaluated({29,1}));
+
+    t.set({29,0}, "0");
+    Evaluator::recalculate(t);
+    REQUIRE(t.getCachedValue({29,1}) == -10.0 / 30.0);
+    REQUIRE(t.getCachedValue({49,1}) == 0.5);
+}
@@ -38,9 +38,8 @@ TEST_CASE("Cell references", "[parser]") {
     t.set({0,0}, "10");
     t.set({0,1}, "20");
 
-    auto cells = t.getCells();
-    for (auto& [coords, cell] : cells) {
-        cell.cachedValue = std::stod(cell.expression);
+    for (const Coordinates& c : t.getCells()) {
+        t.setCachedValue(std::stod(t.get(c)), c);
     }
 
     double val = ExpressionParser::evaluate("R0C0 + R0C1", t, {0,0});
@@ -48,4 +47,31 @@ TEST_CASE("Cell references", "[parser]") {
 
     val = ExpressionParser::evaluate("R[0]C[1] - R[0]C[0]", t, {0,0});
     REQUIRE(val == 10.0);
-}
\ No newline at end of file
+}
+TEST_CASE("Malformed expressions are rejected at compile time", "[parser]") {
+    REQUIRE_THROWS_AS(ExpressionParser::compile("1 +"), std::runtime_error);
+    REQUIRE_THROWS_AS(ExpressionParser::compile("(1"), std::runtime_error);
+    REQUIRE_THROWS_AS(ExpressionParser::compile("if(1, 2)"), std::runtime_error);
+    REQUIRE_THROWS_AS(ExpressionParser::compile("1 2"), std::runtime_error);
+    REQUIRE_THROWS_AS(ExpressionParser::compile("sum(R0C0)"), std::runtime_error);
+    REQUIRE_THROWS_AS(ExpressionParser::compile("R[]C0"), std::runtime_error);
+    REQUIRE_THROWS_AS(ExpressionParser::compile("R99999999999999999999C0"), std::runtime_error);
+    REQUIRE_THROWS_AS(ExpressionParser::compile("sum(1:2)"), std::runtime_error);
+}
+
+TEST_CASE("Aggregation functions", "[parser]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({1,0}, "2");
+    t.set({2,0}, "R[-1]C[0] * 3");
+    t.set({0,1}, "4");
+
+    REQUIRE(ExpressionParser::evaluate("sum(R0C0:R2C1)", t, {5,5}) == 13.0);
+    REQUIRE(ExpressionParser::evaluate("count(R0C0:R99999C9)", t, {5,5}) == 4.0);
+    REQUIRE(ExpressionParser::evaluate("min(R0C0:R2C1)", t, {5,5}) == 1.0);
+    REQUIRE(ExpressionParser::evaluate("max(R0C0:R2C1)", t, {5,5}) == 6.0);
+    REQUIRE(ExpressionParser::evaluate("avg(R0C0:R2C0)", t, {5,5}) == 3.0);
+    REQUIRE(ExpressionParser::evaluate("sum(R[-5]C[-5]:R[-4]C[-5]) + 1", t, {5,5}) == 4.0);
+    REQUIRE(ExpressionParser::evaluate("sum(R10C10:R20C20)", t, {5,5}) == 0.0);
+    REQUIRE_THROWS_AS(ExpressionParser::evaluate("avg(R10C10:R20C20)", t, {5,5}), std::runtime_error);
+}
@@ -0,0 +1,76 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/FormulaPool.h"
+#include <string>
+#include <vector>
+
+TEST_CASE("Formula pool shares equal expressions", "[formula]") {
+    FormulaPool pool;
+
+    FormulaPool::FormulaId a = pool.acquire("R[-1]C[0]*2");
+    FormulaPool::FormulaId b = pool.acquire("R[-1]C[0]*2");
+    FormulaPool::FormulaId c = pool.acquire("R[-1]C[0]*3");
+
+    REQUIRE(a == b);
+    REQUIRE(a != c);
+    REQUIRE(pool.size() == 2);
+    REQUIRE(pool.uses(a) == 2);
+    REQUIRE(pool.expression(c) == "R[-1]C[0]*3");
+    REQUIRE(&pool.program(a) == &pool.program(b));
+    REQUIRE(pool.program(a).code.size() == 3);
+}
+
+TEST_CASE("Formula pool drops unused formulas", "[formula]") {
+    FormulaPool pool;
+
+    FormulaPool::FormulaId a = pool.acquire("1 + 2");
+    pool.acquire("1 + 2");
+    pool.release(a);
+    REQUIRE(pool.size() == 1);
+
+    pool.release(a);
+    REQUIRE(pool.size() == 0);
+
+    // The id of a dropped formula is reused
+    FormulaPool::FormulaId b = pool.acquire("3 * 4");
+    REQUIRE(b == a);
+    REQUIRE(pool.expression(b) == "3 * 4");
+    REQUIRE(pool.acquire("1 + 2") != b);
+}
+
+TEST_CASE("Formula pool keeps compilation errors", "[formula]") {
+    FormulaPool pool;
+
+    FormulaPool::FormulaId id = pool.acquire("1 +");
+    REQUIRE_FALSE(pool.program(id).error.empty());
+    REQUIRE(pool.acquire("1 +") == id);
+}
+
+TEST_CASE("Formula pool compacts dropped texts", "[formula]") {
+    FormulaPool pool;
+    std::vector<FormulaPool::FormulaId> ids;
+
+    for (int i = 0; i < 20000; ++i) {
+        ids.push_back(pool.acquire("R[-1]C[0] + " + std::to_string(i)));
+    }
+    const size_t filled = pool.textBytes();
+
+    // Dropping most formulas leaves their texts in the arena until they outweigh the live ones
+    for (int i = 0; i < 19000; ++i) {
+        pool.release(ids[i]);
+    }
+    REQUIRE(pool.textBytes() == filled);
+
+    FormulaPool::FormulaId added = pool.acquire("1 + 2");
+    REQUIRE(pool.textBytes() < filled / 10);
+    REQUIRE(pool.expression(added) == "1 + 2");
+    REQUIRE(pool.expression(ids[19500]) == "R[-1]C[0] + 19500");
+    REQUIRE(pool.acquire("R[-1]C[0] + 19999") == ids[19999]);
+    REQUIRE(pool.size() == 1001);
+
+    pool.clear();
+    REQUIRE(pool.size() == 0);
+    REQUIRE(pool.textBytes() == 0);
+}
@@ -0,0 +1,36 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/MappedFile.h"
+#include <cstdio>
+#include <fstream>
+
+TEST_CASE("Mapped file exposes the file contents", "[file]") {
+    std::string filename = "test_mapped.csv";
+    {
+        std::ofstream out(filename, std::ios::binary);
+        out << "1;2\n3;4";
+    }
+
+    {
+        MappedFile file(filename);
+        REQUIRE(file.size() == 7);
+        REQUIRE(file.view() == "1;2\n3;4");
+    }
+
+    {
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    }
+    {
+        MappedFile file(filename);
+        REQUIRE(file.size() == 0);
+        REQUIRE(file.view().empty());
+    }
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Mapped file reports missing files", "[file]") {
+    REQUIRE_THROWS_AS(MappedFile("missing_file.csv"), std::runtime_error);
+}
@@ -0,0 +1,73 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/OutputBuffer.h"
+#include <algorithm>
+#include <sstream>
+#include <streambuf>
+
+TEST_CASE("Output buffer writes appended text", "[output]") {
+    std::ostringstream out;
+    {
+        OutputBuffer buffer(out, 8);
+        buffer.append("ab");
+        REQUIRE(out.str().empty());
+
+        buffer.append(';', 3);
+        buffer.appendInteger(-1234);
+        // The capacity was reached, so the text is written
+        REQUIRE(out.str() == "ab;;;-1234");
+
+        buffer.appendInteger(0);
+        buffer.append('\n');
+    }
+    REQUIRE(out.str() == "ab;;;-12340\n");
+}
+
+TEST_CASE("Output buffer flushes on request", "[output]") {
+    std::ostringstream out;
+    OutputBuffer buffer(out);
+    buffer.append("R0C0 + 1");
+    buffer.flush();
+    REQUIRE(out.str() == "R0C0 + 1");
+}
+
+TEST_CASE("Output buffer writes long repetitions in chunks", "[output]") {
+    // Counts the written characters and the largest single write
+    struct CountingBuffer : std::streambuf {
+        size_t written = 0;
+        size_t largestWrite = 0;
+        bool onlySeparators = true;
+
+        std::streamsize xsputn(const char* text, std::streamsize n) override {
+            for (std::streamsize i = 0; i < n; ++i) {
+                onlySeparators = onlySeparators && text[i] == ';';
+            }
+            written += static_cast<size_t>(n);
+            largestWrite = std::max(largestWrite, static_cast<size_t>(n));
+            return n;
+        }
+    };
+
+    CountingBuffer counter;
+    std::ostream out(&counter);
+    {
+        OutputBuffer buffer(out, 4096);
+        buffer.append(';', 5);
+        buffer.append(';', 10000000);
+        buffer.flush();
+        REQUIRE(counter.written == 10000005);
+    }
+    REQUIRE(counter.largestWrite <= 4096);
+    REQUIRE(counter.onlySeparators);
+
+    std::ostringstream small;
+    {
+        OutputBuffer buffer(small, 4);
+        buffer.append("ab");
+        buffer.append('\n', 7);
+        buffer.append("c");
+    }
+    REQUIRE(small.str() == "ab\n\n\n\n\n\n\nc");
+}
@@ -0,0 +1,197 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/CmdInterpreter.h"
+#include "../src/Evaluator.h"
+#include "../src/Profiler.h"
+#include "../src/Table.h"
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    void spin(double seconds) {
+        const auto start = Profiler::Clock::now();
+        while (std::chrono::duration<double>(Profiler::Clock::now() - start).count() < seconds) {
+        }
+    }
+}
+
+TEST_CASE("Profiler separates self time of nested evaluations", "[profiler]") {
+    Profiler::reset();
+    {
+        Profiler::Evaluation outer(Coordinates(0,0));
+        spin(0.002);
+        {
+            Profiler::Evaluation inner(Coordinates(1,0), 3);
+            spin(0.01);
+        }
+        // Computed while the reader runs: misses
+        Profiler::lookup({1,0});
+        Profiler::lookup({1,0});
+    }
+    // Reads outside of evaluations are not counted
+    Profiler::lookup({1,0});
+
+    const Profiler::CellProfile outer = Profiler::get({0,0});
+    const Profiler::CellProfile inner = Profiler::get({1,0});
+
+    REQUIRE(outer.evaluations == 1);
+    REQUIRE(inner.evaluations == 1);
+    REQUIRE(outer.totalSeconds >= inner.totalSeconds);
+    REQUIRE(outer.selfSeconds < outer.totalSeconds - 0.009);
+    REQUIRE(inner.selfSeconds == inner.totalSeconds);
+    REQUIRE(outer.maxDepth == 1);
+    REQUIRE(inner.maxDepth == 5);
+    REQUIRE(inner.hits == 0);
+    REQUIRE(inner.misses == 2);
+    REQUIRE(Profiler::get({5,5}).evaluations == 0);
+
+    // Batches share their time among the cells of the run
+    {
+        Profiler::Batch batch(2, 10, 4);
+        spin(0.004);
+    }
+    REQUIRE(Profiler::get({13,2}).evaluations == 1);
+    REQUIRE(Profiler::get({13,2}).totalSeconds >= 0.001);
+    REQUIRE(Profiler::get({14,2}).evaluations == 0);
+
+    std::ostringstream out;
+    Profiler::report(out, 1);
+    REQUIRE(out.str().find("6 cells profiled") != std::string::npos);
+    REQUIRE(out.str().find("R1C0 ") != std::string::npos);
+    REQUIRE(out.str().find("R0C0 ") == std::string::npos);
+
+    Profiler::reset();
+    REQUIRE(Profiler::get({1,0}).evaluations == 0);
+}
+
+TEST_CASE("Profile command reports a full recalculation", "[profiler]") {
+    Table t;
+    t.set({0,0}, "1");
+    for (int64_t row = 1; row < 20; ++row) {
+        t.set({row,0}, "R[-1]C[0] + 1");
+    }
+    t.set({0,1}, "sum(R0C0:R19C0)");
+
+    if (!Profiler::ENABLED) {
+        REQUIRE_THROWS_AS(CmdInterpreter::profile(t), std::runtime_error);
+        return;
+    }
+
+    std::ostringstream captured;
+    std::streambuf* original = std::cout.rdbuf(captured.rdbuf());
+    CmdInterpreter::profile(t, 3);
+    std::cout.rdbuf(original);
+
+    REQUIRE(Profiler::getRecalculations().first == 1);
+    REQUIRE(captured.str().find("Recalculations: 1,") != std::string::npos);
+    REQUIRE(t.getCachedValue({0,1}) == 210.0);
+
+    for (int64_t row = 0; row < 20; ++row) {
+        REQUIRE(Profiler::get({row,0}).evaluations == 1);
+    }
+    REQUIRE(Profiler::get({0,1}).evaluations == 1);
+    REQUIRE(Profiler::get({19,0}).hits == 1);
+}
+
+TEST_CASE("Profiler counts suspended evaluations once", "[profiler]") {
+    Profiler::reset();
+    {
+        bool completed = false;
+        Profiler::Evaluation attempt(Coordinates(0,0), 0, &completed);
+        Profiler::lookup({1,0});
+    }
+    {
+        Profiler::Evaluation read(Coordinates(1,0));
+    }
+    {
+        bool completed = false;
+        Profiler::Evaluation restart(Coordinates(0,0), 0, &completed);
+        Profiler::lookup({1,0});
+        completed = true;
+    }
+
+    // The read of the suspended attempt is dropped, the restart's read waited
+    REQUIRE(Profiler::get({0,0}).evaluations == 1);
+    REQUIRE(Profiler::get({1,0}).evaluations == 1);
+    REQUIRE(Profiler::get({1,0}).hits == 0);
+    REQUIRE(Profiler::get({1,0}).misses == 1);
+
+    // Computed before the reader started: a hit
+    {
+        Profiler::Evaluation later(Coordinates(3,0));
+        Profiler::lookup({1,0});
+    }
+    REQUIRE(Profiler::get({1,0}).hits == 1);
+
+    // Failed evaluations compute nothing
+    REQUIRE_THROWS(([] {
+        Profiler::Evaluation failing(Coordinates(2,0));
+        throw std::runtime_error("failure");
+    }()));
+    REQUIRE(Profiler::get({2,0}).evaluations == 0);
+    Profiler::reset();
+}
+
+TEST_CASE("Profiler counts match an iterative recalculation", "[profiler]") {
+    if (!Profiler::ENABLED) {
+        return;
+    }
+
+    // Set in reverse, so R2C0 is started first and suspends on R1C0, which suspends on R0C0
+    Table chain;
+    chain.set({2,0}, "R1C0 + 1");
+    chain.set({1,0}, "R0C0 + 1");
+    chain.set({0,0}, "1");
+    chain.set({0,1}, "sum(R0C0:R2C0) + R2C0");
+
+    Profiler::reset();
+    Evaluator::recalculate(chain, EvaluationMode::Iterative);
+    REQUIRE(chain.getCachedValue({0,1}) == 9.0);
+
+    for (int64_t row = 0; row < 3; ++row) {
+        REQUIRE(Profiler::get({row,0}).evaluations == 1);
+    }
+    REQUIRE(Profiler::get({0,1}).evaluations == 1);
+
+    // Read once by the next cell of the chain (waiting for it) and once by the sum
+    REQUIRE(Profiler::get({0,0}).misses == 1);
+    REQUIRE(Profiler::get({0,0}).hits == 1);
+    REQUIRE(Profiler::get({1,0}).misses == 1);
+    REQUIRE(Profiler::get({1,0}).hits == 1);
+    REQUIRE(Profiler::get({2,0}).misses == 0);
+    REQUIRE(Profiler::get({2,0}).hits == 2);
+    REQUIRE(Profiler::get({0,1}).hits + Profiler::get({0,1}).misses == 0);
+
+    // An aggregate that suspends on its cells waits for each of them once
+    Table aggregate;
+    aggregate.set({0,1}, "sum(R0C0:R2C0)");
+    aggregate.set({0,0}, "1");
+    aggregate.set({1,0}, "2");
+    aggregate.set({2,0}, "R1C0 * 2");
+
+    Profiler::reset();
+    Evaluator::recalculate(aggregate, EvaluationMode::Iterative);
+    REQUIRE(aggregate.getCachedValue({0,1}) == 7.0);
+    REQUIRE(Profiler::get({0,1}).evaluations == 1);
+    for (int64_t row = 0; row < 3; ++row) {
+        REQUIRE(Profiler::get({row,0}).evaluations == 1);
+        REQUIRE(Profiler::get({row,0}).misses == 1);
+    }
+    REQUIRE(Profiler::get({1,0}).hits == 1);
+    REQUIRE(Profiler::get({0,0}).hits == 0);
+
+    // The recursive mode counts the same evaluations
+    chain.set({0,0}, "2");
+    Evaluator::recalculate(chain, EvaluationMode::Recursive);
+    Profiler::reset();
+    chain.set({0,0}, "3");
+    Evaluator::recalculate(chain, EvaluationMode::Recursive);
+    for (int64_t row = 0; row < 3; ++row) {
+        REQUIRE(Profiler::get({row,0}).evaluations == 1);
+    }
+    REQUIRE(Profiler::get({0,1}).evaluations == 1);
+    Profiler::reset();
+}
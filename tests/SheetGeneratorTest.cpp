@@ -0,0 +1,105 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/CmdInterpreter.h"
+#include "../src/Evaluator.h"
+#include "../src/SheetGenerator.h"
+#include "../src/Table.h"
+#include <cstdio>
+#include <sstream>
+
+namespace {
+    std::string generate(const SheetGenerator::Options& options) {
+        std::ostringstream out;
+        SheetGenerator::write(out, options);
+        return out.str();
+    }
+}
+
+TEST_CASE("Generated sheets depend only on the options", "[generator]") {
+    SheetGenerator::Options options;
+    options.rows = 200;
+    options.density = 0.7;
+    options.shape = SheetGenerator::Shape::RandomDag;
+    options.seed = 42;
+
+    const std::string first = generate(options);
+    REQUIRE(first == generate(options));
+
+    options.seed = 43;
+    REQUIRE(first != generate(options));
+}
+
+TEST_CASE("Generated sheets have the requested size and density", "[generator]") {
+    SheetGenerator::Options options;
+    options.rows = 100;
+    options.cols = 20;
+
+    std::string filename = "test_generated.csv";
+    SheetGenerator::save(filename, options);
+    Table full;
+    CmdInterpreter::load(filename, full);
+    REQUIRE(full.getCells().size() == 2000);
+    REQUIRE(full.findTableBounds() == std::pair<int64_t, int64_t>(99, 19));
+
+    options.density = 0.25;
+    SheetGenerator::save(filename, options);
+    Table sparse;
+    CmdInterpreter::load(filename, sparse);
+    REQUIRE(sparse.getCells().size() > 400);
+    REQUIRE(sparse.getCells().size() < 600);
+
+    options.density = 0;
+    REQUIRE(generate(options) == std::string(100, '\n'));
+
+    options.density = 2;
+    REQUIRE_THROWS_AS(generate(options), std::runtime_error);
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Every dependency shape evaluates without errors", "[generator]") {
+    SheetGenerator::Options options;
+    options.rows = 300;
+    options.cols = 8;
+    options.density = 0.9;
+    options.formulaRatio = 0.8;
+
+    std::string filename = "test_generated.csv";
+    for (const char* shape : {"chain", "tree", "diamond", "dag", "if"}) {
+        for (bool relative : {true, false}) {
+            options.shape = SheetGenerator::parseShape(shape);
+            options.relativeReferences = relative;
+
+            const std::string text = generate(options);
+            REQUIRE((text.find('[') != std::string::npos) == relative);
+
+            SheetGenerator::save(filename, options);
+            Table t;
+            CmdInterpreter::load(filename, t);
+            REQUIRE_NOTHROW(Evaluator::recalculate(t));
+            REQUIRE(t.getDirtyCells().empty());
+        }
+    }
+
+    REQUIRE_THROWS_AS(SheetGenerator::parseShape("star"), std::runtime_error);
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Chains count up from their first cell", "[generator]") {
+    SheetGenerator::Options options;
+    options.rows = 50;
+    options.cols = 4;
+    options.formulaRatio = 1;
+
+    std::string filename = "test_generated.csv";
+    SheetGenerator::save(filename, options);
+
+    Table t;
+    CmdInterpreter::load(filename, t);
+    Evaluator::recalculate(t);
+    REQUIRE(t.getCachedValue({49,3}) == t.getCachedValue({0,0}) + 199);
+
+    std::remove(filename.c_str());
+}
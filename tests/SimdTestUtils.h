@@ -0,0 +1,30 @@
+//
+// Created by Petya Licheva on 10/18/2026.
+//
+
+#ifndef SIMD_TEST_UTILS_H
+#define SIMD_TEST_UTILS_H
+
+#include "../src/Simd.h"
+
+/**
+ * @brief Runs a check once for every instruction set the processor supports.
+ *
+ * The dispatch level is restored afterwards, so tests that compare the
+ * vector paths with the baseline do not affect each other.
+ *
+ * @param check Function that runs the assertions at the current level
+ */
+template <typename Check>
+void forEachLevel(Check check) {
+    const SimdLevel original = Simd::level();
+    for (SimdLevel level : {SimdLevel::Baseline, SimdLevel::AVX2}) {
+        if (Simd::supports(level)) {
+            Simd::setLevel(level);
+            check();
+        }
+    }
+    Simd::setLevel(original);
+}
+
+#endif // SIMD_TEST_UTILS_H
@@ -0,0 +1,132 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/Evaluator.h"
+#include "../src/Snapshot.h"
+#include "../src/Table.h"
+#include <cstdio>
+#include <fstream>
+
+TEST_CASE("Snapshot keeps values without recalculation", "[snapshot]") {
+    Table t;
+    t.set({0,0}, "2");
+    t.set({1,0}, "R[-1]C[0] * 3");
+    t.set({2,0}, "R[-1]C[0] * 3");
+    t.set({0,1}, "if(R0C0 > 1 and not 0, sum(R0C0:R2C0), -1)");
+    t.set({0,2}, "1 +");
+    t.set({5,5}, "R0C0 or R9C9");
+    Evaluator::getValue(t, {0,1});
+
+    std::string filename = "test_snapshot.bin";
+    Snapshot::save(filename, t);
+
+    Table t2;
+    t2.set({7,7}, "1");
+    Snapshot::load(filename, t2);
+
+    REQUIRE(t2.getCells().size() == 6);
+    REQUIRE_FALSE(t2.hasCell({7,7}));
+    REQUIRE(t2.get({0,1}) == "if(R0C0 > 1 and not 0, sum(R0C0:R2C0), -1)");
+    REQUIRE(t2.getCells().getFormulas().size() == 5);
+
+    // Evaluated cells are served from the snapshot, the others are dirty
+    REQUIRE(t2.isEvaluated({0,1}));
+    REQUIRE(t2.getCachedValue({0,1}) == 26.0);
+    REQUIRE(t2.getCachedValue({2,0}) == 18.0);
+    REQUIRE_FALSE(t2.isEvaluated({0,2}));
+    REQUIRE(t2.getDirtyCells().size() == 2);
+    REQUIRE(t2.getFocusedCoords() == Coordinates(5,5));
+
+    // Restored programs run like compiled ones, including compile errors
+    REQUIRE(Evaluator::getValue(t2, {5,5}) == 1.0);
+    REQUIRE_THROWS_AS(Evaluator::getValue(t2, {0,2}), std::runtime_error);
+
+    // The dependency graph is built on the first edit
+    t2.set({0,0}, "1");
+    REQUIRE_FALSE(t2.isEvaluated({2,0}));
+    REQUIRE_FALSE(t2.isEvaluated({0,1}));
+    REQUIRE(t2.getDependents({1,0}) == std::vector<Coordinates>{{2,0}});
+    t2.set({0,2}, "3");
+    Evaluator::recalculate(t2);
+    REQUIRE(t2.getCachedValue({0,1}) == -1.0);
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Snapshot files are byte-for-byte reproducible", "[snapshot]") {
+    Table t;
+    for (int64_t row = 0; row < 100; ++row) {
+        t.set({row,0}, std::to_string(row));
+        t.set({row,1}, "R[0]C[-1] * 2");
+    }
+    t.set({3,1}, "7");
+    Evaluator::recalculate(t);
+
+    std::string first = "test_snapshot_a.bin";
+    std::string second = "test_snapshot_b.bin";
+    Snapshot::save(first, t);
+
+    Table t2;
+    Snapshot::load(first, t2);
+    Snapshot::save(second, t2);
+
+    auto read = [](const std::string& name) {
+        std::ifstream in(name, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+    REQUIRE(read(first) == read(second));
+
+    std::remove(first.c_str());
+    std::remove(second.c_str());
+}
+
+TEST_CASE("Invalid snapshots are rejected", "[snapshot]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({0,1}, "R0C0 + 1");
+
+    std::string filename = "test_snapshot_bad.bin";
+    Snapshot::save(filename, t);
+
+    std::string bytes;
+    {
+        std::ifstream in(filename, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto write = [&](const std::string& contents) {
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        out << contents;
+    };
+
+    Table target;
+    target.set({9,9}, "5");
+
+    write("1;2\n3;4\n");
+    REQUIRE_THROWS_WITH(Snapshot::load(filename, target), "Not a table snapshot");
+
+    std::string otherVersion = bytes;
+    otherVersion[8] = static_cast<char>(Snapshot::VERSION + 1);
+    write(otherVersion);
+    REQUIRE_THROWS_WITH(Snapshot::load(filename, target), "Unsupported snapshot version");
+
+    write(bytes.substr(0, bytes.size() - 20));
+    REQUIRE_THROWS_WITH(Snapshot::load(filename, target), "Corrupt snapshot");
+
+    // A jump past the end of its program
+    std::string badJump = bytes;
+    const size_t formulas = 64;
+    const size_t code = formulas + 2 * 40;
+    badJump[code + 48] = static_cast<char>(OpCode::Jump);
+    badJump[code + 40] = 100;
+    write(badJump);
+    REQUIRE_THROWS_WITH(Snapshot::load(filename, target), "Corrupt snapshot");
+
+    REQUIRE_THROWS_AS(Snapshot::load("missing_snapshot.bin", target), std::runtime_error);
+
+    // The table is untouched by rejected files
+    REQUIRE(target.getCells().size() == 1);
+    REQUIRE(target.get({9,9}) == "5");
+
+    std::remove(filename.c_str());
+}
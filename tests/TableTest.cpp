@@ -3,6 +3,11 @@
 //
 #include <catch2/catch_test_macros.hpp>
 #include "../src/Table.h"
+#include "../src/Evaluator.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 TEST_CASE("Table basic set and get", "[table]") {
     Table t;
@@ -40,9 +45,250 @@ TEST_CASE("Table aggregation functions", "[table]") {
         }
     }
 
-    REQUIRE(t.sum({0,0}, {1,1}) == 5.0);   // sum only uses two cells in your current impl
-    REQUIRE(t.count({0,0}, {1,1}) == 4);   // count only checks two cells
+    REQUIRE(t.sum({0,0}, {1,1}) == 10.0);
+    REQUIRE(t.count({0,0}, {1,1}) == 4);
     REQUIRE(t.min({0,0}, {1,1}) == 1.0);
     REQUIRE(t.max({0,0}, {1,1}) == 4.0);
     REQUIRE(t.avg({0,0}, {1,1}) == 2.5);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Table aggregation over sparse areas", "[table]") {
+    Table t;
+
+    t.set({0,0}, "1");
+    t.set({50000,3}, "2");
+    t.set({99999,9}, "3");
+    t.set({100000,0}, "100");
+    for (const Coordinates& c : {Coordinates(0,0), Coordinates(50000,3), Coordinates(99999,9), Coordinates(100000,0)}) {
+        t.setCachedValue(std::stod(t.get(c)), c);
+    }
+
+    REQUIRE(t.count({0,0}, {99999,9}) == 3);
+    REQUIRE(t.sum({99999,9}, {0,0}) == 6.0);
+    REQUIRE(t.count({1,1}, {2,2}) == 0);
+    REQUIRE(t.sum({1,1}, {2,2}) == 0.0);
+    REQUIRE_THROWS_AS(t.min({1,1}, {2,2}), std::runtime_error);
+}
+TEST_CASE("Table aggregation matches the expression language", "[table]") {
+    Table t;
+
+    t.set({0,0}, "1");
+    t.set({0,1}, "3");
+    t.set({1,0}, "R0C0 + 2");
+    t.set({1,1}, "R1C0 * 2");
+
+    // Dirty cells are evaluated rather than read as stale cached values
+    REQUIRE(t.sum({0,0}, {1,1}) == 13.0);
+    REQUIRE(t.max({0,0}, {1,1}) == 6.0);
+    REQUIRE(t.isEvaluated({1,1}));
+
+    t.set({5,5}, "count(R0C0:R1C1)");
+    t.set({5,6}, "avg(R0C0:R1C1)");
+    t.set({5,7}, "min(R0C0:R1C1)");
+    Evaluator::recalculate(t);
+    REQUIRE(t.count({0,0}, {1,1}) == 4);
+    REQUIRE(t.count({0,0}, {1,1}) == Evaluator::getValue(t, {5,5}));
+    REQUIRE(t.avg({0,0}, {1,1}) == Evaluator::getValue(t, {5,6}));
+    REQUIRE(t.min({0,0}, {1,1}) == Evaluator::getValue(t, {5,7}));
+
+    t.set({0,0}, "5");
+    REQUIRE(t.sum({0,0}, {1,1}) == 29.0);
+
+    // An existing cell with an empty expression fails like in a formula
+    t.set({0,1}, "");
+    REQUIRE_THROWS_WITH(t.count({0,0}, {1,1}), "Invalid primary expression");
+    REQUIRE_THROWS_WITH(Evaluator::recalculate(t), "Invalid primary expression");
+}
+
+TEST_CASE("Table dependency graph", "[table]") {
+    Table t;
+
+    t.set({0,0}, "1");
+    t.set({0,1}, "R0C0 + R0C0");
+    t.set({1,1}, "R[-1]C[0] * 2");
+
+    REQUIRE(t.getDependents({0,0}) == std::vector<Coordinates>{{0,1}});
+    REQUIRE(t.getDependents({0,1}) == std::vector<Coordinates>{{1,1}});
+    REQUIRE(t.getPrecedents({1,1}) == std::vector<Coordinates>{{0,1}});
+
+    t.set({0,1}, "5");
+    REQUIRE(t.getDependents({0,0}).empty());
+    REQUIRE(t.getDependents({0,1}) == std::vector<Coordinates>{{1,1}});
+}
+
+TEST_CASE("Table shares filled-down formulas", "[table]") {
+    Table t;
+    t.set({0,0}, "1");
+    for (int64_t row = 1; row < 100; ++row) {
+        t.set({row,0}, "R[-1]C[0]*2");
+    }
+
+    REQUIRE(t.getCells().getFormulas().size() == 2);
+    REQUIRE(&t.getProgram({1,0}) == &t.getProgram({99,0}));
+
+    t.set({50,0}, "R[-1]C[0]+1");
+    REQUIRE(t.getCells().getFormulas().size() == 3);
+    REQUIRE(t.get({50,0}) == "R[-1]C[0]+1");
+    REQUIRE(t.get({51,0}) == "R[-1]C[0]*2");
+
+    t.set({0,0}, "R[-1]C[0]*2");
+    t.set({0,0}, "5");
+    REQUIRE(t.getCells().getFormulas().size() == 3);
+}
+
+TEST_CASE("Table keeps dependents in the order they were added", "[table]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({1,0}, "R0C0 + 1");
+    t.set({2,0}, "R0C0 + 2");
+    t.set({3,0}, "R0C0 + 3");
+
+    REQUIRE(t.getDependents({0,0}) == std::vector<Coordinates>{{1,0}, {2,0}, {3,0}});
+
+    t.set({2,0}, "7");
+    REQUIRE(t.getDependents({0,0}) == std::vector<Coordinates>{{1,0}, {3,0}});
+
+    // The freed entry is reused by the next edge
+    t.set({4,0}, "R0C0 * 2");
+    REQUIRE(t.getDependents({0,0}) == std::vector<Coordinates>{{1,0}, {3,0}, {4,0}});
+}
+
+TEST_CASE("Table clear removes all cells", "[table]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({5,3}, "R0C0 + 1");
+    t.set({6,3}, "sum(R0C0:R5C3)");
+
+    t.clear();
+    REQUIRE(t.getCells().empty());
+    REQUIRE(t.getCells().getFormulas().size() == 0);
+    REQUIRE(t.getDirtyCells().empty());
+    REQUIRE(t.getDependents({0,0}).empty());
+    REQUIRE(t.getFocusedCoords() == Coordinates(0,0));
+    REQUIRE(t.findTableBounds() == std::pair<int64_t, int64_t>(0, 0));
+
+    // The table is usable again
+    t.set({1,1}, "2");
+    t.set({2,1}, "R[-1]C[0] * 3");
+    REQUIRE(t.getDependents({1,1}) == std::vector<Coordinates>{{2,1}});
+    REQUIRE(t.get({2,1}) == "R[-1]C[0] * 3");
+}
+
+TEST_CASE("Table setMany matches a sequence of sets", "[table]") {
+    const std::vector<Table::CellUpdate> updates = {
+        {{0,0}, "1"},
+        {{1,0}, "R[-1]C[0] + 1"},
+        {{2,0}, "sum(R0C0:R1C0)"},
+        {{0,1}, "R0C0 * 10"},
+        {{0,0}, "5"},
+        {{-1,-1}, "7"},
+    };
+
+    Table single;
+    for (const auto& [coords, expression] : updates) {
+        single.set(coords, expression);
+    }
+    Table batched;
+    batched.setMany(updates);
+
+    REQUIRE(batched.getFocusedCoords() == single.getFocusedCoords());
+    REQUIRE(batched.getFocusedCoords() == Coordinates(-1,-1));
+    for (const Coordinates& c : single.getCells()) {
+        REQUIRE(batched.get(c) == single.get(c));
+    }
+    REQUIRE(batched.getDependents({0,0}) == single.getDependents({0,0}));
+    REQUIRE(batched.getCells().size() == single.getCells().size());
+}
+
+TEST_CASE("Table setMany invalidates the union of affected cells", "[table]") {
+    Table t;
+    t.set({0,0}, "1");
+    t.set({0,1}, "2");
+    t.set({1,0}, "R0C0 + R0C1");
+    t.set({2,0}, "R[-1]C[0] * 2");
+    t.set({0,5}, "3");
+    t.set({1,5}, "R[-1]C[0]");
+    for (const Coordinates& c : t.getCells()) {
+        t.markEvaluated(c);
+    }
+    t.clearDirtyCells();
+
+    const std::vector<Table::CellUpdate> updates = {{{0,0}, "4"}, {{0,1}, "6"}};
+    t.setMany(updates);
+
+    // The shared dependents are reached once, unrelated cells keep their values
+    std::vector<Coordinates> dirty = t.getDirtyCells();
+    std::sort(dirty.begin(), dirty.end());
+    REQUIRE(dirty == std::vector<Coordinates>{{0,0}, {0,1}, {1,0}, {2,0}});
+    REQUIRE(t.isEvaluated({0,5}));
+    REQUIRE(t.isEvaluated({1,5}));
+    REQUIRE_FALSE(t.isEvaluated({2,0}));
+}
+
+TEST_CASE("Table setMany reaches aggregates of many changed cells", "[table]") {
+    Table t;
+    for (int64_t row = 0; row < 100; ++row) {
+        t.set({row,0}, "1");
+    }
+    // One sum per block of ten rows, a column apart, and a sum over the sums
+    for (int64_t block = 0; block < 10; ++block) {
+        t.set({block,2}, "sum(R" + std::to_string(block * 10) + "C0:R" + std::to_string(block * 10 + 9) + "C0)");
+    }
+    t.set({0,4}, "sum(R0C2:R9C2)");
+    t.set({0,5}, "sum(R0C3:R9C3)");
+    for (const Coordinates& c : t.getCells()) {
+        t.markEvaluated(c);
+    }
+    t.clearDirtyCells();
+
+    // Rows 20 to 49 lie in blocks 2, 3 and 4
+    std::vector<Table::CellUpdate> updates;
+    for (int64_t row = 20; row < 50; ++row) {
+        updates.push_back({{row,0}, "2"});
+    }
+    t.setMany(updates);
+
+    for (int64_t block = 0; block < 10; ++block) {
+        REQUIRE(t.isEvaluated({block,2}) == (block < 2 || block > 4));
+    }
+    REQUIRE_FALSE(t.isEvaluated({0,4}));
+    REQUIRE(t.isEvaluated({0,5}));
+    REQUIRE(t.isEvaluated({19,0}));
+    REQUIRE(t.getDirtyCells().size() == 30 + 3 + 1);
+}
+
+TEST_CASE("Table batches defer writes until commit", "[table]") {
+    Table t;
+    t.set({0, 0}, "1");
+    t.set({1, 0}, "R0C0 + 1");
+
+    t.beginBatch();
+    REQUIRE(t.inBatch());
+    REQUIRE_THROWS_AS(t.beginBatch(), std::runtime_error);
+
+    t.set({0, 0}, "5");
+    t.insert({2, 0}, "R1C0 * 2");
+    REQUIRE(t.get({0, 0}) == "1");
+    REQUIRE_FALSE(t.hasCell({2, 0}));
+
+    t.commitBatch();
+    REQUIRE_FALSE(t.inBatch());
+    REQUIRE(t.get({0, 0}) == "5");
+    REQUIRE(t.get({2, 0}) == "R1C0 * 2");
+    REQUIRE_THROWS_AS(t.commitBatch(), std::runtime_error);
+
+    // Aborting and clearing discard the recorded writes
+    t.beginBatch();
+    t.set({0, 0}, "7");
+    t.abortBatch();
+    REQUIRE_FALSE(t.inBatch());
+    REQUIRE(t.get({0, 0}) == "5");
+    REQUIRE_NOTHROW(t.abortBatch());
+
+    t.beginBatch();
+    t.set({3, 0}, "1");
+    t.clear();
+    REQUIRE_FALSE(t.inBatch());
+    t.set({3, 0}, "2");
+    REQUIRE(t.get({3, 0}) == "2");
+}
@@ -0,0 +1,53 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/ThreadPool.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Parallel loop visits every index once", "[pool]") {
+    ThreadPool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    for (size_t count : {0, 1, 7, 1000, 100000}) {
+        std::vector<std::atomic<int>> visits(count);
+        pool.parallelFor(count, 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                ++visits[i];
+            }
+        });
+
+        size_t visitedOnce = 0;
+        for (size_t i = 0; i < count; ++i) {
+            visitedOnce += (visits[i] == 1) ? 1 : 0;
+        }
+        REQUIRE(visitedOnce == count);
+    }
+}
+
+TEST_CASE("Single-threaded pool runs on the caller", "[pool]") {
+    ThreadPool pool(1);
+    size_t sum = 0;
+    pool.parallelFor(100, 8, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            sum += i;
+        }
+    });
+    REQUIRE(sum == 4950);
+}
+
+TEST_CASE("Pool of the calling thread is reused", "[pool]") {
+    ThreadPool& first = ThreadPool::forCurrentThread(3);
+    REQUIRE(first.size() == 3);
+    REQUIRE(&ThreadPool::forCurrentThread(3) == &first);
+    REQUIRE(ThreadPool::forCurrentThread(2).size() == 2);
+    REQUIRE(ThreadPool::forCurrentThread(0).size() == 1);
+
+    // Another thread gets a pool of its own
+    const ThreadPool* own = &ThreadPool::forCurrentThread(1);
+    bool shared = true;
+    std::thread([&] { shared = &ThreadPool::forCurrentThread(1) == own; }).join();
+    REQUIRE_FALSE(shared);
+}
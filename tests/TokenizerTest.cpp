@@ -3,6 +3,8 @@
 //
 #include <catch2/catch_test_macros.hpp>
 #include "../src/Tokenizer.h"
+#include <stdexcept>
+#include <string>
 
 TEST_CASE("Tokenizer numbers", "[tokenizer]") {
     Tokenizer t("123 45");
@@ -80,4 +82,64 @@ TEST_CASE("Tokenizer operators", "[tokenizer]") {
     tok = t.next(); REQUIRE(tok.type == TokenType::Less);
     tok = t.next(); REQUIRE(tok.type == TokenType::Greater);
     tok = t.next(); REQUIRE(tok.type == TokenType::End);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Tokenizer areas", "[tokenizer]") {
+    Tokenizer t("sum(R0C0:R[2]C[-1])");
+
+    REQUIRE(t.next().type == TokenType::Identifier);
+    REQUIRE(t.next().type == TokenType::LParen);
+    REQUIRE(t.next().type == TokenType::CellRef);
+    REQUIRE(t.next().type == TokenType::Colon);
+
+    Token tok = t.next();
+    REQUIRE(tok.type == TokenType::CellRef);
+    REQUIRE(tok.lexeme == "R[2]C[-1]");
+
+    REQUIRE(t.next().type == TokenType::RParen);
+    REQUIRE(t.next().type == TokenType::End);
+}
+TEST_CASE("Tokenizer lexemes refer to the input", "[tokenizer]") {
+    const std::string expression = "sum(R0C0:R[2]C[-1]) + 15";
+    Tokenizer t(expression);
+
+    for (Token tok = t.next(); tok.type != TokenType::End; tok = t.next()) {
+        REQUIRE(tok.lexeme.data() >= expression.data());
+        REQUIRE(tok.lexeme.data() + tok.lexeme.size() <= expression.data() + expression.size());
+    }
+}
+
+TEST_CASE("Tokenizer rejects references cut short", "[tokenizer]") {
+    REQUIRE_THROWS_AS(Tokenizer("R1C").next(), std::runtime_error);
+    REQUIRE_THROWS_AS(Tokenizer("R").next(), std::runtime_error);
+    REQUIRE_THROWS_AS(Tokenizer("R[1]C[").next(), std::runtime_error);
+    REQUIRE_THROWS_AS(Tokenizer("R[]C0").next(), std::runtime_error);
+    REQUIRE_THROWS_AS(Tokenizer("R[-]C0").next(), std::runtime_error);
+    REQUIRE_THROWS_AS(Tokenizer("R99999999999999999999C0").next(), std::runtime_error);
+}
+
+TEST_CASE("Tokenizer decodes numbers and references", "[tokenizer]") {
+    Tokenizer t("1234 R5C3 R[-12]C[0] R[7]C42");
+
+    Token tok = t.next();
+    REQUIRE(tok.type == TokenType::Number);
+    REQUIRE(tok.number == 1234.0);
+
+    tok = t.next();
+    REQUIRE(tok.reference.row == 5);
+    REQUIRE(tok.reference.col == 3);
+    REQUIRE_FALSE(tok.reference.rowRelative);
+    REQUIRE_FALSE(tok.reference.colRelative);
+
+    tok = t.next();
+    REQUIRE(tok.reference.row == -12);
+    REQUIRE(tok.reference.col == 0);
+    REQUIRE(tok.reference.rowRelative);
+    REQUIRE(tok.reference.colRelative);
+
+    tok = t.next();
+    REQUIRE(tok.reference.row == 7);
+    REQUIRE(tok.reference.col == 42);
+    REQUIRE(tok.reference.rowRelative);
+    REQUIRE_FALSE(tok.reference.colRelative);
+}
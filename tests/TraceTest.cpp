@@ -0,0 +1,88 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/CmdInterpreter.h"
+#include "../src/Evaluator.h"
+#include "../src/Table.h"
+#include "../src/Trace.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    std::string read(const std::string& name) {
+        std::ifstream in(name, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    bool hasSpan(const std::string& trace, const std::string& name) {
+        return trace.find("{\"name\":\"" + name + "\",") != std::string::npos;
+    }
+}
+
+TEST_CASE("Trace records the phases of commands", "[trace]") {
+    std::string csv = "test_trace.csv";
+    std::string traceFile = "test_trace.json";
+    {
+        std::ofstream out(csv);
+        out << "1;R[0]C[-1] + 1\n2;sum(R0C0:R[0]C[-1])\n";
+    }
+
+    REQUIRE_FALSE(Trace::isEnabled());
+    Table t;
+    CmdInterpreter::load(csv, t);
+
+    CmdInterpreter::startTrace(traceFile);
+    REQUIRE(Trace::isEnabled());
+
+    Table traced;
+    CmdInterpreter::load(csv, traced);
+    traced.set({2,0}, "5");
+    Evaluator::recalculate(traced);
+
+    std::ostringstream captured;
+    std::streambuf* original = std::cout.rdbuf(captured.rdbuf());
+    CmdInterpreter::printAllValues(traced);
+    std::cout.rdbuf(original);
+
+    CmdInterpreter::stopTrace();
+    REQUIRE_FALSE(Trace::isEnabled());
+
+    const std::string trace = read(traceFile);
+    REQUIRE(trace.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0) == 0);
+    REQUIRE(trace.substr(trace.size() - 4) == "\n]}\n");
+    REQUIRE(hasSpan(trace, "load"));
+    REQUIRE(hasSpan(trace, "parse and insert"));
+    REQUIRE(hasSpan(trace, "build dependencies"));
+    REQUIRE(hasSpan(trace, "recalculate"));
+    REQUIRE(hasSpan(trace, "print values"));
+    REQUIRE(trace.find("\"ph\":\"X\"") != std::string::npos);
+    REQUIRE_FALSE(hasSpan(trace, "save"));
+
+    // Nothing is recorded while tracing is off, and stopping again writes nothing
+    std::remove(traceFile.c_str());
+    CmdInterpreter::save(csv, traced);
+    CmdInterpreter::stopTrace();
+    REQUIRE_FALSE(std::ifstream(traceFile).is_open());
+
+    std::remove(csv.c_str());
+}
+
+TEST_CASE("Spans started before tracing are not recorded", "[trace]") {
+    std::string traceFile = "test_trace.json";
+    {
+        Trace::Span early("early", "test");
+        Trace::start(traceFile);
+        Trace::Span late("late", "test");
+        late.end();
+    }
+    Trace::stop();
+
+    const std::string trace = read(traceFile);
+    REQUIRE(hasSpan(trace, "late"));
+    REQUIRE_FALSE(hasSpan(trace, "early"));
+
+    std::remove(traceFile.c_str());
+}
@@ -0,0 +1,93 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+#include <catch2/catch_test_macros.hpp>
+#include "../src/VectorKernels.h"
+#include "SimdTestUtils.h"
+#include <cmath>
+#include <vector>
+
+TEST_CASE("Vector kernels match scalar arithmetic", "[kernels]") {
+    // Odd length, so both the vector body and the scalar tail are used
+    const size_t n = 11;
+    std::vector<double> a(n);
+    std::vector<double> b(n);
+    for (size_t i = 0; i < n; ++i) {
+        a[i] = static_cast<double>(i) * 1.5 - 4.0;
+        b[i] = static_cast<double>(n - i) * 0.75;
+    }
+
+    auto check = [&](void (*kernel)(double*, const double*, size_t), auto scalar) {
+        std::vector<double> out = a;
+        kernel(out.data(), b.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE(out[i] == scalar(a[i], b[i]));
+        }
+    };
+
+    forEachLevel([&] {
+        check(VectorKernels::add, [](double x, double y) { return x + y; });
+        check(VectorKernels::sub, [](double x, double y) { return x - y; });
+        check(VectorKernels::mul, [](double x, double y) { return x * y; });
+        check(VectorKernels::div, [](double x, double y) { return x / y; });
+        check(VectorKernels::mod, [](double x, double y) { return std::fmod(x, y); });
+        check(VectorKernels::equal, [](double x, double y) { return x == y ? 1.0 : 0.0; });
+        check(VectorKernels::notEqual, [](double x, double y) { return x != y ? 1.0 : 0.0; });
+        check(VectorKernels::less, [](double x, double y) { return x < y ? 1.0 : 0.0; });
+        check(VectorKernels::greater, [](double x, double y) { return x > y ? 1.0 : 0.0; });
+    });
+}
+
+TEST_CASE("Vector kernels match scalar unary operations", "[kernels]") {
+    std::vector<double> values = {-2.0, -0.5, 0.0, 0.5, 0.999, 1.0, 1.5, 3.0, NAN};
+
+    forEachLevel([&] {
+        std::vector<double> negated = values;
+        VectorKernels::negate(negated.data(), negated.size());
+        std::vector<double> inverted = values;
+        VectorKernels::logicalNot(inverted.data(), inverted.size());
+        std::vector<double> booleans = values;
+        VectorKernels::toBool(booleans.data(), booleans.size());
+
+        for (size_t i = 0; i + 1 < values.size(); ++i) {
+            REQUIRE(negated[i] == -values[i]);
+            REQUIRE(inverted[i] == (values[i] < 1.0 ? 1.0 : 0.0));
+            REQUIRE(booleans[i] == (values[i] >= 1.0 ? 1.0 : 0.0));
+        }
+        REQUIRE(std::isnan(negated.back()));
+        REQUIRE(inverted.back() == 0.0);
+        REQUIRE(booleans.back() == 0.0);
+    });
+}
+
+TEST_CASE("Vector kernels detect zero divisors", "[kernels]") {
+    forEachLevel([] {
+        std::vector<double> values(9, 2.0);
+        REQUIRE_FALSE(VectorKernels::hasZero(values.data(), values.size()));
+
+        // A zero in the vector body and one in the scalar tail
+        values[5] = 0.0;
+        REQUIRE(VectorKernels::hasZero(values.data(), values.size()));
+        values[5] = 2.0;
+        values[8] = -0.0;
+        REQUIRE(VectorKernels::hasZero(values.data(), values.size()));
+        REQUIRE_FALSE(VectorKernels::hasZero(values.data(), 8));
+
+        std::vector<double> filled(5);
+        VectorKernels::fill(filled.data(), 7.0, filled.size());
+        REQUIRE(filled == std::vector<double>(5, 7.0));
+        REQUIRE(VectorKernels::width() >= 1);
+    });
+}
+
+TEST_CASE("Vector kernels follow the selected level", "[kernels]") {
+    const SimdLevel original = Simd::level();
+    Simd::setLevel(SimdLevel::Baseline);
+    REQUIRE(VectorKernels::width() <= 2);
+
+    if (Simd::supports(SimdLevel::AVX2)) {
+        Simd::setLevel(SimdLevel::AVX2);
+        REQUIRE((VectorKernels::width() == 4 || VectorKernels::width() <= 2));
+    }
+    Simd::setLevel(original);
+}
@@ -0,0 +1,75 @@
+//
+// Created by Petya Licheva on 10/17/2026.
+//
+// Writes a synthetic sheet for CmdInterpreter::load() (see SheetGenerator).
+//
+// Usage: generator [options] [output.csv]
+//
+//   --rows N          number of rows (default 1000)
+//   --cols N          number of columns (default 10)
+//   --density P       probability that a cell is occupied (default 1)
+//   --formulas P      probability that an occupied cell holds a formula (default 0.5)
+//   --shape S         chain, tree, diamond, dag or if (default chain)
+//   --absolute        write absolute references instead of relative ones
+//   --if-depth N      nesting depth of `if` formulas (default 3)
+//   --seed N          seed of the random numbers (default 1)
+//
+// Without an output file the sheet is written to standard output.
+//
+
+#include "SheetGenerator.h"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    SheetGenerator::Options options;
+    std::string output;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--rows") {
+                options.rows = std::stoll(value());
+            } else if (arg == "--cols") {
+                options.cols = std::stoll(value());
+            } else if (arg == "--density") {
+                options.density = std::stod(value());
+            } else if (arg == "--formulas") {
+                options.formulaRatio = std::stod(value());
+            } else if (arg == "--shape") {
+                options.shape = SheetGenerator::parseShape(value());
+            } else if (arg == "--absolute") {
+                options.relativeReferences = false;
+            } else if (arg == "--if-depth") {
+                options.ifDepth = std::stoi(value());
+            } else if (arg == "--seed") {
+                options.seed = std::stoull(value());
+            } else if (!arg.empty() && arg[0] != '-' && output.empty()) {
+                output = arg;
+            } else {
+                throw std::runtime_error("Unknown argument: " + arg);
+            }
+        }
+
+        if (output.empty()) {
+            SheetGenerator::write(std::cout, options);
+        } else {
+            SheetGenerator::save(output, options);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "generator: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}